@@ -0,0 +1,160 @@
+// Measures frustum culling of bounding spheres and boxes with one Frustum::intersects() call per object
+// and with CullingKernel using every instruction set supported by the processor.
+//
+// Doesn't need OpenGL, build it together with culling sources only, e.g.:
+//   g++ -std=c++17 -O2 -I include benchmarks/CullingBenchmark.cpp src/CullingKernel.cpp src/Frustum.cpp
+
+#include <CullingKernel.h>
+#include <Frustum.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Objects are scattered in a cube around camera, so roughly a tenth of them is visible
+    const float SCENE_SIZE = 500.0f;
+
+    struct Scene
+    {
+        vector<glm::vec4> spheres;
+        vector<glm::vec3> boxMins;
+        vector<glm::vec3> boxMaxs;
+        SphereArray sphereArray;
+        BoxArray boxArray;
+    };
+
+    Scene generateScene(size_t objectsNumber)
+    {
+        mt19937 random(42);
+        uniform_real_distribution<float> position(-SCENE_SIZE, SCENE_SIZE);
+        uniform_real_distribution<float> radius(0.5f, 5.0f);
+
+        Scene scene;
+        for (size_t i = 0; i < objectsNumber; ++i)
+        {
+            glm::vec4 sphere(position(random), position(random), position(random), radius(random));
+            glm::vec3 center(sphere);
+            scene.spheres.push_back(sphere);
+            scene.sphereArray.push_back(sphere);
+            scene.boxMins.push_back(center - sphere.w);
+            scene.boxMaxs.push_back(center + sphere.w);
+            scene.boxArray.push_back(center - sphere.w, center + sphere.w);
+        }
+        return scene;
+    }
+
+    // Returns the best time of several runs in milliseconds, function returns number of visible objects
+    template<typename Function>
+    double measure(Function function, size_t& visible)
+    {
+        const int RUNS = 10;
+        double best = 0;
+        for (int i = 0; i < RUNS; ++i)
+        {
+            auto start = chrono::steady_clock::now();
+            visible = function();
+            auto finish = chrono::steady_clock::now();
+
+            double time = chrono::duration<double, milli>(finish - start).count();
+            best = i == 0 ? time : min(best, time);
+        }
+        return best;
+    }
+
+    void printRow(const char* bounds, const char* method, size_t objects, double time, size_t visible, double baseline)
+    {
+        cout << fixed << setprecision(3)
+             << setw(10) << objects << setw(9) << bounds << setw(18) << method
+             << setw(12) << time << setw(14) << objects / (time * 1000.0)
+             << setw(10) << visible << setw(10) << setprecision(2) << baseline / time << endl;
+    }
+}
+
+int main()
+{
+    const size_t SIZES[] = { 10000, 100000, 1000000 };
+    const CullingKernel::InstructionSet SETS[] = { CullingKernel::SCALAR, CullingKernel::SSE, CullingKernel::AVX2 };
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    CullingKernel::InstructionSet supported = CullingKernel::getSupportedInstructionSet();
+    cout << "supported instruction set: " << CullingKernel::getName(supported) << endl;
+    cout << setw(10) << "objects" << setw(9) << "bounds" << setw(18) << "method"
+         << setw(12) << "time, ms" << setw(14) << "objects/us" << setw(10) << "visible" << setw(10) << "speedup" << endl;
+
+    for (size_t objects : SIZES)
+    {
+        Scene scene = generateScene(objects);
+        vector<unsigned int> visibleIndices;
+        vector<unsigned int> expected;
+        size_t visible = 0;
+
+        // spheres
+        double baseline = measure([&]()
+        {
+            expected.clear();
+            for (size_t i = 0; i < scene.spheres.size(); ++i)
+            {
+                if (frustum.intersects(scene.spheres[i]))
+                    expected.push_back(static_cast<unsigned int>(i));
+            }
+            return expected.size();
+        }, visible);
+        printRow("spheres", "Frustum", objects, baseline, visible, baseline);
+
+        for (CullingKernel::InstructionSet set : SETS)
+        {
+            if (set > supported)
+                continue;
+            CullingKernel::setInstructionSet(set);
+            double time = measure([&]()
+            {
+                CullingKernel::cullSpheres(frustum, scene.sphereArray, visibleIndices);
+                return visibleIndices.size();
+            }, visible);
+            if (visibleIndices != expected)
+                cout << "ERROR::BENCHMARK::WRONG_VISIBLE_OBJECTS " << CullingKernel::getName(set) << endl;
+            printRow("spheres", CullingKernel::getName(set), objects, time, visible, baseline);
+        }
+
+        // boxes
+        baseline = measure([&]()
+        {
+            expected.clear();
+            for (size_t i = 0; i < scene.boxMins.size(); ++i)
+            {
+                if (frustum.intersects(scene.boxMins[i], scene.boxMaxs[i]))
+                    expected.push_back(static_cast<unsigned int>(i));
+            }
+            return expected.size();
+        }, visible);
+        printRow("boxes", "Frustum", objects, baseline, visible, baseline);
+
+        for (CullingKernel::InstructionSet set : SETS)
+        {
+            if (set > supported)
+                continue;
+            CullingKernel::setInstructionSet(set);
+            double time = measure([&]()
+            {
+                CullingKernel::cullBoxes(frustum, scene.boxArray, visibleIndices);
+                return visibleIndices.size();
+            }, visible);
+            if (visibleIndices != expected)
+                cout << "ERROR::BENCHMARK::WRONG_VISIBLE_OBJECTS " << CullingKernel::getName(set) << endl;
+            printRow("boxes", CullingKernel::getName(set), objects, time, visible, baseline);
+        }
+    }
+    return 0;
+}
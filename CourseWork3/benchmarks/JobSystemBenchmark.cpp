@@ -0,0 +1,179 @@
+// Measures how transform updates and frustum culling of many objects scale with JobSystem from one thread
+// to all cores. Work is split with JobSystem::parallelFor() the same way ObjectStore and the render loop do it.
+// Maximal number of threads may be given as the first argument, by default it is the number of cores.
+//
+// Doesn't need OpenGL, build it together with job system and culling sources only, e.g.:
+//   g++ -std=c++17 -O2 -pthread -I include benchmarks/JobSystemBenchmark.cpp src/JobSystem.cpp src/CullingKernel.cpp src/Frustum.cpp
+
+#include <CullingKernel.h>
+#include <Frustum.h>
+#include <JobSystem.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    const size_t OBJECTS_NUMBER = 1000000;
+    const float SCENE_SIZE = 500.0f;
+
+    // The same grains as ObjectStore::updateTransforms() and BoundingVolumeHierarchy leaves use
+    const size_t TRANSFORMS_PER_JOB = 256;
+    const size_t SPHERES_PER_JOB = 1024;
+
+    struct Scene
+    {
+        vector<glm::vec3> positions;
+        vector<glm::vec3> rotations;
+        vector<glm::vec3> scales;
+        vector<glm::mat4> modelMatrices;
+        SphereArray spheres;
+    };
+
+    Scene generateScene(size_t objectsNumber)
+    {
+        mt19937 random(42);
+        uniform_real_distribution<float> position(-SCENE_SIZE, SCENE_SIZE);
+        uniform_real_distribution<float> angle(0.0f, 360.0f);
+        uniform_real_distribution<float> scale(0.5f, 5.0f);
+
+        Scene scene;
+        for (size_t i = 0; i < objectsNumber; ++i)
+        {
+            scene.positions.emplace_back(position(random), position(random), position(random));
+            scene.rotations.emplace_back(angle(random), angle(random), angle(random));
+            scene.scales.emplace_back(scale(random));
+        }
+        scene.modelMatrices.resize(objectsNumber);
+        scene.spheres.resize(objectsNumber);
+        return scene;
+    }
+
+    // Model matrix and bounding sphere of a unit model, as ObjectStore computes them
+    void updateTransforms(Scene& scene, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const glm::vec3& rotation = scene.rotations[i];
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), scene.positions[i]);
+            glm::quat quaternion(glm::vec3(glm::radians(rotation.x), glm::radians(rotation.y), glm::radians(rotation.z)));
+            model = model * glm::toMat4(quaternion);
+            model = glm::scale(model, scene.scales[i]);
+            scene.modelMatrices[i] = model;
+
+            const glm::vec3& scale = scene.scales[i];
+            float maxScale = max(abs(scale.x), max(abs(scale.y), abs(scale.z)));
+            scene.spheres.set(i, glm::vec4(glm::vec3(model[3]), maxScale));
+        }
+    }
+
+    // Returns the best time of several runs in milliseconds
+    template<typename Function>
+    double measure(Function function)
+    {
+        const int RUNS = 10;
+        double best = 0;
+        for (int i = 0; i < RUNS; ++i)
+        {
+            auto start = chrono::steady_clock::now();
+            function();
+            auto finish = chrono::steady_clock::now();
+
+            double time = chrono::duration<double, milli>(finish - start).count();
+            best = i == 0 ? time : min(best, time);
+        }
+        return best;
+    }
+
+    void printRow(unsigned int threads, double time, double baseline)
+    {
+        double speedup = baseline / time;
+        cout << fixed << setprecision(3) << setw(12) << time
+             << setw(10) << setprecision(2) << speedup << setw(12) << speedup / threads * 100.0 << "%";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    unsigned int maxThreads = max(thread::hardware_concurrency(), 1u);
+    if (argc > 1)
+        maxThreads = max(atoi(argv[1]), 1);
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    Scene scene = generateScene(OBJECTS_NUMBER);
+    vector<unsigned int> visibleIndices(OBJECTS_NUMBER);
+    size_t expected = 0;
+
+    cout << "objects: " << OBJECTS_NUMBER << ", culling instruction set: "
+         << CullingKernel::getName(CullingKernel::getInstructionSet()) << endl;
+    cout << setw(8) << "threads"
+         << setw(12) << "update, ms" << setw(10) << "speedup" << setw(13) << "efficiency"
+         << setw(12) << "culling, ms" << setw(10) << "speedup" << setw(13) << "efficiency"
+         << setw(10) << "jobs" << setw(10) << "stolen" << endl;
+
+    double updateBaseline = 0;
+    double cullingBaseline = 0;
+    for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+    {
+        // the calling thread is one of them
+        JobSystem::start(threads - 1);
+
+        double updateTime = measure([&]()
+        {
+            JobSystem::parallelFor(OBJECTS_NUMBER, TRANSFORMS_PER_JOB,
+                                   [&scene](size_t begin, size_t end) { updateTransforms(scene, begin, end); });
+        });
+
+        // every range writes visible indices into its own part of the buffer
+        size_t visible = 0;
+        double cullingTime = measure([&]()
+        {
+            vector<size_t> counts((OBJECTS_NUMBER + SPHERES_PER_JOB - 1) / SPHERES_PER_JOB);
+            JobSystem::parallelFor(counts.size(), 1, [&](size_t begin, size_t end)
+            {
+                for (size_t range = begin; range < end; ++range)
+                {
+                    size_t first = range * SPHERES_PER_JOB;
+                    size_t count = min(SPHERES_PER_JOB, OBJECTS_NUMBER - first);
+                    counts[range] = CullingKernel::cullSpheres(frustum, scene.spheres, first, count, visibleIndices.data() + first);
+                }
+            });
+            visible = 0;
+            for (size_t count : counts)
+                visible += count;
+        });
+
+        if (threads == 1)
+        {
+            updateBaseline = updateTime;
+            cullingBaseline = cullingTime;
+            expected = visible;
+        }
+        else if (visible != expected)
+            cout << "ERROR::BENCHMARK::WRONG_VISIBLE_OBJECTS threads: " << threads << endl;
+
+        JobSystem::Statistics statistics = JobSystem::getStatistics();
+        cout << setw(8) << threads;
+        printRow(threads, updateTime, updateBaseline);
+        printRow(threads, cullingTime, cullingBaseline);
+        cout << setw(10) << statistics.executed << setw(10) << statistics.stolen << endl;
+    }
+    JobSystem::stop();
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Measures SceneParser on synthetic ModelData files of increasing size and compares it
+// with the previous stringstream based loading.
+//
+// Doesn't need OpenGL, build it together with parser sources only, e.g.:
+//   g++ -std=c++17 -O2 -I include benchmarks/SceneParserBenchmark.cpp src/SceneParser.cpp
+//       src/MappedFile.cpp src/Lights/PointLight.cpp src/Lights/SpotLight.cpp
+
+#include <SceneParser.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // Writes file with given number of object placements referencing a handful of models
+    void generateObjectsFile(const string& path, size_t objectsNumber)
+    {
+        const char* models[] = {
+            "models/rusty_ball/ball.obj",
+            "models/floor_ball/ball.obj",
+            "models/spaced_tiles_ball/ball.obj",
+            "models/plastic_ball/ball.obj",
+            "models/glass_ball/ball.obj",
+            "models/titanium_ball/ball.obj"
+        };
+        mt19937 random(42);
+        uniform_real_distribution<float> position(-999.0f, 999.0f);
+        uniform_real_distribution<float> angle(0.0f, 360.0f);
+        uniform_real_distribution<float> scale(0.1f, 4.0f);
+
+        ofstream file(path);
+        for (size_t i = 0; i < objectsNumber; ++i)
+        {
+            file << position(random) << ' ' << position(random) << ' ' << position(random) << '\n'
+                 << angle(random) << '\t' << angle(random) << '\t' << angle(random) << '\n'
+                 << scale(random) << ' ' << scale(random) << ' ' << scale(random) << '\n'
+                 << models[i % size(models)] << '\n';
+        }
+    }
+
+    // The way SceneLoader read ModelData.txt before SceneParser was introduced
+    size_t parseWithStringStream(const string& path)
+    {
+        ifstream file(path);
+        stringstream data;
+        data << file.rdbuf();
+
+        auto getVec3 = [](stringstream& data)
+        {
+            glm::vec3 vec3;
+            data >> vec3.x >> vec3.y >> vec3.z;
+            string str;//dummy
+            getline(data, str);
+            return vec3;
+        };
+
+        vector<glm::vec3> positions, rotations, scales;
+        vector<string> paths;
+        while (data.peek() != EOF)
+        {
+            positions.push_back(getVec3(data));
+            rotations.push_back(getVec3(data));
+            scales.push_back(getVec3(data));
+            string modelPath;
+            getline(data, modelPath);
+            paths.push_back(modelPath);
+        }
+        return paths.size();
+    }
+
+    size_t parseWithSceneParser(const string& path)
+    {
+        SceneDescription scene;
+        SceneParser::parseObjectsFile(path, scene);
+        return scene.objects.size();
+    }
+
+    template<typename Function>
+    double measure(Function function, const string& path, size_t expectedObjects)
+    {
+        // the best of several runs hides warm up of file cache
+        const int RUNS = 3;
+        double best = 0;
+        for (int i = 0; i < RUNS; ++i)
+        {
+            auto start = chrono::steady_clock::now();
+            size_t objects = function(path);
+            auto finish = chrono::steady_clock::now();
+            if (objects != expectedObjects)
+                cout << "ERROR::BENCHMARK::WRONG_OBJECTS_NUMBER expected: " << expectedObjects << ", got: " << objects << endl;
+
+            double time = chrono::duration<double, milli>(finish - start).count();
+            best = i == 0 ? time : min(best, time);
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    const size_t SIZES[] = { 1000, 10000, 100000, 1000000 };
+    string path = (filesystem::temp_directory_path() / "SceneParserBenchmark.txt").string();
+
+    cout << setw(10) << "objects" << setw(12) << "file, MB"
+         << setw(18) << "stringstream, ms" << setw(18) << "SceneParser, ms"
+         << setw(12) << "MB/s" << setw(10) << "speedup" << endl;
+
+    for (size_t objects : SIZES)
+    {
+        generateObjectsFile(path, objects);
+        double megabytes = filesystem::file_size(path) / (1024.0 * 1024.0);
+
+        double legacy = measure(parseWithStringStream, path, objects);
+        double parser = measure(parseWithSceneParser, path, objects);
+
+        cout << fixed << setprecision(2)
+             << setw(10) << objects << setw(12) << megabytes
+             << setw(18) << legacy << setw(18) << parser
+             << setw(12) << megabytes / (parser / 1000.0) << setw(10) << legacy / parser << endl;
+    }
+
+    filesystem::remove(path);
+    return 0;
+}
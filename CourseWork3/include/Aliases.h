@@ -2,7 +2,7 @@
 #include <Lights/SpotLight.h>
 #include <Lights/DirectionalLight.h>
 #include <Objects/Model.h>
-#include <Objects/Object.h>
+#include <Objects/ObjectStore.h>
 
 #include <vector>
 #include <memory>
@@ -10,5 +10,5 @@
 using DirectionalLights = vector<DirectionalLight>;
 using PointLights = vector<PointLight>;
 using SpotLights = vector<SpotLight>;
-using Objects = vector<Object>;
+using Objects = ObjectStore;
 using Models = vector<std::shared_ptr<Model>>;
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef ASSET_REGISTRY_H
+#define ASSET_REGISTRY_H
+
+#include <Objects/Model.h>
+
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Information recorded for every asset at the moment it was loaded
+struct AssetInfo
+{
+    std::string path;           // normalized full path to the asset file
+    ModelImportOptions options;
+    double loadTime = 0;        // milliseconds
+    std::size_t memory = 0;     // bytes of geometry and textures
+};
+
+// Holds all loaded models, so each file imported with the same options is loaded only once.
+// Assets are looked up by normalized full path and import options in constant time.
+class AssetRegistry
+{
+public:
+    AssetRegistry() = default;
+
+    // Returns shared handle to the model, loading it on first request
+    std::shared_ptr<Model> getModel(const std::string& path, const ModelImportOptions& options = ModelImportOptions());
+
+    // Imports models which aren't loaded yet at the same time with JobSystem, then creates their GL resources
+    // on this thread. getModel() returns them without loading afterwards.
+    void preload(const std::vector<std::pair<std::string, ModelImportOptions>>& requests);
+
+    // Returns information about loaded asset or nullptr if it wasn't loaded yet
+    const AssetInfo* getInfo(const std::string& path, const ModelImportOptions& options = ModelImportOptions()) const;
+
+    std::size_t size() const { return _assets.size(); }
+
+    // Releases models which are referenced only by the registry, returns number of released models
+    std::size_t unloadUnused();
+
+    // Prints load time and memory of every loaded asset
+    void printStatistics(std::ostream& out = std::cout) const;
+
+    // Returns absolute path with resolved "." and ".." parts and '/' as separator
+    static std::string normalizePath(const std::string& path);
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Model> model;
+        AssetInfo info;
+    };
+
+    static std::string makeKey(const std::string& normalizedPath, const ModelImportOptions& options);
+
+    const std::shared_ptr<Model>& add(const std::string& key, const std::string& normalizedPath, const ModelImportOptions& options,
+                                      std::shared_ptr<Model> model, double loadTime);
+
+private:
+    std::unordered_map<std::string, Entry> _assets;
+};
+
+#endif // !ASSET_REGISTRY_H
@@ -0,0 +1,86 @@
+#ifndef BOUNDING_VOLUME_HIERARCHY_H
+#define BOUNDING_VOLUME_HIERARCHY_H
+
+#include <CullingKernel.h>
+#include <Frustum.h>
+#include <Objects/ObjectStore.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Tree of axis-aligned boxes over world bounding spheres of objects, so culling, overlap tests and picking
+// visit a logarithmic number of nodes instead of all objects.
+//
+// Tree is built top-down with binned surface area heuristic. When an object moves only its leaf and ancestors
+// are refitted, quality of the tree slowly degrades, so it should be rebuilt after many objects are changed.
+// Queries append indices of objects in the vector given to build().
+class BoundingVolumeHierarchy
+{
+public:
+    struct RayHit
+    {
+        std::size_t object;
+        float distance; // along the ray to bounding sphere of the object
+    };
+
+    void build(const ObjectStore& objects);
+
+    void clear();
+
+    // Refits tree after object was moved, rotated or scaled
+    void update(std::size_t object, const glm::vec4& sphere);
+
+    // Refits bounds of all nodes, cheaper than rebuild when structure of the scene stays the same
+    void refit(const ObjectStore& objects);
+
+    // Objects with bounding spheres intersecting frustum.
+    // Whole subtrees inside it are appended without testing their objects, others are tested with CullingKernel.
+    // Large trees are split into subtrees queried by jobs of JobSystem.
+    void queryFrustum(const Frustum& frustum, std::vector<std::size_t>& result) const;
+
+    // Objects with bounding spheres intersecting sphere given as center in xyz and radius in w
+    void querySphere(const glm::vec4& sphere, std::vector<std::size_t>& result) const;
+
+    // Objects with bounding spheres intersecting axis-aligned box
+    void queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, std::vector<std::size_t>& result) const;
+
+    // Finds the closest object hit by the ray not farther than maxDistance, direction must be normalized
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+
+    std::size_t getObjectsNumber() const { return spheres.size(); }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    struct Node
+    {
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        unsigned int left;   // index of the first child, the second one follows it; 0 for leaves
+        unsigned int first;  // range of items in the subtree
+        unsigned int count;
+        unsigned int parent;
+    };
+
+    void buildNode(unsigned int node, unsigned int parent, unsigned int first, unsigned int count, unsigned int level);
+
+    // Recalculates node bounds from its items or children, returns whether they changed
+    bool fitNode(unsigned int node);
+
+    void appendSubtree(const Node& node, std::vector<std::size_t>& result) const;
+
+    void querySubtree(const Frustum& frustum, unsigned int root, std::vector<std::size_t>& result) const;
+
+private:
+    std::vector<Node> nodes;                // root is the first one, children always follow their parents
+    std::vector<unsigned int> items;        // object indices, items of every subtree are contiguous
+    std::vector<glm::vec4> spheres;         // world bounding spheres by object index
+    SphereArray itemSpheres;                // the same spheres in order of items for culling of leaves
+    std::vector<unsigned int> leaves;       // leaf containing the object by object index
+    unsigned int depth = 0;
+};
+
+#endif // !BOUNDING_VOLUME_HIERARCHY_H
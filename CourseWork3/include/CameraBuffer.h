@@ -0,0 +1,37 @@
+#ifndef CAMERA_BUFFER_H
+#define CAMERA_BUFFER_H
+
+#include <Shader.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Uniform buffer with projection and view matrices shared by all programs drawing the scene.
+// Matrices are written once right before the frame is submitted, so the view may be turned by the latest input
+// after draws were queued, without setting uniforms of every program again.
+class CameraBuffer
+{
+public:
+    // Uniform buffer binding point of "Camera" block, "Materials" block uses 0
+    static const unsigned int BINDING = 1;
+
+    // Uploads matrices and binds the buffer, creating it on the first call
+    static void update(const glm::mat4& projection, const glm::mat4& view);
+
+    // Connects "Camera" block of the shader to the buffer bound by update()
+    static void setupShader(const Shader& shader);
+
+    static void release();
+
+private:
+    // Layout of std140 "Camera" block
+    struct CameraData
+    {
+        glm::mat4 projection;
+        glm::mat4 view;
+    };
+
+    static unsigned int buffer;
+};
+
+#endif // !CAMERA_BUFFER_H
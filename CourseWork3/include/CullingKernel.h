@@ -0,0 +1,83 @@
+#ifndef CULLING_KERNEL_H
+#define CULLING_KERNEL_H
+
+#include <Frustum.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Bounding spheres stored by components, so several of them are loaded into one SIMD register
+struct SphereArray
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    void push_back(const glm::vec4& sphere);
+    void set(std::size_t i, const glm::vec4& sphere);
+    glm::vec4 get(std::size_t i) const { return glm::vec4(x[i], y[i], z[i], radius[i]); }
+    void resize(std::size_t size);
+    void clear() { resize(0); }
+    std::size_t size() const { return x.size(); }
+};
+
+// Axis-aligned boxes stored by components
+struct BoxArray
+{
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> minZ;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+    std::vector<float> maxZ;
+
+    void push_back(const glm::vec3& boxMin, const glm::vec3& boxMax);
+    void resize(std::size_t size);
+    void clear() { resize(0); }
+    std::size_t size() const { return minX.size(); }
+};
+
+// Tests bounds against six frustum planes, 8 objects at a time with AVX2 or 4 with SSE.
+// Instruction set is chosen once at runtime, processors without them use scalar code.
+//
+// Culling functions test range [first, first + count) of the array and write indices of visible bounds
+// relative to first into visible, which must have room for count indices. They return number of visible ones.
+class CullingKernel
+{
+public:
+    enum InstructionSet
+    {
+        SCALAR,
+        SSE,
+        AVX2
+    };
+
+    // The best instruction set supported by processor and operating system
+    static InstructionSet getSupportedInstructionSet();
+
+    static InstructionSet getInstructionSet() { return instructionSet; }
+
+    // Forces slower instruction set, e.g. to compare them. Unsupported ones are replaced with the best supported one.
+    static void setInstructionSet(InstructionSet set);
+
+    static const char* getName(InstructionSet set);
+
+    static std::size_t cullSpheres(const Frustum& frustum, const SphereArray& spheres, std::size_t first, std::size_t count,
+                                   unsigned int* visible);
+
+    static std::size_t cullBoxes(const Frustum& frustum, const BoxArray& boxes, std::size_t first, std::size_t count,
+                                 unsigned int* visible);
+
+    // Culls the whole array, visible is resized to the number of visible bounds
+    static void cullSpheres(const Frustum& frustum, const SphereArray& spheres, std::vector<unsigned int>& visible);
+
+    static void cullBoxes(const Frustum& frustum, const BoxArray& boxes, std::vector<unsigned int>& visible);
+
+private:
+    static InstructionSet instructionSet;
+};
+
+#endif // !CULLING_KERNEL_H
@@ -0,0 +1,124 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <JobSystem.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Everything the main thread needs to submit one frame. Camera and lights are copied when the packet is begun,
+// the rest is filled by preparation which may run as a job, so it must read nothing the main thread changes.
+struct FramePacket
+{
+    enum Draw : unsigned char
+    {
+        DRAW_NOTHING,   // batched, instanced or occluded
+        DRAW_IMPOSTOR,
+        DRAW_MESHES
+    };
+
+    unsigned long long number = 0;
+
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float fieldOfView = 0.0f;   // vertical, in radians
+    float aspectRatio = 1.0f;
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    // wider than projection when view may be turned by input right before submission
+    glm::mat4 cullingProjection = glm::mat4(1.0f);
+    // when the oldest mouse input shown by the frame was polled, negative if the view wasn't turned
+    double inputTime = -1.0;
+    std::vector<glm::vec3> pointLightPositions;
+    std::vector<glm::vec3> spotLightPositions;
+
+    // objects inside the frustum, how each of them is drawn and its depth for the render queue
+    std::vector<std::size_t> visibleObjects;
+    std::vector<Draw> draws;
+    std::vector<float> depths;
+};
+
+// Overlaps CPU preparation of the next frame with submission of the current one.
+//
+// Packets are double-buffered: after the main thread has executed draws of frame N it begins packet N + 1
+// and prepare() hands it to a job, which culls objects while the main thread swaps buffers and waits for GPU.
+// takePacket() at the start of the next frame waits for the job if it hasn't finished yet.
+// Fences set after every swap bound how far GPU may fall behind, so the pipeline adds at most one frame of latency.
+//
+// The scene must not change while a packet is being prepared, invalidate() waits for the job and drops its packet.
+class FramePipeline
+{
+public:
+    using PrepareFunction = std::function<void(FramePacket& packet)>;
+
+    // Submission of a frame waits until GPU has fewer frames than that left
+    static const int MAX_FRAMES_IN_FLIGHT = 2;
+
+    struct Statistics
+    {
+        std::size_t preparedAhead = 0;    // frames prepared while the previous one was submitted
+        std::size_t preparedInPlace = 0;  // frames prepared by the main thread, e.g. after the scene was changed
+        double preparationWait = 0;       // milliseconds the main thread waited for jobs in the last frame
+        double gpuWait = 0;               // milliseconds the main thread waited for fences in the last frame
+    };
+
+    FramePipeline() = default;
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    ~FramePipeline() { release(); }
+
+    // Returns the packet to fill for the next frame, it's never the packet of the frame being submitted
+    FramePacket& beginPacket();
+
+    // Runs preparation of the packet returned by the last beginPacket() as a job
+    void prepareAhead(const PrepareFunction& prepare);
+
+    // Prepares the packet returned by the last beginPacket() on this thread
+    void prepareInPlace(const PrepareFunction& prepare);
+
+    // Waits for the packet prepared ahead and returns it, nullptr if there is none
+    FramePacket* takePacket();
+
+    // Waits for preparation and drops its packet, e.g. before objects, batches or occlusion culler are changed
+    void invalidate();
+
+    // Waits until GPU has finished frames submitted MAX_FRAMES_IN_FLIGHT frames ago
+    void waitForGpu();
+
+    // Marks the end of frame's commands, should be called right after buffers are swapped
+    void endFrame();
+
+    void release();
+
+    bool isEnabled() const { return enabled; }
+
+    // Disabled pipeline prepares every frame at its start, as the main loop did before
+    void setEnabled(bool enabled);
+
+    const Statistics& getStatistics() const { return statistics; }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    static const int PACKETS_NUMBER = 2;
+    FramePacket packets[PACKETS_NUMBER];
+    int nextPacket = 0;
+    unsigned long long frameNumber = 0;
+
+    JobSystem::JobHandle job;        // preparation in progress or finished, nullptr if nothing is prepared ahead
+    FramePacket* prepared = nullptr; // packet of the job
+
+    GLsync fences[MAX_FRAMES_IN_FLIGHT] = {};
+    int nextFence = 0;
+
+    bool enabled = true;
+    Statistics statistics;
+};
+
+#endif // !FRAME_PIPELINE_H
@@ -0,0 +1,38 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// Six planes bounding the visible volume, extracted from projection * view matrix.
+// Planes point inside, so a point is visible when it is in front of all of them.
+class Frustum
+{
+public:
+    static const int PLANES_NUMBER = 6;
+
+    enum Containment
+    {
+        OUTSIDE,
+        INTERSECTS,
+        INSIDE
+    };
+
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    // Sphere is given as center in xyz and radius in w
+    bool intersects(const glm::vec4& sphere) const;
+
+    // Axis-aligned box given by its corners
+    bool intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    // Plane i in order left, right, bottom, top, near, far
+    const glm::vec4& getPlane(int i) const { return planes[i]; }
+
+    // Tells whether box is entirely inside, so everything in it is visible without further tests
+    Containment classify(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+private:
+    glm::vec4 planes[PLANES_NUMBER]; // left, right, bottom, top, near, far; xyz is normal and w is distance
+};
+
+#endif // !FRUSTUM_H
@@ -0,0 +1,90 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Runs jobs on a pool of worker threads with work stealing.
+//
+// Every thread has its own queue: jobs scheduled by a thread are pushed to and taken from the back of its queue,
+// so recently created jobs run while their data is still in cache. Idle threads steal from the front of queues
+// of random other threads, where the oldest and usually the biggest jobs are. Threads which don't belong to the
+// pool share one queue, and wait() runs queued jobs instead of blocking, so the main thread works too.
+//
+// Jobs may depend on other jobs and start only after all of them are finished. Jobs must not touch GL state,
+// GL calls stay on the thread which owns the context. Until start() is called every job runs at once on the
+// thread which schedules it.
+class JobSystem
+{
+public:
+    struct Job;
+    using JobHandle = std::shared_ptr<Job>;
+    using Function = std::function<void()>;
+
+    // Called with range [begin, end) of indices
+    using RangeFunction = std::function<void(std::size_t begin, std::size_t end)>;
+
+    struct Statistics
+    {
+        std::size_t executed = 0;
+        std::size_t stolen = 0;
+    };
+
+    // Starts worker threads, by default one less than the number of cores, as the calling thread helps them.
+    // Restarts the pool if it is already running.
+    static void start(unsigned int workers = getDefaultWorkersNumber());
+
+    // Finishes queued jobs and joins workers
+    static void stop();
+
+    static unsigned int getDefaultWorkersNumber();
+
+    // Number of threads running jobs, including the one which waits for them
+    static unsigned int getThreadsNumber() { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    // Queues job which starts after all dependencies are finished
+    static JobHandle schedule(Function function, const std::vector<JobHandle>& dependencies = {});
+
+    static bool isFinished(const JobHandle& job);
+
+    // Runs other jobs until job is finished
+    static void wait(const JobHandle& job);
+
+    static void wait(const std::vector<JobHandle>& jobs);
+
+    // Splits [0, count) into ranges of at least grain indices, runs them as jobs and waits for all of them.
+    // Ranges are processed in any order and at the same time, so function must only write data of its range.
+    static void parallelFor(std::size_t count, std::size_t grain, const RangeFunction& function);
+
+    // Counters since the last call of start()
+    static Statistics getStatistics();
+
+    static void printStatistics(std::ostream& out = std::cout);
+
+private:
+    struct Queue;
+
+    static void runWorker(unsigned int index);
+
+    static void push(const JobHandle& job);
+
+    // Takes job from the queue of the thread or steals one, returns nullptr if all queues are empty
+    static JobHandle take();
+
+    static void run(const JobHandle& job);
+
+private:
+    static std::vector<std::unique_ptr<Queue>> queues; // the first one is shared by threads outside the pool
+    static std::vector<std::thread> workers;
+    static std::atomic<std::size_t> queued;            // jobs in all queues
+    static std::atomic<bool> running;
+    static std::atomic<std::size_t> executed;
+    static std::atomic<std::size_t> stolen;
+};
+
+#endif // !JOB_SYSTEM_H
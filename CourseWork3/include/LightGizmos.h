@@ -0,0 +1,55 @@
+#ifndef LIGHT_GIZMOS_H
+#define LIGHT_GIZMOS_H
+
+#include <Lights/PointLight.h>
+#include <Lights/SpotLight.h>
+#include <Primitives.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Draws point lights as small cubes and spot lights as pyramids turned along their direction.
+// Transforms and colors of all lights are collected into one instance buffer, so every kind of light
+// is drawn with a single instanced call whatever the number of lights.
+class LightGizmos
+{
+public:
+    LightGizmos();
+
+    LightGizmos(const LightGizmos&) = delete;
+    LightGizmos& operator=(const LightGizmos&) = delete;
+
+    ~LightGizmos();
+
+    // Rebuilds instance data from current positions, directions and colors of lights
+    void update(const std::vector<PointLight>& pointLights, const std::vector<SpotLight>& spotLights);
+
+    // Draws gizmos of all lights with light box shader, which must be in use with projection and view set
+    void render() const;
+
+    std::size_t getInstanceCount() const { return instances.size(); }
+
+private:
+    // Points per-instance attributes of bound vertex array to given instance
+    void setFirstInstance(std::size_t first) const;
+
+private:
+    // Per-instance attributes, their locations must match deferred_light_box.vert
+    struct Instance
+    {
+        glm::mat4 model;
+        glm::vec3 color;
+    };
+
+    std::vector<Instance> instances; // point lights first, then spot lights
+    GLsizei pointLightsNumber = 0;
+    GLsizei spotLightsNumber = 0;
+
+    GLuint vertexArray = 0;
+    GLuint instanceBuffer = 0;
+    std::size_t instanceBufferCapacity = 0;
+};
+
+#endif // !LIGHT_GIZMOS_H
@@ -4,7 +4,7 @@
 #include <vector>
 #include <Aliases.h>
 #include <Lights/PointLight.h>
-#include <Lights/SpotLight.h>s
+#include <Lights/SpotLight.h>
 #include <GLFW/glfw3.h>
 
 enum class ActiveLightType 
@@ -36,17 +36,19 @@ public:
     void switchToNext();
     void switchToPrevious();
     void switchLightType(ActiveLightType type);
-    void translateCurrentLight(Direction dir);
+    void translateCurrentLight(Direction dir, float deltaTime);
     void setActiveLightType(ActiveLightType type) { this->activeType = type; }
     void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
-    void updateDeltaTime(float deltaTime) { this->deltaTime = deltaTime >= 0 ? deltaTime : 0; }
+    // Moves selected light by held U/O/I/K/J/L keys, called at every simulation step
+    void update(GLFWwindow* window, float step);
+    // Must be called when lights are added or removed, keeps selected lights valid
+    void lightsChanged();
 private:    
     PointLights& pointLights;
     SpotLights& spotLights;
     int curPointLight = 0;
     int curSpotLight = 0;
     ActiveLightType activeType = ActiveLightType::NONE;
-    float deltaTime = 0;
 };
 
 #endif // !LIGHT_MANAGER_H
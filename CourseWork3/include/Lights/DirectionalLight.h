@@ -12,7 +12,7 @@ public:
     	, _direction(direction)
     	{}
     
-    glm::vec3 getDirection() { return _direction; }
+    glm::vec3 getDirection() const { return _direction; }
    
     void setDirection(glm::vec3 direction) { _direction = direction; }
     
@@ -16,7 +16,7 @@ public:
 
     void setColor(glm::vec3 color) { _color = color; }     
 
-    glm::vec3 getColor() { return _color; } 
+    glm::vec3 getColor() const { return _color; } 
    
 protected:    
     glm::vec3 _color;
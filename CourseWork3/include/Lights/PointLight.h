@@ -12,10 +12,10 @@ public:
     PointLight( glm::vec3 position, glm::vec3 color
         , float constant, float linear, float quadratic);
 
-    glm::vec3 getPosition() { return _position; }
-    float getConstant() { return _constant; }
-    float getLinear() { return _linear; }
-    float getQuadratic() { return _quadratic; }
+    glm::vec3 getPosition() const { return _position; }
+    float getConstant() const { return _constant; }
+    float getLinear() const { return _linear; }
+    float getQuadratic() const { return _quadratic; }
 
     void setPosition(const glm::vec3& position) { _position = position; }
     void setConstant(float constant) { _constant = (constant > 0) ? constant : 1.0; }
@@ -10,15 +10,15 @@ public:
         , float constant, float linear, float quadratic
         , float cutOff, float outerCutOff);   
     
-    glm::vec3 getPosition() { return _position; }    
-    glm::vec3 getDirection() { return _direction; }
-    float getConstant() { return _constant; }
-    float getLinear() { return _linear; }
-    float getQuadratic() { return _quadratic; }
-    float getCutOff() { return _cutOff; }
-    float getCutOffInRadians() { return glm::radians(getCutOff()); }
-    float getOuterCutOff() { return _outerCutOff; }
-    float getOuterCutOffInRadians() { return glm::radians(getOuterCutOff()); }
+    glm::vec3 getPosition() const { return _position; }    
+    glm::vec3 getDirection() const { return _direction; }
+    float getConstant() const { return _constant; }
+    float getLinear() const { return _linear; }
+    float getQuadratic() const { return _quadratic; }
+    float getCutOff() const { return _cutOff; }
+    float getCutOffInRadians() const { return glm::radians(getCutOff()); }
+    float getOuterCutOff() const { return _outerCutOff; }
+    float getOuterCutOffInRadians() const { return glm::radians(getOuterCutOff()); }
 
     void setPosition(const glm::vec3& position) { _position = position; }
     void setDirection(const glm::vec3& direction) {_direction = direction;}
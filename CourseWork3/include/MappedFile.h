@@ -0,0 +1,44 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only view of a whole file mapped into memory.
+// Contents are paged in by the OS on access, so nothing is copied on open.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path) { open(path); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { close(); }
+
+    // Maps the file, returns false if it can't be opened or mapped
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const { return _open; }
+
+    const char* data() const { return _data; }
+
+    std::size_t size() const { return _size; }
+
+private:
+    const char* _data = nullptr;
+    std::size_t _size = 0;
+    bool _open = false;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#else
+    int _descriptor = -1;
+#endif
+};
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,61 @@
+#ifndef MOUSE_LOOK_H
+#define MOUSE_LOOK_H
+
+#include <Camera.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <iostream>
+
+// Turns camera by mouse movement collected since the previous apply().
+//
+// Callbacks only add offsets and remember when they were polled, the camera is turned where the frame needs it,
+// so the latest input can be applied right before submission. Optional smoothing moves camera towards
+// the accumulated offset exponentially with a time constant, so it feels the same at any frame rate.
+// Latency is measured from the moment the oldest input shown by a frame was polled to the swap of that frame.
+class MouseLook
+{
+public:
+    static const float DEFAULT_SMOOTHING_TIME; // seconds
+
+    struct Statistics
+    {
+        std::size_t frames = 0;     // frames which showed new input
+        double lastLatency = 0;     // milliseconds
+        double averageLatency = 0;
+        double maxLatency = 0;
+    };
+
+    explicit MouseLook(float smoothingTime = DEFAULT_SMOOTHING_TIME) : smoothingTime(smoothingTime) {}
+
+    // Called by cursor callback with offset in pixels, time is in seconds
+    void move(float xoffset, float yoffset, double time);
+
+    // Turns camera by pending offset. Returns time of the oldest input applied for the first time or -1 if there was none.
+    double apply(Camera& camera, double time);
+
+    // Adds latency of a frame which showed input polled at inputTime and was swapped at presentTime
+    void measure(double inputTime, double presentTime);
+
+    bool isSmoothing() const { return smoothing; }
+
+    void setSmoothing(bool smoothing) { this->smoothing = smoothing; }
+
+    const Statistics& getStatistics() const { return statistics; }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    float smoothingTime;
+    bool smoothing = false;
+
+    glm::vec2 pending = glm::vec2(0.0f);    // offset not applied to camera yet
+    bool hasNewInput = false;               // input was added since the previous apply()
+    double inputTime = 0;                   // when the oldest input since the previous apply() was polled
+    double lastApply = -1;
+
+    Statistics statistics;
+};
+
+#endif // !MOUSE_LOOK_H
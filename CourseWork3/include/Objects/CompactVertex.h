@@ -0,0 +1,30 @@
+#ifndef COMPACT_VERTEX_H
+#define COMPACT_VERTEX_H
+
+#include <Objects/Mesh.h>
+
+#include <cstdint>
+#include <vector>
+
+// Quantized vertex, 16 bytes instead of 32 for Vertex.
+// Position is normalized to mesh bounds, decoded position is position * positionScale + positionOffset.
+// Normal is packed as signed normalized 2_10_10_10 and texture coordinates are half floats.
+struct CompactVertex {
+    std::uint16_t Position[3];
+    std::uint16_t padding;
+    std::uint32_t Normal;
+    std::uint16_t TexCoords[2];
+};
+
+static_assert(sizeof(CompactVertex) == 16, "compact vertex layout must match attribute pointers");
+
+// Quantizes vertices, returns scale and offset which restore positions
+std::vector<CompactVertex> compressVertices(const std::vector<Vertex>& vertices, glm::vec3& positionScale, glm::vec3& positionOffset);
+
+// Packs normalized vector into GL_INT_2_10_10_10_REV format, w is zero
+std::uint32_t packNormal(const glm::vec3& normal);
+
+// Converts float to IEEE 754 half precision with rounding to nearest even
+std::uint16_t toHalf(float value);
+
+#endif // !COMPACT_VERTEX_H
@@ -0,0 +1,145 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <glad/glad.h>
+#include <Shader.h>
+
+#include <cstddef>
+#include <iostream>
+#include <map>
+#include <vector>
+
+struct Geometry;
+
+// Large vertex and index buffers shared by all geometries with the same layout.
+// Geometries get ranges of these buffers, so drawing them needs no VAO switches and
+// several of them can be drawn with one multi-draw call. Indices of a range are relative
+// to its first vertex, draws pass vertex offset as base vertex.
+//
+// Buffers grow when ranges don't fit, freed ranges are reused and compact() moves
+// live ranges together and shrinks buffers, so models can be loaded and unloaded at runtime.
+class GeometryArena
+{
+public:
+    // Location of geometry data, offsets are in vertices and indices
+    struct Block
+    {
+        std::size_t vertexOffset = 0;
+        std::size_t vertexCount = 0;
+        std::size_t indexOffset = 0;
+        std::size_t indexCount = 0;
+        bool live = false;
+    };
+
+    // Returns arena for vertices uploaded as CompactVertex or Vertex and indices of given type
+    static GeometryArena& get(bool compact, GLenum indexType);
+
+    // Compacts all arenas
+    static void compactAll();
+
+    // Prints used and allocated memory of all arenas
+    static void printStatistics(std::ostream& out = std::cout);
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    // Copies data into arena and returns id of the block, blocks keep their ids when they are moved
+    unsigned int allocate(const void* vertices, std::size_t vertexCount, const void* indices, std::size_t indexCount);
+
+    void free(unsigned int block);
+
+    // Moves all live blocks to the beginning of new tightly sized buffers
+    void compact();
+
+    const Block& getBlock(unsigned int block) const { return blocks[block]; }
+
+    bool isCompact() const { return compactVertices; }
+
+    GLenum getIndexType() const { return indexType; }
+
+    std::size_t getIndexSize() const { return indexSize; }
+
+    void bind() const { glBindVertexArray(VAO); }
+
+private:
+    // Free ranges ordered by offset, neighbouring ranges are merged
+    class FreeList
+    {
+    public:
+        // Returns offset of allocated range or ~0 if there is no suitable range
+        std::size_t allocate(std::size_t size);
+
+        void free(std::size_t offset, std::size_t size);
+
+        void clear() { ranges.clear(); }
+
+    private:
+        std::map<std::size_t, std::size_t> ranges; // offset -> size
+    };
+
+    GeometryArena(bool compact, GLenum indexType);
+
+    // Reallocates buffers with given capacities keeping live blocks at their offsets
+    void grow(std::size_t vertexCapacity, std::size_t indexCapacity);
+
+    // Points vertex array to current buffers
+    void setupVertexArray();
+
+private:
+    bool compactVertices;
+    GLenum indexType;
+    std::size_t vertexSize;
+    std::size_t indexSize;
+
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+    std::size_t vertexCapacity = 0;
+    std::size_t indexCapacity = 0;
+    std::size_t usedVertices = 0;
+    std::size_t usedIndices = 0;
+
+    FreeList freeVertices;
+    FreeList freeIndices;
+    std::vector<Block> blocks;
+    std::vector<unsigned int> freeBlocks; // ids of dead blocks which can be reused
+};
+
+// Collects draws of geometries from one arena and submits them with one call:
+// glMultiDrawElementsIndirect when GL 4.3 is available, glMultiDrawElementsBaseVertex otherwise.
+// With GL 4.3 every draw reads its own material index through base instance, otherwise all draws
+// of the list must have the same material. Position dequantization is a uniform, so it must match too.
+class MultiDraw
+{
+public:
+    bool empty() const { return counts.empty(); }
+
+    // Returns true if geometry with the material can be drawn together with added ones
+    bool accepts(const Geometry& geometry, unsigned int material) const;
+
+    void add(const Geometry& geometry, unsigned int lod, unsigned int material);
+
+    // Draws all added geometries and clears the list, materials must be bound with MaterialLibrary::bind()
+    void submit(const Shader& shader);
+
+private:
+    // Layout of GL 4.3 indirect draw command
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint  baseVertex;
+        GLuint baseInstance;
+    };
+
+    const Geometry* first = nullptr;
+    const GeometryArena* arena = nullptr;
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets; // in bytes
+    std::vector<GLint> baseVertices;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<GLuint> materials; // one per draw
+};
+
+#endif // !GEOMETRY_ARENA_H
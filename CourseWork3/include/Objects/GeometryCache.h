@@ -0,0 +1,43 @@
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <Objects/Mesh.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <iostream>
+
+// Keeps one copy of GPU data for every distinct vertex/index data.
+// Meshes with byte-identical geometry (e.g. same .obj exported with different materials) share it.
+// Cache doesn't own geometries: data is released from GeometryArena when the last mesh using it is destroyed.
+class GeometryCache
+{
+public:
+    // Returns geometry with given content, uploading it to GPU if no identical geometry was seen before.
+    // Indices may hold several levels of detail described by lods, if lods are empty all indices are one level.
+    // Compact geometry is uploaded as CompactVertex, it is never shared with full precision one.
+    static std::shared_ptr<const Geometry> acquire(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+                                                   std::vector<Geometry::Lod> lods = {}, bool compact = false);
+
+    // Prints number of live and shared geometries and memory saved by sharing
+    static void printStatistics(std::ostream& out = std::cout);
+
+private:
+    static std::uint64_t hash(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+
+    static bool equal(const Geometry& geometry, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                      const std::vector<Geometry::Lod>& lods, bool compact);
+
+    // Copies geometry data into arena matching its layout
+    static void upload(Geometry& geometry);
+
+private:
+    // Several geometries may have the same hash, so each bucket is checked for exact match
+    static std::unordered_map<std::uint64_t, std::vector<std::weak_ptr<const Geometry>>> geometries;
+    static std::size_t shared;
+    static std::size_t savedMemory;
+};
+
+#endif // !GEOMETRY_CACHE_H
@@ -0,0 +1,100 @@
+#ifndef IMPOSTOR_RENDERER_H
+#define IMPOSTOR_RENDERER_H
+
+#include <Objects/Model.h>
+#include <Objects/ObjectStore.h>
+#include <Shader.h>
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Draws distant objects as camera facing quads textured with pre-rendered views of their models.
+//
+// Every model is baked into an octahedral atlas: FRAMES_NUMBER x FRAMES_NUMBER views from directions
+// which cover the whole sphere evenly. Atlas of each model is a layer of two texture arrays, one with
+// albedo and coverage, another with model space normal and depth along the view. So impostors of all
+// models are drawn with one instanced draw call.
+class ImpostorRenderer
+{
+public:
+    static const int FRAMES_NUMBER = 8;  // views along each side of the atlas
+    static const int FRAME_SIZE = 64;    // pixels along each side of the view
+    static const int ATLAS_SIZE = FRAMES_NUMBER * FRAME_SIZE;
+
+    // Objects farther than distance from camera are drawn as impostors
+    explicit ImpostorRenderer(float distance);
+
+    ImpostorRenderer(const ImpostorRenderer&) = delete;
+    ImpostorRenderer& operator=(const ImpostorRenderer&) = delete;
+
+    ~ImpostorRenderer();
+
+    float getDistance() const { return distance; }
+
+    void setDistance(float distance) { this->distance = distance; }
+
+    // Renders atlas of the model unless it was rendered before.
+    // It changes framebuffer and viewport, so it must not be called in the middle of a pass.
+    void bake(const std::shared_ptr<Model>& model);
+
+    bool isBaked(const Model* model) const { return layers.count(model) != 0; }
+
+    // Frees layers of models which were destroyed, so they are reused by next bakes
+    void releaseUnused();
+
+    // Returns true if object should be drawn as impostor, its model must be baked
+    bool isFar(const ObjectStore& objects, std::size_t index, const glm::vec3& cameraPosition) const;
+
+    // Returns true if bounding sphere (center in xyz and radius in w) is beyond impostor distance
+    bool isFar(const glm::vec4& sphere, const glm::vec3& cameraPosition) const;
+
+    // Adds object to the batch drawn by the next render()
+    void add(const ObjectStore& objects, std::size_t index);
+
+    // Draws all added objects with one instanced draw call and clears the batch.
+    // Shader is expected to be impostor shader with lights and camera buffer already set up.
+    void render(const Shader& shader, const glm::vec3& cameraPosition);
+
+    std::size_t getBatchSize() const { return instances.size(); }
+
+private:
+    // Per-instance attributes of impostor quad
+    struct Instance
+    {
+        glm::vec4 sphere;   // center and radius in world space
+        glm::vec4 rotation; // object rotation quaternion (x, y, z, w)
+        float layer;
+        float padding[3];
+    };
+
+    // Creates texture arrays with given number of layers, previous contents is lost
+    void allocate(unsigned int capacity);
+
+    // Renders all views of the model into given layer
+    void bakeLayer(Model& model, unsigned int layer);
+
+private:
+    float distance;
+
+    Shader bakeShader;
+    unsigned int framebuffer = 0;
+    unsigned int depthBuffer = 0;
+    unsigned int albedoTexture = 0;
+    unsigned int normalDepthTexture = 0;
+    unsigned int capacity = 0;
+
+    // Renderer doesn't keep models alive, so unloaded models release their geometry
+    std::vector<std::weak_ptr<Model>> baked; // indexed by layer
+    std::unordered_map<const Model*, unsigned int> layers;
+    std::vector<unsigned int> freeLayers;
+
+    unsigned int quadVAO = 0;
+    unsigned int quadVBO = 0;
+    unsigned int instanceVBO = 0;
+    std::vector<Instance> instances;
+};
+
+#endif // !IMPOSTOR_RENDERER_H
@@ -0,0 +1,115 @@
+#ifndef INSTANCE_CULLER_H
+#define INSTANCE_CULLER_H
+
+#include <Objects/Model.h>
+#include <Objects/ObjectStore.h>
+#include <Frustum.h>
+#include <RenderQueue.h>
+#include <Shader.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Culls and draws objects sharing a model as instances without touching them on CPU every frame.
+//
+// Bounding spheres of instances are drawn as points through instance_cull.vert and instance_cull.geom with
+// rasterization off. Geometry shader emits indices of instances inside the frustum, and transform feedback packs
+// them into a buffer read by instanced draws as per-instance attribute. Model matrices are fetched by these
+// indices from a buffer texture, so pbr.vert must have "instanceTransforms" bound with setupShader().
+// Every level of detail is culled by its own pass, which keeps instances of its range of screen sizes.
+//
+// GL 3.3 has no indirect draws, so numbers of visible instances are read back from queries of primitives written.
+// Frames don't wait for them: draws use the latest results which are already available, so the frustum given to
+// cull() should be a bit wider than the camera's one.
+class InstanceCuller
+{
+public:
+    // Models with fewer objects are drawn as separate objects
+    static const std::size_t MIN_INSTANCES = 16;
+
+    // Texture unit of the buffer texture with model matrices
+    static const unsigned int TRANSFORMS_TEXTURE_INDEX = 14;
+
+    InstanceCuller() = default;
+
+    InstanceCuller(const InstanceCuller&) = delete;
+    InstanceCuller& operator=(const InstanceCuller&) = delete;
+
+    ~InstanceCuller() { release(); }
+
+    // Groups static objects by model, models with at least MIN_INSTANCES objects are drawn instanced.
+    // Runs before StaticBatcher::build(), which merges only objects left by instancing.
+    // Instanced objects must not change until next build, so objects which move every frame are left to separate draws.
+    void build(const ObjectStore& objects);
+
+    void release();
+
+    bool isInstanced(std::size_t objectIndex) const { return objectIndex < instanced.size() && instanced[objectIndex]; }
+
+    // Runs culling passes of this frame with culling shader and picks the latest results available to draw.
+    // fieldOfView is vertical field of view in radians.
+    void cull(const Shader& cullShader, const Frustum& frustum, const glm::vec3& cameraPosition, float fieldOfView);
+
+    // Adds draws of visible instances to the queue with given programs for opaque and transparent materials
+    void submit(RenderQueue& queue, unsigned int program, unsigned int transparentProgram);
+
+    // Points "instanceTransforms" sampler of the program to the transforms texture unit
+    static void setupShader(const Shader& shader);
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    // Objects of one model
+    struct Group
+    {
+        // not owned, so models removed from the scene can be unloaded before the next build
+        Model* model;
+        glm::vec3 center;          // of bounds of all instances
+        std::size_t first;         // range of instances
+        std::size_t count;
+        unsigned int lods;
+        std::size_t firstResult;   // index of the first level in queries and counts
+        std::size_t firstOutput;   // index of the first level in buffers of frames, levels are count entries apart
+        bool opaque = false;       // has opaque meshes
+        bool transparent = false;  // has transparent meshes
+    };
+
+    // Culling results of one frame
+    struct Frame
+    {
+        GLuint buffer = 0;                 // visible instance indices, per group and level of detail
+        std::vector<GLuint> queries;       // primitives written, per group and level of detail
+        std::vector<GLuint> counts;        // read back results of queries
+        unsigned long long number = 0;     // 0 while it holds no results
+        bool resolved = false;             // counts are read back
+    };
+
+    // Reads back counts of the frame, returns false if they aren't available and wait is false
+    bool resolve(Frame& frame, bool wait);
+
+    // Draws visible instances of the group with opaque or transparent meshes
+    void render(const Shader& shader, const Group& group, bool transparent) const;
+
+private:
+    std::vector<Group> groups;
+    std::vector<bool> instanced; // indexed by object
+    std::size_t instancesNumber = 0;
+    std::size_t resultsNumber = 0;
+    std::size_t outputsNumber = 0;
+
+    GLuint vertexArray = 0;      // bounding spheres as points
+    GLuint sphereBuffer = 0;
+    GLuint transformBuffer = 0;
+    GLuint transformTexture = 0;
+
+    static const int FRAMES_NUMBER = 3;
+    Frame frames[FRAMES_NUMBER];
+    unsigned long long frameNumber = 0;
+    const Frame* drawn = nullptr; // frame whose results are drawn
+};
+
+#endif // !INSTANCE_CULLER_H
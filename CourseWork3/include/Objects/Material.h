@@ -0,0 +1,69 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <Objects/TexturePool.h>
+#include <Shader.h>
+
+#include <cstddef>
+#include <vector>
+
+// Maps and properties of surface, maps are layers of TexturePool arrays
+struct Material
+{
+    TextureLayer albedo;
+    TextureLayer normal;
+    TextureLayer metallic;
+    TextureLayer roughness;
+    float opacityRatio = 1.0f;
+    float refractionRatio = 1.0f;
+
+    // Transparent materials are drawn after opaque ones
+    bool isTransparent() const { return opacityRatio < 1.0f; }
+
+    bool operator==(const Material& other) const
+    {
+        return albedo == other.albedo && normal == other.normal && metallic == other.metallic && roughness == other.roughness
+            && opacityRatio == other.opacityRatio && refractionRatio == other.refractionRatio;
+    }
+};
+
+// Holds every distinct material once. Materials are kept in a uniform buffer, so shaders
+// find everything about the surface by material index, which is the only per-draw material state.
+class MaterialLibrary
+{
+public:
+    // Size of uniform array, must match pbr shaders
+    static const unsigned int MAX_MATERIALS = 256;
+
+    // Uniform buffer binding point of "Materials" block
+    static const unsigned int BINDING = 0;
+
+    // Returns index of the material, adding it if no equal material was added before
+    static unsigned int acquire(const Material& material);
+
+    static const Material& get(unsigned int index) { return materials[index]; }
+
+    static std::size_t size() { return materials.size(); }
+
+    // Uploads materials added since previous call, binds uniform buffer and all texture arrays
+    static void bind();
+
+    // Connects "Materials" block and texture samplers of the shader to buffers bound by bind()
+    static void setupShader(const Shader& shader);
+
+private:
+    // Layout of material in std140 uniform block
+    struct MaterialData
+    {
+        int albedoNormal[4];      // array and layer of albedo map, then of normal map
+        int metallicRoughness[4]; // array and layer of metallic map, then of roughness map
+        float properties[4];      // opacity ratio, refraction ratio
+    };
+
+private:
+    static std::vector<Material> materials;
+    static std::size_t uploaded; // number of materials already in the buffer
+    static unsigned int buffer;
+};
+
+#endif // !MATERIAL_H
@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <Shader.h>
+#include <Objects/TexturePool.h>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -12,6 +13,8 @@
 #include <vector>
 #include <memory>
 
+class GeometryArena;
+
 enum class TextureType {
     Albedo,
     Normal,
@@ -30,45 +33,79 @@ struct Vertex {
     glm::vec2 TexCoords;   
 };
 
+// Location of per-draw material index attribute, must match pbr.vert
+const GLuint MATERIAL_ATTRIBUTE = 3;
+
+// Location of per-instance transform index of instanced draws, must match pbr.vert (see InstanceCuller)
+const GLuint INSTANCE_ATTRIBUTE = 4;
+
+// Vertex and index data together with location of its copy in GPU buffers.
+// Geometry is immutable after upload and may be shared by several meshes (see GeometryCache).
+struct Geometry {
+    // Range of indices drawn for some level of detail, all levels share vertices
+    struct Lod {
+        unsigned int indexOffset;
+        unsigned int indexCount;
+        float error; // largest distance between surface of this level and original one
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices; // indices of all levels of detail one after another
+    std::vector<Lod> lods;             // from the finest to the coarsest, never empty
+
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    // GPU layout: vertices are either Vertex or CompactVertex, indices are 16-bit when all of them fit
+    bool compact = false;
+    GLenum indexType = GL_UNSIGNED_INT;
+    glm::vec3 positionScale = glm::vec3(1.0f);  // restores quantized positions of compact vertices
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+
+    // Range of shared buffers holding the data, it is released with geometry
+    GeometryArena* arena = nullptr;
+    unsigned int block = 0;
+
+    Geometry() = default;
+    Geometry(const Geometry&) = delete;
+    Geometry& operator=(const Geometry&) = delete;
+    ~Geometry();
+
+    std::size_t getVertexSize() const;
+    std::size_t getIndexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+
+    // Returns number of bytes occupied by GPU buffers
+    std::size_t getMemoryUsage() const { return vertices.size() * getVertexSize() + indices.size() * getIndexSize(); }
+};
+
 struct Texture {
-    unsigned int id;
+    TextureLayer layer;
     TextureType type;
     std::string path;
+    std::size_t size = 0; // bytes occupied by texture with all its mipmaps
 };
 
 const int BLINN_PHONG = 4;
 
 class Mesh {
 public:       
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures);
-
-    // Render the mesh
-    void Draw(Shader shader);
+    Mesh(const std::shared_ptr<const Geometry>& geometry, unsigned int material);
 
-    void setOpacityRatio(float opacity) { _opacityRatio = opacity; }
+    // Render the mesh, coarsest level is used if mesh has less levels of detail than requested.
+    // Materials must be bound with MaterialLibrary::bind().
+    void Draw(Shader shader, unsigned int lod = 0);
 
-    void setRefractionRatio(float refraction) { _refractionRatio = refraction; }
+    // Index of the material in MaterialLibrary
+    unsigned int getMaterial() const { return _material; }
 
-    float getOpacityRatio() { return _opacityRatio; }
+    // Returns number of bytes occupied by vertex and index data
+    std::size_t getMemoryUsage() const { return _geometry->getMemoryUsage(); }
 
-    float getRefractionRatio() { return _refractionRatio; }
+    const std::shared_ptr<const Geometry>& getGeometry() const { return _geometry; }
 
 private:
-    // Initializes all the buffer objects/arrays
-    void setupMesh();
-
-private:
-    // Render data
-    unsigned int VAO;
-    unsigned int VBO;
-    unsigned int EBO;
-
     // Mesh data
-    std::vector<Vertex> _vertices;
-    std::vector<unsigned int> _indices;
-    std::vector<Texture> _textures; 
-
-    float _opacityRatio;
-    float _refractionRatio;
+    std::shared_ptr<const Geometry> _geometry;
+    unsigned int _material;
 };
 #endif
\ No newline at end of file
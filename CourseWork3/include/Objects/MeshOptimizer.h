@@ -0,0 +1,44 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <Objects/Mesh.h>
+
+#include <vector>
+
+// Import time optimizations of triangle meshes.
+// Indices are expected to describe triangle list.
+class MeshOptimizer
+{
+public:
+    // Size of FIFO cache used to report ACMR, close to post-transform cache of most GPUs
+    static const unsigned int REPORT_CACHE_SIZE = 16;
+
+    struct Statistics
+    {
+        std::size_t verticesBefore;
+        std::size_t verticesAfter;
+        float acmrBefore;
+        float acmrAfter;
+    };
+
+    // Runs all steps: welding, vertex cache, overdraw and vertex fetch optimization
+    static Statistics optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Merges vertices with identical attributes
+    static void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Reorders triangles for post-transform cache locality (Tom Forsyth's linear-speed algorithm)
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, std::size_t verticesNumber);
+
+    // Reorders clusters of cache optimized triangles, so outer surfaces go first and hide inner ones (Tipsify).
+    // Clusters are split only where ACMR of the cluster stays within threshold of the original one.
+    static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+    // Reorders vertices in order of first use and drops unused ones
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Average number of vertex shader invocations per triangle for FIFO cache of given size
+    static float computeACMR(const std::vector<unsigned int>& indices, std::size_t verticesNumber, unsigned int cacheSize = REPORT_CACHE_SIZE);
+};
+
+#endif // !MESH_OPTIMIZER_H
@@ -0,0 +1,25 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <Objects/Mesh.h>
+
+#include <vector>
+
+// Builds levels of detail with quadric error metrics (Garland & Heckbert).
+// Edges are collapsed into one of their vertices, so all levels use the same vertices and only indices differ.
+// Vertices on borders and attribute seams are never moved, so vertices must be welded before (see MeshOptimizer).
+class MeshSimplifier
+{
+public:
+    static const unsigned int MAX_LODS = 4;
+
+    // Appends indices of coarser levels to indices and returns index ranges of all levels, the first one is original mesh.
+    // Less than MAX_LODS levels are built if mesh can't be simplified enough.
+    static std::vector<Geometry::Lod> generateLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+    // Collapses edges until there are no more than targetIndices indices or next collapse moves surface more than maxError.
+    // Returns largest distance surface was moved by collapses.
+    static float simplify(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::size_t targetIndices, float maxError);
+};
+
+#endif // !MESH_SIMPLIFIER_H
@@ -11,7 +11,9 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <Objects/Material.h>
 #include <Objects/Mesh.h>
+#include <Objects/TexturePool.h>
 #include <Shader.h>
 #include <stb_image.h>
 
@@ -20,11 +22,52 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory);
+// Processing done after Assimp post processing
+enum ImportSteps : unsigned int
+{
+    IMPORT_OPTIMIZE_MESHES = 1 << 0, // weld vertices and reorder them for vertex cache, overdraw and fetch (see MeshOptimizer)
+    IMPORT_COMPACT_VERTICES = 1 << 1, // store vertices quantized on GPU (see CompactVertex)
+    IMPORT_GENERATE_LODS = 1 << 2     // build coarser levels of detail, needs welded vertices (see MeshSimplifier)
+};
+
+// Options which affect the way model is imported. Models loaded with different options are different assets.
+struct ModelImportOptions
+{
+    unsigned int postProcessFlags = aiProcess_Triangulate /*| aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices*/;
+    unsigned int importSteps = IMPORT_OPTIMIZE_MESHES | IMPORT_COMPACT_VERTICES | IMPORT_GENERATE_LODS;
+
+    bool operator==(const ModelImportOptions& other) const
+    {
+        return postProcessFlags == other.postProcessFlags && importSteps == other.importSteps;
+    }
+};
+
+// Meshes and materials of a model read from file before anything is uploaded to GPU.
+// Importing doesn't touch GL state, so models may be imported by jobs and created on the thread with GL context.
+struct ImportedModel
+{
+    struct ImportedMesh
+    {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;   // coarser levels of detail are appended
+        vector<Geometry::Lod> lods;
+        Material material;              // texture layers are assigned when model is created
+        string texturePaths[4];         // by TextureType, relative to directory, empty if there is no map
+    };
+
+    string path;
+    string directory;
+    ModelImportOptions options;
+    vector<ImportedMesh> meshes;
+    unordered_map<string, TextureImage> images; // decoded textures by full path, except ones already in TexturePool
+    string log;                                 // messages of import steps, printed when model is created
+    string error;                               // empty if file was read
+};
 
 class Model 
 {
@@ -34,26 +77,53 @@ public:
     string directory;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path);
+    Model(string const &path, const ModelImportOptions& options = ModelImportOptions());
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader shader);    
+    // creates model from imported data, uploading its geometry and textures
+    explicit Model(ImportedModel&& imported);
 
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path);
+    // reads model file, processes its meshes and decodes their textures, may run on any thread
+    static ImportedModel import(string const &path, const ModelImportOptions& options = ModelImportOptions());
+
+    // draws the model, and thus all its meshes, with given level of detail
+    void Draw(Shader shader, unsigned int lod = 0);    
+
+    // number of levels of detail of the most detailed mesh
+    unsigned int getLodsNumber() const { return lodsNumber; }
+
+    // bounding sphere of all meshes in model space
+    glm::vec3 getBoundsCenter() const { return boundsCenter; }
+    float getBoundsRadius() const { return boundsRadius; }
+
+    const std::string& getPath() const { return path; }
 
+    const ModelImportOptions& getImportOptions() const { return importOptions; }
+
+    // Returns number of bytes occupied by model's geometry and textures
+    std::size_t getMemoryUsage() const;
+
+    // Number of triangles of all meshes at the finest level of detail
+    std::size_t getTrianglesNumber() const;
+
+private:
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene);
+    static void processNode(aiNode *node, const aiScene *scene, ImportedModel& model);
+
+    static ImportedModel::ImportedMesh processMesh(aiMesh *mesh, const aiScene *scene, ImportedModel& model);
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene);
+    // path of the first map of given type relative to model's directory, decodes it unless it was loaded before
+    static string importTexture(aiMaterial *mat, aiTextureType type, ImportedModel& model);
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
+    // returns the texture, loading it if it isn't loaded yet.
     // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, TextureType typeName);    
+    Texture loadTexture(const string& path, TextureType typeName, const ImportedModel& model);
 
 private:
     std::string path;
+    ModelImportOptions importOptions;
+    unsigned int lodsNumber = 1;
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
 };
 
 
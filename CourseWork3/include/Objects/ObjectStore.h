@@ -0,0 +1,147 @@
+#ifndef OBJECT_STORE_H
+#define OBJECT_STORE_H
+
+#include <Objects/Model.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Index of a model in ObjectStore, stays the same while any object uses the model
+using ModelHandle = std::uint32_t;
+
+// Stable reference to an object. Index of slot doesn't change when other objects are removed,
+// and generation tells apart objects which used the slot one after another.
+struct ObjectId
+{
+    std::uint32_t slot = ~0u;
+    std::uint32_t generation = 0;
+
+    bool operator==(const ObjectId& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const ObjectId& other) const { return !(*this == other); }
+};
+
+// Objects of the scene kept as parallel arrays, so culling, transform updates and draw building read only
+// the fields they need one after another. Objects are addressed by dense index from 0 to size() - 1,
+// which changes only when objects before them are removed; ObjectId survives that.
+//
+// Model matrices and bounding spheres are cached. Setters mark them outdated and updateTransforms()
+// recomputes all outdated ones in one pass, objects added with add() are up to date at once.
+// Every model is held once by the store and objects refer to it by handle, so drawing never touches reference counts.
+class ObjectStore
+{
+public:
+    static const ModelHandle NO_MODEL = ~0u;
+    static const std::size_t NO_INDEX = ~std::size_t(0);
+
+    // Returns handle of the model, registering it on first use
+    ModelHandle addModel(const std::shared_ptr<Model>& model);
+
+    // Returns handle of registered model or NO_MODEL
+    ModelHandle findModel(const Model* model) const;
+
+    const std::shared_ptr<Model>& getModelPointer(ModelHandle model) const { return models[model]; }
+
+    // Forgets models no object uses, so AssetRegistry::unloadUnused() can release them. Returns their number.
+    std::size_t releaseUnusedModels();
+
+    // Adds object to the end, model must be registered
+    ObjectId add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale, ModelHandle model);
+
+    // Removes objects with given ascending indices keeping order of the others
+    void remove(const std::vector<std::size_t>& indices);
+
+    void clear();
+
+    std::size_t size() const { return positions.size(); }
+
+    bool empty() const { return positions.empty(); }
+
+    void reserve(std::size_t capacity);
+
+    // Dense index of the object or NO_INDEX if it was removed
+    std::size_t getIndex(ObjectId id) const;
+
+    ObjectId getId(std::size_t index) const { return ids[index]; }
+
+    bool contains(ObjectId id) const { return getIndex(id) != NO_INDEX; }
+
+    const glm::vec3& getPosition(std::size_t index) const { return positions[index]; }
+
+    const glm::vec3& getRotation(std::size_t index) const { return rotations[index]; }
+
+    const glm::vec3& getScale(std::size_t index) const { return scales[index]; }
+
+    // Rotation is given by Euler angles in degrees
+    void setTransform(std::size_t index, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale);
+
+    // Recomputes model matrices and bounds of objects changed since the last call, in parallel with JobSystem
+    void updateTransforms();
+
+    ModelHandle getModelHandle(std::size_t index) const { return modelHandles[index]; }
+
+    Model& getModel(std::size_t index) const { return *models[modelHandles[index]]; }
+
+    // Translated, rotated and scaled model matrix
+    const glm::mat4& getModelMatrix(std::size_t index) const { return modelMatrices[index]; }
+
+    // Bounding sphere of the model in world space, xyz is center and w is radius
+    const glm::vec4& getBoundingSphere(std::size_t index) const { return spheres[index]; }
+
+    // All bounding spheres in index order
+    const std::vector<glm::vec4>& getBoundingSpheres() const { return spheres; }
+
+    // Static objects may be merged into static batches, batches must be rebuilt after they are changed
+    bool isStatic(std::size_t index) const { return statics[index] != 0; }
+
+    void setStatic(std::size_t index, bool isStatic) { statics[index] = isStatic ? 1 : 0; }
+
+    unsigned int getLod(std::size_t index) const { return lods[index]; }
+
+    // Chooses level of detail by the part of screen height covered by object's bounding sphere.
+    // fieldOfView is vertical field of view in radians. Different objects may be updated by different jobs.
+    void selectLod(std::size_t index, const glm::vec3& cameraPosition, float fieldOfView);
+
+    // Number of levels of detail selectLod() chooses from at most
+    static unsigned int getMaxLods();
+
+    // Part of screen height below which level lod + 1 is used instead of level lod, 0 for the last level
+    static float getLodScreenSize(unsigned int lod);
+
+private:
+    struct Slot
+    {
+        std::uint32_t index;      // dense index of the object while it's alive
+        std::uint32_t generation;
+    };
+
+    void updateTransform(std::size_t index);
+
+private:
+    // indexed by dense index
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<glm::mat4> modelMatrices;
+    std::vector<glm::vec4> spheres;
+    std::vector<ModelHandle> modelHandles;
+    std::vector<unsigned int> lods;
+    std::vector<std::uint8_t> statics;
+    std::vector<ObjectId> ids;
+
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+
+    std::vector<std::size_t> outdated; // dense indices of objects whose cached transforms are outdated
+    std::vector<std::uint8_t> isOutdated;
+
+    std::vector<std::shared_ptr<Model>> models; // nullptr for released handles
+    std::vector<ModelHandle> freeModels;
+    std::unordered_map<const Model*, ModelHandle> modelHandlesByPointer;
+};
+
+#endif // !OBJECT_STORE_H
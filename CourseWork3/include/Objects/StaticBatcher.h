@@ -0,0 +1,74 @@
+#ifndef STATIC_BATCHER_H
+#define STATIC_BATCHER_H
+
+#include <Objects/ImpostorRenderer.h>
+#include <Objects/InstanceCuller.h>
+#include <Objects/Mesh.h>
+#include <Objects/ObjectStore.h>
+#include <Frustum.h>
+#include <RenderQueue.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Merges meshes of static objects with the same material into world space batches drawn with one call each.
+// Objects of models repeated often enough are drawn instanced by InstanceCuller instead, and objects with many
+// triangles stay separate draws which OcclusionQueries can skip, so neither of them is merged.
+// Materials must be bound with MaterialLibrary::bind() before the queue is executed.
+//
+// Objects are grouped by cells of a regular grid (by center of their bounding sphere), so batches stay small
+// enough to be culled by frustum and cells far from camera can still be drawn as impostors.
+// Batches are built from the finest level of detail only.
+class StaticBatcher
+{
+public:
+    // Batches never hold more vertices than fit 16-bit indices
+    static const std::size_t MAX_BATCH_VERTICES = 1 << 16;
+
+    // Objects with at least that many triangles aren't merged
+    static const std::size_t MAX_OBJECT_TRIANGLES = 10000;
+
+    explicit StaticBatcher(float cellSize);
+
+    // Replaces all batches with batches of static objects which aren't instanced, so instances must be built first.
+    // Batched objects must not change until next build.
+    void build(const ObjectStore& objects, const InstanceCuller& instances);
+
+    void clear();
+
+    bool isBatched(std::size_t objectIndex) const { return objectIndex < batched.size() && batched[objectIndex]; }
+
+    // Adds batches which intersect frustum to the queue with given programs for opaque and transparent materials.
+    // Objects of cells farther than impostor distance are added to impostors instead.
+    void submit(RenderQueue& queue, unsigned int program, unsigned int transparentProgram, const Frustum& frustum, ImpostorRenderer& impostors,
+                const ObjectStore& objects, const glm::vec3& cameraPosition);
+
+    // Number of batches submitted by last submit()
+    std::size_t getDrawCount() const { return drawCount; }
+
+private:
+    struct Batch
+    {
+        Mesh mesh;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+
+    struct Cell
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        glm::vec4 sphere;                 // bounding sphere of all objects of the cell
+        std::vector<std::size_t> objects; // indices of batched objects
+        std::vector<Batch> batches;
+    };
+
+private:
+    float cellSize;
+    std::vector<Cell> cells;
+    std::vector<bool> batched; // indexed by object
+    std::size_t drawCount = 0;
+};
+
+#endif // !STATIC_BATCHER_H
@@ -0,0 +1,83 @@
+#ifndef TEXTURE_POOL_H
+#define TEXTURE_POOL_H
+
+#include <glad/glad.h>
+#include <Shader.h>
+
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Location of texture in the pool
+struct TextureLayer
+{
+    int array = -1; // index of texture array, negative if there is no texture
+    int layer = 0;
+
+    bool operator==(const TextureLayer& other) const { return array == other.array && layer == other.layer; }
+};
+
+// Pixels of texture file expanded to RGBA8, empty if file can't be read
+struct TextureImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// Places all textures of the same size as layers of one GL_TEXTURE_2D_ARRAY.
+// All arrays are bound at once, so draws with different textures need no texture binds in between.
+// Textures are stored as RGBA8 whatever number of channels the file has and are never unloaded.
+// When all arrays are taken, textures of other sizes are resized to the nearest size of existing array.
+class TexturePool
+{
+public:
+    // Number of distinct texture sizes, must match pbr shaders
+    static const int MAX_ARRAYS = 8;
+
+    // Returns layer with the texture, loading file on first request. size receives bytes taken by texture.
+    // Image decoded beforehand is uploaded instead of reading the file again. Must be called by the thread with GL context.
+    static TextureLayer acquire(const std::string& path, std::size_t* size = nullptr, const TextureImage* image = nullptr);
+
+    // Reads and decodes texture file without touching GL state, so it may run in jobs
+    static TextureImage decode(const std::string& path);
+
+    // Whether the texture was requested before. Thread safe, so jobs may call it while textures are acquired.
+    static bool contains(const std::string& path);
+
+    // Binds arrays to texture units 0 .. MAX_ARRAYS - 1, mipmaps of changed arrays are generated first
+    static void bind();
+
+    // Points sampler array "textureArrays" of the shader to units used by bind()
+    static void setupShader(const Shader& shader);
+
+    // Prints size and number of layers of every array
+    static void printStatistics(std::ostream& out = std::cout);
+
+private:
+    struct Array
+    {
+        unsigned int texture = 0;
+        int width = 0;
+        int height = 0;
+        int layers = 0;
+        int capacity = 0;
+        bool dirty = false; // mipmaps need to be generated
+    };
+
+    // Moves array into texture with given number of layers
+    static void grow(Array& array, int capacity);
+
+    static void insert(const std::string& path, const TextureLayer& layer);
+
+private:
+    static std::vector<Array> arrays;
+    // by path, inserted only by the thread with GL context under the mutex, other threads read it under the mutex
+    static std::unordered_map<std::string, TextureLayer> textures;
+    static std::mutex texturesMutex;
+};
+
+#endif // !TEXTURE_POOL_H
@@ -0,0 +1,119 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <Shader.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Rejects objects hidden behind geometry drawn in previous frames.
+//
+// After a frame is drawn its depth is reduced on GPU into a pyramid where every texel keeps the farthest depth
+// of the texels it covers. A small level of it is read back through pixel buffers without stalling, and when it
+// arrives a few frames later it is reprojected to current camera and reduced again on CPU. Bounding spheres are
+// tested against a level where they cover at most 2x2 texels.
+//
+// Results are conservative: texels no old depth was reprojected to are treated as empty, objects crossing near
+// plane are visible, and nothing is culled when depth is older than a few frames or after invalidate().
+class OcclusionCuller
+{
+public:
+    struct Statistics
+    {
+        std::size_t tested = 0;
+        std::size_t culled = 0;
+    };
+
+    OcclusionCuller() = default;
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    ~OcclusionCuller() { release(); }
+
+    // Creates GPU resources for screen of given size, does nothing if it didn't change
+    void resize(int width, int height);
+
+    void release();
+
+    // Reprojects the latest depth which was read back to the camera of the frame being drawn, resets statistics
+    void prepare(const glm::mat4& viewProjection);
+
+    // Sphere is given as center in xyz and radius in w, it must be inside the frustum.
+    // May be called by several jobs at once between prepare() and capture().
+    bool isOccluded(const glm::vec4& sphere);
+
+    // Reduces depth of the frame just drawn to default framebuffer and starts its read back.
+    // Reduction shader is hiz_reduce.vert and hiz_reduce.frag.
+    void capture(const Shader& reduceShader, const glm::mat4& viewProjection);
+
+    // Drops depth read back so far, e.g. after the scene was changed
+    void invalidate();
+
+    bool isEnabled() const { return enabled; }
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+
+    Statistics getStatistics() const { return { tested, culled }; }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    // Pixel buffer with read back in flight
+    struct Readback
+    {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        unsigned long long frame = 0;
+    };
+
+    // Level of CPU pyramid, depth values are in window space
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<float> depths; // rows from the bottom of the screen
+    };
+
+    void create();
+    void reproject(const glm::mat4& viewProjection);
+
+private:
+    bool enabled = true;
+    int width = 0;
+    int height = 0;
+    unsigned long long frame = 0;
+
+    // GPU pyramid, level 0 is half of the screen and the last one is read back
+    GLuint depthFramebuffer = 0;
+    GLuint depthTexture = 0;
+    GLuint pyramidTexture = 0;
+    std::vector<GLuint> levelFramebuffers;
+    std::vector<glm::ivec2> levelSizes;
+
+    static const int READBACKS_NUMBER = 3;
+    Readback readbacks[READBACKS_NUMBER];
+    int nextReadback = 0;
+
+    // the latest depth which arrived from GPU
+    std::vector<float> capturedDepths;
+    glm::mat4 capturedViewProjection = glm::mat4(1.0f);
+    unsigned long long capturedFrame = 0;
+    bool hasCapture = false;
+
+    // captured depth as seen by current camera, nothing is culled while it is empty
+    std::vector<Level> levels;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+
+    // statistics are counted by jobs testing objects
+    std::atomic<std::size_t> tested{ 0 };
+    std::atomic<std::size_t> culled{ 0 };
+};
+
+#endif // !OCCLUSION_CULLER_H
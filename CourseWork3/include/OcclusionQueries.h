@@ -0,0 +1,102 @@
+#ifndef OCCLUSION_QUERIES_H
+#define OCCLUSION_QUERIES_H
+
+#include <Objects/InstanceCuller.h>
+#include <Objects/ObjectStore.h>
+#include <Objects/StaticBatcher.h>
+#include <Frustum.h>
+#include <Shader.h>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Lets GPU skip draws of expensive objects which were hidden in the previous frame.
+//
+// Bounding boxes of objects with many triangles are drawn after opaque geometry inside GL_ANY_SAMPLES_PASSED queries,
+// and in the next frame objects are drawn under glBeginConditionalRender() with results of these queries.
+// StaticBatcher never merges such objects, so they stay separate draws; instanced objects aren't queried.
+// CPU never waits for results: a query which isn't finished yet lets the object be drawn.
+//
+// Nearby objects are grouped by their bounds. While a group is hidden only one query for its whole box is issued
+// and all objects of the group depend on it; once it becomes visible every object gets its own query,
+// until all of them are hidden again.
+class OcclusionQueries
+{
+public:
+    struct Statistics
+    {
+        std::size_t queries = 0; // issued in the last frame
+        std::size_t hidden = 0;  // objects hidden by the latest known results
+    };
+
+    OcclusionQueries() = default;
+
+    OcclusionQueries(const OcclusionQueries&) = delete;
+    OcclusionQueries& operator=(const OcclusionQueries&) = delete;
+
+    ~OcclusionQueries() { release(); }
+
+    // Chooses objects worth testing and groups them. Batched and instanced objects are skipped, so it must be called
+    // after static batches and instances are rebuilt.
+    void build(const ObjectStore& objects, const StaticBatcher& batcher, const InstanceCuller& instances);
+
+    void release();
+
+    // Reads results which are already available and decides which queries are issued in this frame
+    void update();
+
+    // Returns query which decides whether object is drawn in this frame, 0 if it must be drawn unconditionally
+    GLuint getCondition(std::size_t objectIndex) const;
+
+    // Draws boxes of objects in frustum inside queries. Query shader must be in use with projection and view set,
+    // it's called after opaque geometry, so it's tested against depth of the whole frame.
+    void issue(const Shader& shader, const ObjectStore& objects, const Frustum& frustum, const glm::vec3& cameraPosition);
+
+    // Drops results of issued queries, e.g. when queries were disabled for a while
+    void invalidate();
+
+    bool isEnabled() const { return enabled; }
+
+    void setEnabled(bool enabled);
+
+    const Statistics& getStatistics() const { return statistics; }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    struct Entry
+    {
+        std::size_t object;
+        std::size_t group;
+        GLuint query = 0;
+        bool queried = false; // query was issued in the last frame
+    };
+
+    struct Group
+    {
+        GLuint query = 0;
+        bool queried = false;
+        bool refined = false;     // objects were queried one by one in the last frame
+        bool refine = false;      // objects are queried one by one in this frame
+        std::size_t first;        // range of entries
+        std::size_t count;
+    };
+
+    // Splits entries by the longest axis of their centers until groups are small enough
+    void buildGroups(const ObjectStore& objects, std::size_t first, std::size_t count);
+
+    void drawBox(const Shader& shader, GLuint query, const glm::vec3& boxMin, const glm::vec3& boxMax);
+
+private:
+    bool enabled = true;
+    std::vector<Entry> entries;
+    std::vector<Group> groups;
+    std::vector<unsigned int> entryIndices; // indexed by object, ~0u if object isn't tested
+    Statistics statistics;
+};
+
+#endif // !OCCLUSION_QUERIES_H
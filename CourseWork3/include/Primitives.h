@@ -0,0 +1,49 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include <glad/glad.h>
+
+// Simple shapes used by helpers of the renderer, all of them are stored in one static vertex buffer.
+// Vertices have position at location 0 and texture coordinates at location 1.
+class Primitives
+{
+public:
+    enum Shape
+    {
+        CUBE,    // 2x2x2 cube centered at origin, faces look outside
+        PYRAMID, // 1x1x1 square pyramid centered at origin with apex along +Y
+        QUAD,    // full screen XY quad in NDC, triangle strip
+        SKYBOX,  // 2x2x2 cube centered at origin, faces look inside
+        SHAPES_NUMBER
+    };
+
+    struct Range
+    {
+        GLenum mode;
+        GLint first;
+        GLsizei count;
+    };
+
+    // Creates the buffer, must be called once after OpenGL is loaded
+    static void initialize();
+
+    static void release();
+
+    static void draw(Shape shape);
+
+    // Draws shape several times, vertex array with per-instance attributes must be bound
+    // and set up with setupVertexAttributes()
+    static void drawInstanced(Shape shape, GLsizei instanceCount);
+
+    // Binds shared vertex buffer to locations 0 and 1 of currently bound vertex array
+    static void setupVertexAttributes();
+
+    static const Range& getRange(Shape shape) { return ranges[shape]; }
+
+private:
+    static GLuint vertexArray;
+    static GLuint vertexBuffer;
+    static Range ranges[SHAPES_NUMBER];
+};
+
+#endif // !PRIMITIVES_H
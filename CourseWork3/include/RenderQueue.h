@@ -0,0 +1,124 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <Objects/GeometryArena.h>
+#include <Objects/Mesh.h>
+#include <Shader.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Collects draws of a frame, sorts them by 64-bit keys and executes them with as few state changes as possible.
+//
+// Key layout from the highest bit:
+//   pass (2) | program (6) | material (8) | depth (24) | command (24)
+// so draws are grouped by program and material and go front to back inside a group.
+// Transparent surfaces are blended order-independently (see TransparencyBuffer), so they are sorted the same way.
+// Lowest bits hold index of the command itself.
+class RenderQueue
+{
+public:
+    enum Pass : unsigned int
+    {
+        PASS_OPAQUE = 0,
+        PASS_SKY = 1,         // drawn behind everything with depth test, after opaque geometry
+        PASS_TRANSPARENT = 2,
+        PASS_OVERLAY = 3
+    };
+
+    // Custom draw, program is already in use when it is called
+    using DrawFunction = std::function<void(const Shader& shader)>;
+
+    // Called when execution enters or leaves a pass, may change any GL state
+    using PassHook = std::function<void()>;
+
+    struct Statistics
+    {
+        std::size_t draws = 0;
+        std::size_t programChanges = 0;
+        std::size_t materialChanges = 0;
+        std::size_t transformChanges = 0;
+    };
+
+    // Registers shader program, returned number is used in sort keys
+    unsigned int addProgram(const Shader& shader);
+
+    // Sets camera used by getDepth(), depth is 1 at far plane distance
+    void setCamera(const glm::vec3& position, float farPlane);
+
+    // Returns distance from camera to point normalized to [0, 1]
+    float getDepth(const glm::vec3& point) const { return getDepth(point, cameraPosition, farPlane); }
+
+    // The same for given camera, so depths may be computed before setCamera() is called for the frame
+    static float getDepth(const glm::vec3& point, const glm::vec3& cameraPosition, float farPlane);
+
+    // Stores model matrix shared by meshes of one object, returns its index
+    unsigned int addTransform(const glm::mat4& model);
+
+    // Adds draw of the mesh with given transform. Depth is distance from camera normalized to [0, 1].
+    // Non-zero condition is an occlusion query, the draw is skipped by GPU if no samples passed it (see OcclusionQueries).
+    void submit(Pass pass, unsigned int program, float depth, const Mesh& mesh, unsigned int lod, unsigned int transform,
+                GLuint condition = 0);
+
+    // Adds custom draw, material is taken as 0
+    void submit(Pass pass, unsigned int program, float depth, DrawFunction draw);
+
+    // Sets functions called around draws of the pass, they aren't called if the pass has no draws
+    void setPassHooks(Pass pass, PassHook begin, PassHook end);
+
+    // Sorts and executes all draws, then clears the queue
+    void execute();
+
+    // Statistics of the last execute()
+    const Statistics& getStatistics() const { return statistics; }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    struct Command
+    {
+        unsigned int program;
+        const Mesh* mesh;       // nullptr for custom draws
+        unsigned int lod;
+        unsigned int transform;
+        GLuint condition;       // occlusion query or 0
+        DrawFunction draw;
+    };
+
+    struct PassHooks
+    {
+        PassHook begin;
+        PassHook end;
+    };
+
+    static std::uint64_t makeKey(Pass pass, unsigned int program, unsigned int material, float depth, std::size_t command);
+
+    // Least significant digit radix sort by bytes, bytes equal in all keys are skipped
+    void sortKeys();
+
+    // Draws meshes collected in batch
+    void flush(const Shader& shader);
+
+    // Ends conditional rendering of previous draws and starts it for the next ones if query isn't 0
+    void setCondition(GLuint query);
+
+private:
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float farPlane = 1.0f;
+
+    PassHooks passHooks[PASS_OVERLAY + 1];
+    std::vector<const Shader*> programs;
+    std::vector<glm::mat4> transforms;
+    std::vector<Command> commands;
+    std::vector<std::uint64_t> keys;
+    std::vector<std::uint64_t> sortBuffer;
+    MultiDraw batch;
+    GLuint currentCondition = 0;
+    Statistics statistics;
+};
+
+#endif // !RENDER_QUEUE_H
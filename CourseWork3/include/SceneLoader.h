@@ -5,51 +5,50 @@
 #include <Lights/PointLight.h>
 #include <Lights/SpotLight.h>
 #include <Objects/Model.h>
-#include <Objects/Object.h>
+#include <Objects/ObjectStore.h>
 #include <Aliases.h>
+#include <AssetRegistry.h>
+#include <SceneParser.h>
+#include <SceneSnapshot.h>
+#include <SceneReloader.h>
 
 #include <iostream>
 #include <vector>
-#include <fstream>
-#include <sstream>
 #include <memory>
 
 //TODO: convert this to class Scene which holds all scene data: lights, models, objects, etc...
 class SceneLoader
 {
-    static const glm::vec3::value_type  MIN_ALLOWED_POSITION;
-    static const glm::vec3::value_type  MAX_ALLOWED_POSITION;
-    static const glm::vec3::value_type  MIN_ALLOWED_COLOR;
-    static const glm::vec3::value_type  MAX_ALLOWED_COLOR;
-    static const float                  MIN_ALLOWED_DEGREES_ANGLE;
-    static const float                  MAX_ALLOWED_DEGREES_ANGLE;
-
 public:
 
-    SceneLoader() = default;
+    SceneLoader(AssetRegistry& assets) : assets(assets) {}
 
-    void loadScene(std::string lightsDataPath, std::string modelsDataPath
+    // Returns false and prints error with its position in file if scene can't be loaded
+    bool loadScene(std::string lightsDataPath, std::string modelsDataPath
         , DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights
         , Models& models, Objects& objects);
 
-private:
-
-    DirectionalLight loadDirectionalLight(std::stringstream& lightData, bool& good);
-    PointLight loadPointLight(std::stringstream& lightData, bool& good);
-    SpotLight loadSpotLight(std::stringstream& lightData, bool& good);
-
-    int getModelIndex(std::string path, const Models& modles);
+    // Creates lights and objects from already parsed scene, loading models through asset registry
+    void loadScene(const SceneDescription& scene
+        , DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights
+        , Models& models, Objects& objects);
 
-    glm::vec3 getVec3(std::stringstream& data);   
+    // Creates lights and objects straight from snapshot records, values aren't validated
+    void loadScene(const SceneSnapshot& snapshot
+        , DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights
+        , Models& models, Objects& objects);
 
-    bool checkRangeVec3(glm::vec3 vector, double left, double right, string message);
-    bool checkAttenuation(double constant, double linear, double quadratic);
-    bool checkAngles(double cutOff, double outerCutOff);
-    bool checkScale(glm::vec3 scale);
+    // Applies changes found by SceneReloader, models which are already loaded are reused.
+    // Models no longer used by any object are removed from models, AssetRegistry::unloadUnused() releases them.
+    void applyChanges(const SceneDiff& diff
+        , DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights
+        , Models& models, Objects& objects);
 
-    void exitOnError();
+private:
+    template<typename Light>
+    static void applyLightChanges(const SceneDiff::LightChanges<Light>& changes, std::vector<Light>& lights);
 
+    AssetRegistry& assets;
 };
 
 #endif
-
@@ -0,0 +1,108 @@
+#ifndef SCENE_PARSER_H
+#define SCENE_PARSER_H
+
+#include <Lights/DirectionalLight.h>
+#include <Lights/PointLight.h>
+#include <Lights/SpotLight.h>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+// Placement of a model in the scene as it is written in scene description file
+struct ObjectDescription
+{
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+    std::uint32_t modelIndex; // index in SceneDescription::modelPaths
+};
+
+// Scene contents read from description files, without any loaded resources
+struct SceneDescription
+{
+    std::vector<DirectionalLight> dirLights;
+    std::vector<PointLight> pointLights;
+    std::vector<SpotLight> spotLights;
+    std::vector<ObjectDescription> objects;
+    std::vector<std::string> modelPaths; // every distinct path is stored once
+};
+
+// Thrown when scene description file is malformed or contains invalid values
+class SceneParseError : public std::runtime_error
+{
+public:
+    SceneParseError(const std::string& message, const std::string& file, int line, int column)
+        : std::runtime_error(message)
+        , _file(file)
+        , _line(line)
+        , _column(column)
+        {}
+
+    const std::string& getFile() const { return _file; }
+    int getLine() const { return _line; }
+    int getColumn() const { return _column; }
+
+private:
+    std::string _file;
+    int _line;
+    int _column;
+};
+
+// Parses LightData/ModelData files in place: file is memory mapped and numbers are read
+// straight from the mapped memory, without copying lines into temporary strings.
+class SceneParser
+{
+    static const glm::vec3::value_type  MIN_ALLOWED_POSITION;
+    static const glm::vec3::value_type  MAX_ALLOWED_POSITION;
+    static const glm::vec3::value_type  MIN_ALLOWED_COLOR;
+    static const glm::vec3::value_type  MAX_ALLOWED_COLOR;
+    static const float                  MIN_ALLOWED_DEGREES_ANGLE;
+    static const float                  MAX_ALLOWED_DEGREES_ANGLE;
+
+public:
+    // Parse whole files, throw SceneParseError on failure
+    static void parseLightsFile(const std::string& path, SceneDescription& scene);
+    static void parseObjectsFile(const std::string& path, SceneDescription& scene);
+
+    // Parser over data in memory, fileName is used only in error reports
+    SceneParser(const char* data, std::size_t size, const std::string& fileName);
+
+    void parseLights(SceneDescription& scene);
+    void parseObjects(SceneDescription& scene);
+
+private:
+    DirectionalLight parseDirectionalLight();
+    PointLight parsePointLight();
+    SpotLight parseSpotLight();
+
+    // Tokenizer
+    void skipSpaces();
+    void skipEmptyLines();
+    void nextLine();
+    bool atEnd() const { return _cursor == _end; }
+    float readFloat();
+    glm::vec3 readVec3Line();
+    std::string readLine();
+
+    // Validation, errors are reported at the position of the first value of checked record
+    void checkRangeVec3(glm::vec3 vector, double left, double right, const std::string& message, int line);
+    void checkAttenuation(double constant, double linear, double quadratic, int line);
+    void checkAngles(double cutOff, double outerCutOff, int line);
+    void checkScale(glm::vec3 scale, int line);
+
+    [[noreturn]] void error(const std::string& message) const;
+    [[noreturn]] void error(const std::string& message, int line, int column) const;
+
+private:
+    const char* _cursor;
+    const char* _end;
+    const char* _lineStart;
+    int _line = 1;
+    std::string _fileName;
+};
+
+#endif // !SCENE_PARSER_H
@@ -0,0 +1,97 @@
+#ifndef SCENE_RELOADER_H
+#define SCENE_RELOADER_H
+
+#include <Aliases.h>
+#include <SceneParser.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Changes of the scene files since previous reload.
+// Lights are matched by their index among lights of the same type.
+// Objects are matched by model path and number of occurrence of that path, so moving,
+// adding or removing one object doesn't disturb other objects with the same model.
+struct SceneDiff
+{
+    template<typename Light>
+    struct LightChanges
+    {
+        std::vector<std::pair<std::size_t, Light>> changed;
+        std::vector<Light> added;
+        std::size_t removed = 0; // number of lights removed from the end
+    };
+
+    struct ObjectChange
+    {
+        std::size_t index;
+        glm::vec3 position;
+        glm::vec3 rotation;
+        glm::vec3 scale;
+    };
+
+    LightChanges<DirectionalLight> dirLights;
+    LightChanges<PointLight> pointLights;
+    LightChanges<SpotLight> spotLights;
+
+    // Indices refer to live objects before the diff is applied
+    std::vector<ObjectChange> changedObjects;
+    std::vector<std::size_t> removedObjects; // ascending, removal keeps order of other objects
+    std::vector<ObjectDescription> addedObjects; // appended after remaining objects
+    std::vector<std::string> modelPaths;         // indexed by ObjectDescription::modelIndex
+
+    bool empty() const;
+};
+
+// Watches scene description files in background thread. When they change, files are parsed
+// and compared with the scene which is currently shown. Resulting diffs are queued until
+// the render thread takes them at frame boundary.
+class SceneReloader
+{
+    static const std::chrono::milliseconds POLL_INTERVAL;
+
+public:
+    // Starts watching, scene is the state live lights and objects were created from
+    SceneReloader(const std::string& lightsDataPath, const std::string& modelsDataPath, const SceneDescription& scene);
+
+    SceneReloader(const SceneReloader&) = delete;
+    SceneReloader& operator=(const SceneReloader&) = delete;
+
+    ~SceneReloader();
+
+    // Returns all diffs found since previous call, they must be applied in order
+    std::vector<SceneDiff> takePendingChanges();
+
+    // Describes live scene, so it can be compared with scene files
+    static SceneDescription describe(const DirectionalLights& dirLights, const PointLights& pointLights,
+                                     const SpotLights& spotLights, const Objects& objects);
+
+private:
+    void watch();
+
+    bool filesChanged();
+
+    // Computes changes turning current scene into next, current is updated to match the live scene after diff is applied
+    static SceneDiff makeDiff(SceneDescription& current, const SceneDescription& next);
+
+private:
+    std::string lightsDataPath;
+    std::string modelsDataPath;
+    std::filesystem::file_time_type lightsWriteTime;
+    std::filesystem::file_time_type modelsWriteTime;
+
+    SceneDescription current; // used only by watching thread
+
+    std::mutex mutex;
+    std::condition_variable stopCondition;
+    std::vector<SceneDiff> pending;
+    bool stopRequested = false;
+    std::thread watcher;
+};
+
+#endif // !SCENE_RELOADER_H
@@ -0,0 +1,120 @@
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include <Aliases.h>
+#include <MappedFile.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+
+// Binary snapshot of scene state which is used directly from mapped memory.
+//
+// Layout: SnapshotHeader followed by flat arrays of records. Arrays are referenced by byte offsets
+// from the beginning of the file, so the snapshot doesn't depend on the address it is mapped at.
+// Model paths are stored in a string table at the end of the file and objects refer to models by index.
+namespace snapshot
+{
+    const char          MAGIC[4] = { 'C', 'W', 'S', 'S' };
+    const std::uint32_t VERSION  = 2;
+
+    struct Header
+    {
+        char          magic[4];
+        std::uint32_t version;
+        std::uint32_t dirLightsNumber;
+        std::uint32_t pointLightsNumber;
+        std::uint32_t spotLightsNumber;
+        std::uint32_t objectsNumber;
+        std::uint32_t modelsNumber;
+        std::uint32_t stringsSize;
+        std::uint64_t dirLightsOffset;
+        std::uint64_t pointLightsOffset;
+        std::uint64_t spotLightsOffset;
+        std::uint64_t objectsOffset;
+        std::uint64_t modelsOffset;
+        std::uint64_t stringsOffset;
+    };
+
+    struct DirectionalLightRecord
+    {
+        glm::vec3 direction;
+        glm::vec3 color;
+    };
+
+    struct PointLightRecord
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+        float constant;
+        float linear;
+        float quadratic;
+    };
+
+    struct SpotLightRecord
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+        glm::vec3 direction;
+        float constant;
+        float linear;
+        float quadratic;
+        float cutOff;
+        float outerCutOff;
+    };
+
+    struct ObjectRecord
+    {
+        glm::vec3 position;
+        glm::vec3 rotation;
+        glm::vec3 scale;
+        std::uint32_t modelIndex;
+    };
+
+    struct ModelRecord
+    {
+        std::uint32_t pathOffset; // offset in string table
+        std::uint32_t pathLength;
+        std::uint32_t postProcessFlags;
+        std::uint32_t importSteps;
+    };
+}
+
+class SceneSnapshot
+{
+public:
+    // Writes current state of the scene, returns false if file can't be written.
+    // Existing file is replaced only after the whole snapshot is written, it mustn't be open by any SceneSnapshot.
+    static bool save(const std::string& path
+        , const DirectionalLights& dirLights, const PointLights& pointLights, const SpotLights& spotLights
+        , const Objects& objects);
+
+    SceneSnapshot() = default;
+
+    // Maps snapshot file, returns false if it doesn't exist or has another format version.
+    // Contents aren't validated: snapshot is expected to be written by save().
+    bool open(const std::string& path);
+
+    bool isOpen() const { return _header != nullptr; }
+
+    const snapshot::Header& getHeader() const { return *_header; }
+
+    const snapshot::DirectionalLightRecord* getDirLights() const { return records<snapshot::DirectionalLightRecord>(_header->dirLightsOffset); }
+    const snapshot::PointLightRecord* getPointLights() const { return records<snapshot::PointLightRecord>(_header->pointLightsOffset); }
+    const snapshot::SpotLightRecord* getSpotLights() const { return records<snapshot::SpotLightRecord>(_header->spotLightsOffset); }
+    const snapshot::ObjectRecord* getObjects() const { return records<snapshot::ObjectRecord>(_header->objectsOffset); }
+    const snapshot::ModelRecord* getModels() const { return records<snapshot::ModelRecord>(_header->modelsOffset); }
+
+    std::string getModelPath(const snapshot::ModelRecord& model) const;
+
+private:
+    template<typename Record>
+    const Record* records(std::uint64_t offset) const { return reinterpret_cast<const Record*>(_file.data() + offset); }
+
+private:
+    MappedFile _file;
+    const snapshot::Header* _header = nullptr;
+};
+
+#endif // !SCENE_SNAPSHOT_H
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 class Shader
 {
@@ -16,6 +17,10 @@ public:
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath);
+    // constructor of a program without rasterization, given outputs of its geometry shader
+    // are written to buffers with transform feedback, interleaved in one buffer
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* geometryPath, const std::vector<const char*>& feedbackVaryings);
 
     // activate the shader
     // ------------------------------------------------------------------------
@@ -0,0 +1,140 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <Objects/ObjectStore.h>
+#include <Aliases.h>
+#include <Camera.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// Moves camera, lights and animated objects in steps of fixed length, however fast frames are rendered.
+//
+// update() runs as many steps as real time passed since its previous call, so movement and its cost depend
+// only on time. Frames which took too long run at most maxSteps steps and the rest of lag is dropped,
+// so slow frames slow simulation down instead of making every next frame longer.
+// Steps rarely end exactly at the moment of a frame, so rendered state is interpolated between the last
+// two steps. Camera, lights and objects hold interpolated state between calls of update(), simulated state
+// is kept by Simulation and put back before the next steps.
+class Simulation
+{
+public:
+    // Called at every step before animations, e.g. to move camera by held keys. Step is in seconds.
+    using StepFunction = std::function<void(float step)>;
+
+    static const float DEFAULT_STEP;
+    static const int DEFAULT_MAX_STEPS = 5;
+
+    struct Statistics
+    {
+        std::size_t steps = 0;
+        std::size_t droppedSteps = 0;  // steps skipped because frames took too long
+        int frameSteps = 0;            // steps run by the last update()
+    };
+
+    Simulation(Camera& camera, PointLights& pointLights, SpotLights& spotLights, ObjectStore& objects,
+               float step = DEFAULT_STEP, int maxSteps = DEFAULT_MAX_STEPS);
+
+    void setStepFunction(StepFunction function) { stepFunction = std::move(function); }
+
+    // Moves light along horizontal circle around center, speed is in radians per second
+    void addLightOrbit(bool spot, std::size_t light, const glm::vec3& center, float radius, float speed);
+
+    void clearLightOrbits() { orbits.clear(); }
+
+    bool hasLightOrbits() const { return !orbits.empty(); }
+
+    // Rotates object at constant speed given in degrees per second around x, y and z axes.
+    // Objects which move shouldn't be static, otherwise static batches keep their old transforms.
+    void addObjectSpin(ObjectId object, const glm::vec3& speed);
+
+    // Returns false if object doesn't spin
+    bool removeObjectSpin(ObjectId object);
+
+    // Runs steps for time passed since the previous call, time is in seconds. Returns number of steps.
+    int update(double time);
+
+    // Takes current camera position, lights and objects as simulated state, e.g. after the scene was changed
+    void reset();
+
+    // Objects changed by the last update(), so their bounds can be refitted
+    const std::vector<std::size_t>& getMovedObjects() const { return movedObjects; }
+
+    float getStep() const { return step; }
+
+    // Simulated time in seconds
+    double getTime() const { return time; }
+
+    // Position of rendered state between the last two steps, from 0 to 1
+    float getAlpha() const { return alpha; }
+
+    const Statistics& getStatistics() const { return statistics; }
+
+    void printStatistics(std::ostream& out = std::cout) const;
+
+private:
+    struct LightOrbit
+    {
+        bool spot;
+        std::size_t light;
+        glm::vec3 center;
+        float radius;
+        float speed;
+        float angle;
+    };
+
+    struct ObjectSpin
+    {
+        ObjectId object;
+        glm::vec3 speed;
+        glm::vec3 rotation;
+        glm::vec3 previousRotation;
+    };
+
+    // Everything steps change which isn't kept by animations
+    struct State
+    {
+        glm::vec3 cameraPosition;
+        std::vector<glm::vec3> pointLights;
+        std::vector<glm::vec3> spotLights;
+    };
+
+    void capture(State& state) const;
+
+    void restore(const State& state);
+
+    void runStep();
+
+    // Leaves state between previous and current one in camera, lights and objects
+    void interpolate();
+
+private:
+    Camera& camera;
+    PointLights& pointLights;
+    SpotLights& spotLights;
+    ObjectStore& objects;
+
+    float step;
+    int maxSteps;
+    StepFunction stepFunction;
+
+    std::vector<LightOrbit> orbits;
+    std::vector<ObjectSpin> spins;
+
+    State previous;
+    State current;
+    std::vector<std::size_t> movedObjects;
+
+    bool started = false;
+    double lastTime = 0;
+    double lag = 0;     // real time not simulated yet
+    double time = 0;
+    float alpha = 0;
+    Statistics statistics;
+};
+
+#endif // !SIMULATION_H
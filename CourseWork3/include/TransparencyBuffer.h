@@ -0,0 +1,50 @@
+#ifndef TRANSPARENCY_BUFFER_H
+#define TRANSPARENCY_BUFFER_H
+
+#include <glad/glad.h>
+#include <Shader.h>
+
+// Weighted blended order-independent transparency (McGuire and Bavoil, 2013).
+//
+// Transparent surfaces are accumulated in any order into two targets: sum of weighted premultiplied colors
+// with product of (1 - alpha) in alpha channel, and sum of weighted alphas. Composite pass then blends
+// their average over opaque scene, so cost doesn't depend on how many transparent surfaces overlap.
+// Single blend function serves both targets, so only GL 3.3 is needed.
+class TransparencyBuffer
+{
+public:
+    TransparencyBuffer(int width, int height);
+
+    TransparencyBuffer(const TransparencyBuffer&) = delete;
+    TransparencyBuffer& operator=(const TransparencyBuffer&) = delete;
+
+    ~TransparencyBuffer();
+
+    // Recreates targets if size changed
+    void resize(int width, int height);
+
+    // Copies depth of opaque geometry from default framebuffer, clears targets and sets up blending.
+    // Transparent surfaces drawn after it must write both targets.
+    void begin();
+
+    // Binds default framebuffer and accumulated targets to units 0 and 1 of composite shader,
+    // full screen quad drawn after it blends transparent surfaces over the scene
+    void beginComposite(const Shader& shader);
+
+    // Restores blending, depth and texture state
+    void end();
+
+private:
+    void create();
+    void destroy();
+
+private:
+    int width;
+    int height;
+    unsigned int framebuffer = 0;
+    unsigned int accumulationTexture = 0; // weighted premultiplied color and revealage
+    unsigned int weightTexture = 0;       // sum of weighted alphas
+    unsigned int depthBuffer = 0;
+};
+
+#endif // !TRANSPARENCY_BUFFER_H
@@ -1,14 +1,20 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
-//layout (location = 1) in vec3 aNormal;
-//dlayout (location = 2) in vec2 aTexCoords;
+// per-instance attributes, see LightGizmos
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in vec3 aColor;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+out vec3 LightColor;
+
+// the same for all programs drawing the scene, see CameraBuffer
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    LightColor = aColor;
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
 }
 
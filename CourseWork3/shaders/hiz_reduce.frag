@@ -0,0 +1,30 @@
+#version 330 core
+// keeps the farthest depth of source texels covered by output texel, see OcclusionCuller
+out float Depth;
+
+// previous level of the pyramid, its base level is set to the one being read
+uniform sampler2D source;
+
+void main()
+{
+    ivec2 sourceSize = textureSize(source, 0);
+    ivec2 outputSize = max(sourceSize / 2, ivec2(1));
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    // the last row and column also cover the remainder of odd sizes
+    ivec2 first = texel * 2;
+    ivec2 last = first + 1;
+    if (texel.x == outputSize.x - 1)
+        last.x = sourceSize.x - 1;
+    if (texel.y == outputSize.y - 1)
+        last.y = sourceSize.y - 1;
+    last = min(last, sourceSize - 1);
+
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+    {
+        for (int x = first.x; x <= last.x; ++x)
+            depth = max(depth, texelFetch(source, ivec2(x, y), 0).r);
+    }
+    Depth = depth;
+}
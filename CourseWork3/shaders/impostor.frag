@@ -0,0 +1,65 @@
+#version 330 core
+
+struct DirLight {
+    vec3 direction;
+    vec3 color;
+};
+
+out vec4 FragColor;
+
+const float PI                      = 3.14159265359;
+const int   MAX_DIR_LIGHTS_NUMBER   = 4;
+
+in vec2 TexCoords;
+in vec3 QuadPos;
+flat in float Layer;
+flat in vec3 FrameDirection;
+flat in vec4 Rotation;
+flat in float Radius;
+
+uniform sampler2DArray impostorAlbedo;
+uniform sampler2DArray impostorNormalDepth;
+
+// the same for all programs drawing the scene, see CameraBuffer
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
+
+// distant objects are lit by directional lights only, local lights barely reach them
+uniform int dirLightsNumber;
+uniform DirLight dirLights[MAX_DIR_LIGHTS_NUMBER];
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+    vec4 albedo = texture(impostorAlbedo, vec3(TexCoords, Layer));
+    if (albedo.a < 0.5)
+        discard;
+    vec4 normalDepth = texture(impostorNormalDepth, vec3(TexCoords, Layer));
+
+    // restore position of the surface, so impostors intersect with other geometry correctly
+    vec3 surface = QuadPos + FrameDirection * Radius * (1.0 - 2.0 * normalDepth.a);
+    vec4 clip = projection * view * vec4(surface, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    vec3 normal = normalize(rotate(Rotation, normalDepth.rgb * 2.0 - 1.0));
+    vec3 color = pow(albedo.rgb, vec3(2.2));
+
+    // diffuse part of the pbr shader
+    vec3 Lo = vec3(0.0);
+    for (int i = 0; i < dirLightsNumber; ++i)
+        Lo += color / PI * dirLights[i].color * max(dot(normal, normalize(-dirLights[i].direction)), 0.0);
+    vec3 result = vec3(0.03) * color + Lo;
+
+    // HDR tonemapping
+    result = result / (result + vec3(1.0));
+    // gamma correct
+    result = pow(result, vec3(1.0/2.2));
+
+    FragColor = vec4(result, 1.0);
+}
@@ -0,0 +1,66 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;   // corner of unit quad
+layout (location = 1) in vec4 aSphere;   // bounding sphere of the object in world space
+layout (location = 2) in vec4 aRotation; // rotation of the object as quaternion (x, y, z, w)
+layout (location = 3) in float aLayer;   // layer of texture arrays with atlas of the model
+
+out vec2 TexCoords;
+out vec3 QuadPos;
+flat out float Layer;
+flat out vec3 FrameDirection;
+flat out vec4 Rotation;
+flat out float Radius;
+
+// the same for all programs drawing the scene, see CameraBuffer
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
+uniform vec3 cameraPos;
+uniform int framesNumber;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// octahedral mapping of directions into [-1, 1] square, must match ImpostorRenderer
+vec2 octahedralEncode(vec3 direction)
+{
+    vec2 point = direction.xy / (abs(direction.x) + abs(direction.y) + abs(direction.z));
+    if (direction.z < 0.0)
+        point = (1.0 - abs(point.yx)) * vec2(point.x >= 0.0 ? 1.0 : -1.0, point.y >= 0.0 ? 1.0 : -1.0);
+    return point;
+}
+
+vec3 octahedralDecode(vec2 point)
+{
+    vec3 direction = vec3(point, 1.0 - abs(point.x) - abs(point.y));
+    if (direction.z < 0.0)
+        direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(direction);
+}
+
+void main()
+{
+    // view direction in model space picks the nearest baked view
+    vec4 inverseRotation = vec4(-aRotation.xyz, aRotation.w);
+    vec3 toCamera = rotate(inverseRotation, normalize(cameraPos - aSphere.xyz));
+    ivec2 frame = clamp(ivec2((octahedralEncode(toCamera) * 0.5 + 0.5) * framesNumber), ivec2(0), ivec2(framesNumber - 1));
+    vec3 direction = octahedralDecode((vec2(frame) + 0.5) / framesNumber * 2.0 - 1.0);
+
+    // quad is oriented the same way as camera was when the view was baked
+    vec3 up = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up, direction));
+    up = cross(direction, right);
+    vec3 offset = (right * aCorner.x + up * aCorner.y) * aSphere.w;
+
+    TexCoords = (vec2(frame) + aCorner * 0.5 + 0.5) / framesNumber;
+    QuadPos = aSphere.xyz + rotate(aRotation, offset);
+    Layer = aLayer;
+    FrameDirection = rotate(aRotation, direction);
+    Rotation = aRotation;
+    Radius = aSphere.w;
+
+    gl_Position = projection * view * vec4(QuadPos, 1.0);
+}
@@ -0,0 +1,50 @@
+#version 330 core
+// renders one view of impostor atlas, used together with pbr.vert in model space
+
+layout (location = 0) out vec4 Albedo;      // alpha marks covered pixels
+layout (location = 1) out vec4 NormalDepth; // model space normal and depth along the view
+
+in vec2 TexCoords;
+in vec3 WorldPos;
+in vec3 Normal;
+flat in uint MaterialIndex;
+
+const int MAX_MATERIALS      = 256; // MaterialLibrary::MAX_MATERIALS
+const int MAX_TEXTURE_ARRAYS = 8;   // TexturePool::MAX_ARRAYS
+
+// the same block as in pbr.frag, only albedo map is used here
+struct MaterialData {
+    ivec4 albedoNormal;
+    ivec4 metallicRoughness;
+    vec4  properties;
+};
+
+layout (std140) uniform Materials {
+    MaterialData materials[MAX_MATERIALS];
+};
+
+uniform sampler2DArray textureArrays[MAX_TEXTURE_ARRAYS];
+
+vec3 sampleAlbedo(ivec2 map)
+{
+    vec3 coords = vec3(TexCoords, map.y);
+    switch (map.x)
+    {
+        case 0: return texture(textureArrays[0], coords).rgb;
+        case 1: return texture(textureArrays[1], coords).rgb;
+        case 2: return texture(textureArrays[2], coords).rgb;
+        case 3: return texture(textureArrays[3], coords).rgb;
+        case 4: return texture(textureArrays[4], coords).rgb;
+        case 5: return texture(textureArrays[5], coords).rgb;
+        case 6: return texture(textureArrays[6], coords).rgb;
+        case 7: return texture(textureArrays[7], coords).rgb;
+    }
+    return vec3(1.0);
+}
+
+void main()
+{
+    Albedo = vec4(sampleAlbedo(materials[MaterialIndex].albedoNormal.xy), 1.0);
+    // orthographic projection, so window depth is linear
+    NormalDepth = vec4(normalize(Normal) * 0.5 + 0.5, gl_FragCoord.z);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+// passes bounding spheres of instances to instance_cull.geom, see InstanceCuller
+layout (location = 0) in vec4 aSphere; // center in xyz and radius in w, world space
+
+out vec4 Sphere;
+flat out uint Index;
+
+void main()
+{
+    Sphere = aSphere;
+    // draws start at the first instance of their model, so vertex id is index of the instance
+    Index = uint(gl_VertexID);
+}
@@ -0,0 +1,8 @@
+#version 330 core
+out vec4 FragColor;
+
+// Color writes are disabled, only samples passing depth test are counted
+void main()
+{
+    FragColor = vec4(1.0);
+}
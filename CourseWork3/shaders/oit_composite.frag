@@ -0,0 +1,20 @@
+#version 330 core
+// blends average color of transparent surfaces over opaque scene, see TransparencyBuffer
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D accumulation; // weighted premultiplied color, alpha is product of (1 - alpha)
+uniform sampler2D weights;      // sum of weighted alphas in red channel
+
+void main()
+{
+    vec4 accumulated = texture(accumulation, TexCoords);
+    float revealage = accumulated.a;
+    // pixel isn't covered by transparent surfaces
+    if (revealage >= 1.0)
+        discard;
+
+    vec3 averageColor = accumulated.rgb / max(texture(weights, TexCoords).r, 1e-5);
+    FragColor = vec4(averageColor, 1.0 - revealage);
+}
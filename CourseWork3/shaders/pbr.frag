@@ -34,31 +34,44 @@ struct Material {
     float roughness;
 };
 
-// output color
-out vec4 FragColor;
+// output color, for weighted blended transparency it is weighted premultiplied color and alpha
+layout (location = 0) out vec4 FragColor;
+// sum of weights of transparent surfaces, written only with weightedBlended
+layout (location = 1) out vec4 Weights;
 
 const float PI                      = 3.14159265359;
 const int   MAX_DIR_LIGHTS_NUMBER   = 4;
 const int   MAX_POINT_LIGHTS_NUMBER = 32;
 const int   MAX_SPOT_LIGHTS_NUMBER  = 32;
+const int   MAX_MATERIALS           = 256; // MaterialLibrary::MAX_MATERIALS
+const int   MAX_TEXTURE_ARRAYS      = 8;   // TexturePool::MAX_ARRAYS
 
 // input data
 in vec2 TexCoords;
 in vec3 WorldPos;
 in vec3 Normal;
+flat in uint MaterialIndex;
 
-// material maps
-uniform sampler2D texture_albedo1;
-uniform sampler2D texture_normal1;
-uniform sampler2D texture_metallic1;
-uniform sampler2D texture_roughness1;
-uniform float opacityRatio;
-uniform float refractionRatio;
+// material maps are given as texture array index and layer, index is negative if there is no map
+struct MaterialData {
+    ivec4 albedoNormal;
+    ivec4 metallicRoughness;
+    vec4  properties; // opacity ratio, refraction ratio
+};
+
+layout (std140) uniform Materials {
+    MaterialData materials[MAX_MATERIALS];
+};
+
+uniform sampler2DArray textureArrays[MAX_TEXTURE_ARRAYS];
 
 uniform vec3 cameraPos;
 
 uniform samplerCube skybox;
 
+// transparent surfaces are accumulated into TransparencyBuffer instead of being drawn over the scene
+uniform bool weightedBlended;
+
 uniform int dirLightsNumber;
 uniform DirLight dirLights[MAX_DIR_LIGHTS_NUMBER];
 uniform int pointLightsNumber;
@@ -66,9 +79,30 @@ uniform PointLight pointLights[MAX_POINT_LIGHTS_NUMBER];
 uniform int spotLightsNumber;
 uniform SpotLight spotLights[MAX_SPOT_LIGHTS_NUMBER];
 
-vec3 getNormalFromMap()
+vec4 sampleMap(ivec2 map, vec4 defaultValue)
 {
-    vec3 tangentNormal = texture(texture_normal1, TexCoords).xyz * 2.0 - 1.0;
+    // GLSL 3.30 allows only constant indices of sampler arrays
+    vec3 coords = vec3(TexCoords, map.y);
+    switch (map.x)
+    {
+        case 0: return texture(textureArrays[0], coords);
+        case 1: return texture(textureArrays[1], coords);
+        case 2: return texture(textureArrays[2], coords);
+        case 3: return texture(textureArrays[3], coords);
+        case 4: return texture(textureArrays[4], coords);
+        case 5: return texture(textureArrays[5], coords);
+        case 6: return texture(textureArrays[6], coords);
+        case 7: return texture(textureArrays[7], coords);
+    }
+    return defaultValue;
+}
+
+vec3 getNormalFromMap(ivec2 map)
+{
+    if (map.x < 0)
+        return normalize(Normal);
+
+    vec3 tangentNormal = sampleMap(map, vec4(0.0)).xyz * 2.0 - 1.0;
 
     vec3 Q1  = dFdx(WorldPos);
     vec3 Q2  = dFdy(WorldPos);
@@ -210,11 +244,15 @@ vec3 calcSpotLight(SpotLight light, Material material, vec3 fragmentPositon, vec
 // ----------------------------------------------------------------------------
 void main()
 {		
+    MaterialData data = materials[MaterialIndex];
+    float opacityRatio = data.properties.x;
+    float refractionRatio = data.properties.y;
+
     Material material;
-    material.albedo    = pow(texture(texture_albedo1, TexCoords).rgb, vec3(2.2));
-    material.metallic  = texture(texture_metallic1, TexCoords).r;
-    material.roughness = texture(texture_roughness1, TexCoords).r;
-    material.normal    = getNormalFromMap();
+    material.albedo    = pow(sampleMap(data.albedoNormal.xy, vec4(1.0)).rgb, vec3(2.2));
+    material.metallic  = sampleMap(data.metallicRoughness.xy, vec4(0.0)).r;
+    material.roughness = sampleMap(data.metallicRoughness.zw, vec4(1.0)).r;
+    material.normal    = getNormalFromMap(data.albedoNormal.zw);
 
     vec3 directionToView = normalize(cameraPos - WorldPos);
 
@@ -252,5 +290,19 @@ void main()
     // gamma correct
     color = pow(color, vec3(1.0/2.2)); 
 
-    FragColor = vec4(color, 1.0);
+    if (!weightedBlended)
+    {
+        FragColor = vec4(color, 1.0);
+        Weights = vec4(0.0);
+        return;
+    }
+
+    // refracted skybox stays in color, the rest of the scene shows through by opacity.
+    // Weight favours close and opaque surfaces: alpha is boosted tenfold, so surfaces above 0.1 opacity weigh alike,
+    // and window depth is remapped to 1 .. 0.1 and cubed. Constants keep the sum of weights within half float range.
+    float alpha = opacityRatio;
+    float depthFactor = 1.0 - gl_FragCoord.z * 0.9;
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(depthFactor, 3.0), 1e-2, 3e3);
+    FragColor = vec4(color * alpha * weight, alpha);
+    Weights = vec4(alpha * weight, 0.0, 0.0, alpha);
 }
\ No newline at end of file
@@ -4,21 +4,45 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in uint aMaterial; // index in Materials block, the same for the whole draw
+layout (location = 4) in uint aInstance; // index of instance transform, read only by instanced draws
 
 out vec2 TexCoords;
 out vec3 WorldPos;
 out vec3 Normal;
+flat out uint MaterialIndex;
 
-uniform mat4 projection;
-uniform mat4 view;
+// the same for all programs drawing the scene, see CameraBuffer
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+};
 uniform mat4 model;
 uniform mat3 normalMatrix;
 
+// instanced draws take model matrices from the buffer, four texels per matrix (see InstanceCuller)
+uniform bool instanced;
+uniform samplerBuffer instanceTransforms;
+
+// compact vertices store positions normalized to mesh bounds, for others scale is 1 and offset is 0
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
 void main()
 {
     TexCoords = aTexCoords; 
-    WorldPos = vec3(model * vec4(aPos, 1.0));          
-    Normal = normalMatrix * aNormal; // Fix normals in case of non-uniform model scaling
+    MaterialIndex = aMaterial;
+    mat4 instanceModel = model;
+    mat3 instanceNormalMatrix = normalMatrix;
+    if (instanced)
+    {
+        int first = int(aInstance) * 4;
+        instanceModel = mat4(texelFetch(instanceTransforms, first), texelFetch(instanceTransforms, first + 1),
+                             texelFetch(instanceTransforms, first + 2), texelFetch(instanceTransforms, first + 3));
+        instanceNormalMatrix = transpose(inverse(mat3(instanceModel)));
+    }
+    WorldPos = vec3(instanceModel * vec4(aPos * positionScale + positionOffset, 1.0));          
+    Normal = instanceNormalMatrix * aNormal; // Fix normals in case of non-uniform model scaling
 
     gl_Position =  projection * view * vec4(WorldPos, 1.0);
 }
\ No newline at end of file
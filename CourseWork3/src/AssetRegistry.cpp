@@ -0,0 +1,136 @@
+#include <AssetRegistry.h>
+#include <JobSystem.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <unordered_set>
+
+using namespace std;
+
+shared_ptr<Model> AssetRegistry::getModel(const string& path, const ModelImportOptions& options)
+{
+    string normalizedPath = normalizePath(path);
+    string key = makeKey(normalizedPath, options);
+
+    auto it = _assets.find(key);
+    if (it != _assets.end())
+        return it->second.model;
+
+    auto start = chrono::steady_clock::now();
+    shared_ptr<Model> model = make_shared<Model>(path, options);
+    auto finish = chrono::steady_clock::now();
+    return add(key, normalizedPath, options, move(model), chrono::duration<double, milli>(finish - start).count());
+}
+
+void AssetRegistry::preload(const vector<pair<string, ModelImportOptions>>& requests)
+{
+    struct Import
+    {
+        string key;
+        string normalizedPath;
+        string path;
+        ModelImportOptions options;
+        ImportedModel model;
+        double time = 0;
+    };
+
+    // every model which isn't loaded yet is imported once
+    vector<Import> imports;
+    unordered_set<string> keys;
+    for (const auto& request : requests)
+    {
+        string normalizedPath = normalizePath(request.first);
+        string key = makeKey(normalizedPath, request.second);
+        if (_assets.count(key) != 0 || !keys.insert(key).second)
+            continue;
+        imports.push_back({ key, normalizedPath, request.first, request.second, ImportedModel(), 0.0 });
+    }
+
+    vector<JobSystem::JobHandle> jobs;
+    jobs.reserve(imports.size());
+    for (Import& import : imports)
+    {
+        jobs.push_back(JobSystem::schedule([&import]()
+        {
+            auto start = chrono::steady_clock::now();
+            import.model = Model::import(import.path, import.options);
+            auto finish = chrono::steady_clock::now();
+            import.time = chrono::duration<double, milli>(finish - start).count();
+        }));
+    }
+    JobSystem::wait(jobs);
+
+    // geometry and textures are uploaded by the thread with GL context
+    for (Import& import : imports)
+    {
+        auto start = chrono::steady_clock::now();
+        shared_ptr<Model> model = make_shared<Model>(move(import.model));
+        auto finish = chrono::steady_clock::now();
+        double time = import.time + chrono::duration<double, milli>(finish - start).count();
+        add(import.key, import.normalizedPath, import.options, move(model), time);
+    }
+}
+
+size_t AssetRegistry::unloadUnused()
+{
+    size_t unloaded = 0;
+    for (auto it = _assets.begin(); it != _assets.end();)
+    {
+        if (it->second.model.use_count() == 1)
+        {
+            cout << "ASSET_REGISTRY:: unloaded " << it->second.info.path << endl;
+            it = _assets.erase(it);
+            ++unloaded;
+        }
+        else
+            ++it;
+    }
+    return unloaded;
+}
+
+const AssetInfo* AssetRegistry::getInfo(const string& path, const ModelImportOptions& options) const
+{
+    auto it = _assets.find(makeKey(normalizePath(path), options));
+    return it != _assets.end() ? &it->second.info : nullptr;
+}
+
+void AssetRegistry::printStatistics(ostream& out) const
+{
+    double totalTime = 0;
+    size_t totalMemory = 0;
+    for (const auto& asset : _assets)
+    {
+        const AssetInfo& info = asset.second.info;
+        out << "ASSET_REGISTRY:: " << info.path
+            << " load time: " << fixed << setprecision(2) << info.loadTime << " ms"
+            << ", memory: " << info.memory / 1024 << " KB" << endl;
+        totalTime += info.loadTime;
+        totalMemory += info.memory;
+    }
+    out << "ASSET_REGISTRY:: total assets: " << _assets.size()
+        << ", load time: " << fixed << setprecision(2) << totalTime << " ms"
+        << ", memory: " << totalMemory / 1024 << " KB" << endl;
+}
+
+string AssetRegistry::normalizePath(const string& path)
+{
+    return filesystem::absolute(filesystem::path(path)).lexically_normal().generic_string();
+}
+
+string AssetRegistry::makeKey(const string& normalizedPath, const ModelImportOptions& options)
+{
+    return normalizedPath + '|' + to_string(options.postProcessFlags) + '|' + to_string(options.importSteps);
+}
+
+const shared_ptr<Model>& AssetRegistry::add(const string& key, const string& normalizedPath, const ModelImportOptions& options,
+                                            shared_ptr<Model> model, double loadTime)
+{
+    Entry entry;
+    entry.model = move(model);
+    entry.info.path = normalizedPath;
+    entry.info.options = options;
+    entry.info.loadTime = loadTime;
+    entry.info.memory = entry.model->getMemoryUsage();
+    return _assets.emplace(key, move(entry)).first->second.model;
+}
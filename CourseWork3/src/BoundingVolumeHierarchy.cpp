@@ -0,0 +1,492 @@
+#include <BoundingVolumeHierarchy.h>
+#include <JobSystem.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+    const unsigned int MAX_LEAF_OBJECTS = 4;
+    // larger nodes are split even when heuristic prefers a leaf, so leaves stay short
+    const unsigned int MAX_SAH_LEAF_OBJECTS = 16;
+    const unsigned int BINS_NUMBER = 12;
+    // traversal stack of queries is fixed, deeper nodes become leaves
+    const unsigned int MAX_DEPTH = 64;
+
+    // relative costs of visiting a node and testing an object in surface area heuristic
+    const float TRAVERSAL_COST = 1.0f;
+    const float INTERSECTION_COST = 1.0f;
+
+    const unsigned int NO_PARENT = ~0u;
+
+    // frustum queries of smaller trees run on one thread, larger ones are split into this many subtrees per thread
+    const size_t PARALLEL_QUERY_MIN_OBJECTS = 4096;
+    const size_t SUBTREES_PER_THREAD = 4;
+
+    struct Box
+    {
+        glm::vec3 boxMin = glm::vec3(numeric_limits<float>::max());
+        glm::vec3 boxMax = glm::vec3(-numeric_limits<float>::max());
+
+        void grow(const glm::vec3& point)
+        {
+            boxMin = glm::min(boxMin, point);
+            boxMax = glm::max(boxMax, point);
+        }
+
+        void grow(const glm::vec4& sphere)
+        {
+            boxMin = glm::min(boxMin, glm::vec3(sphere) - sphere.w);
+            boxMax = glm::max(boxMax, glm::vec3(sphere) + sphere.w);
+        }
+
+        void grow(const Box& box)
+        {
+            boxMin = glm::min(boxMin, box.boxMin);
+            boxMax = glm::max(boxMax, box.boxMax);
+        }
+
+        // half of surface area, the factor doesn't matter for comparisons
+        float area() const
+        {
+            if (boxMin.x > boxMax.x)
+                return 0.0f;
+            glm::vec3 size = boxMax - boxMin;
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+    };
+
+    bool overlaps(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax)
+    {
+        return aMin.x <= bMax.x && aMax.x >= bMin.x
+            && aMin.y <= bMax.y && aMax.y >= bMin.y
+            && aMin.z <= bMax.z && aMax.z >= bMin.z;
+    }
+
+    bool overlaps(const glm::vec4& sphere, const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        glm::vec3 closest = glm::clamp(glm::vec3(sphere), boxMin, boxMax);
+        glm::vec3 offset = closest - glm::vec3(sphere);
+        return glm::dot(offset, offset) <= sphere.w * sphere.w;
+    }
+
+    bool overlaps(const glm::vec4& a, const glm::vec4& b)
+    {
+        glm::vec3 offset = glm::vec3(a) - glm::vec3(b);
+        float radius = a.w + b.w;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    // Distance along the ray where it enters the box, or infinity if it misses it
+    float intersectBox(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance,
+                       const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        glm::vec3 t0 = (boxMin - origin) * inverseDirection;
+        glm::vec3 t1 = (boxMax - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = max(max(tNear.x, tNear.y), max(tNear.z, 0.0f));
+        float exit = min(min(tFar.x, tFar.y), min(tFar.z, maxDistance));
+        return enter <= exit ? enter : numeric_limits<float>::infinity();
+    }
+
+    // Distance along the ray where it enters the sphere, 0 if origin is inside
+    float intersectSphere(const glm::vec3& origin, const glm::vec3& direction, const glm::vec4& sphere)
+    {
+        glm::vec3 offset = origin - glm::vec3(sphere);
+        float b = glm::dot(offset, direction);
+        float c = glm::dot(offset, offset) - sphere.w * sphere.w;
+        if (c <= 0.0f)
+            return 0.0f;
+        float discriminant = b * b - c;
+        if (b > 0.0f || discriminant < 0.0f)
+            return numeric_limits<float>::infinity();
+        return -b - sqrt(discriminant);
+    }
+}
+
+void BoundingVolumeHierarchy::build(const ObjectStore& objects)
+{
+    clear();
+    if (objects.empty())
+        return;
+
+    spheres = objects.getBoundingSpheres();
+
+    items.resize(objects.size());
+    for (unsigned int i = 0; i < items.size(); ++i)
+        items[i] = i;
+    leaves.resize(objects.size());
+
+    // binary tree with n leaves has at most 2n - 1 nodes
+    nodes.reserve(2 * objects.size() - 1);
+    nodes.push_back(Node());
+    buildNode(0, NO_PARENT, 0, static_cast<unsigned int>(items.size()), 0);
+
+    for (unsigned int item : items)
+        itemSpheres.push_back(spheres[item]);
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+    nodes.clear();
+    items.clear();
+    spheres.clear();
+    itemSpheres.clear();
+    leaves.clear();
+    depth = 0;
+}
+
+void BoundingVolumeHierarchy::buildNode(unsigned int index, unsigned int parent, unsigned int first, unsigned int count, unsigned int level)
+{
+    depth = max(depth, level);
+
+    Box bounds;
+    Box centroids;
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        bounds.grow(spheres[items[i]]);
+        centroids.grow(glm::vec3(spheres[items[i]]));
+    }
+    nodes[index] = { bounds.boxMin, bounds.boxMax, 0, first, count, parent };
+
+    auto makeLeaf = [&]()
+    {
+        for (unsigned int i = first; i < first + count; ++i)
+            leaves[items[i]] = index;
+    };
+
+    if (count <= MAX_LEAF_OBJECTS || level + 1 >= MAX_DEPTH)
+    {
+        makeLeaf();
+        return;
+    }
+
+    // centroids are split along the longest axis
+    glm::vec3 extent = centroids.boxMax - centroids.boxMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    if (extent[axis] <= 0.0f)
+    {
+        makeLeaf();
+        return;
+    }
+
+    // objects are counted in bins along the axis and every boundary between bins is evaluated
+    Box binBounds[BINS_NUMBER];
+    unsigned int binCounts[BINS_NUMBER] = {};
+    float binScale = BINS_NUMBER / extent[axis];
+    auto binOf = [&](unsigned int item)
+    {
+        unsigned int bin = static_cast<unsigned int>((spheres[item][axis] - centroids.boxMin[axis]) * binScale);
+        return min(bin, BINS_NUMBER - 1);
+    };
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        unsigned int bin = binOf(items[i]);
+        binBounds[bin].grow(spheres[items[i]]);
+        ++binCounts[bin];
+    }
+
+    // areas and counts on the left of each boundary, right side is accumulated in the second loop
+    float leftAreas[BINS_NUMBER - 1];
+    unsigned int leftCounts[BINS_NUMBER - 1];
+    Box left;
+    unsigned int leftCount = 0;
+    for (unsigned int i = 0; i + 1 < BINS_NUMBER; ++i)
+    {
+        left.grow(binBounds[i]);
+        leftCount += binCounts[i];
+        leftAreas[i] = left.area();
+        leftCounts[i] = leftCount;
+    }
+
+    float bestCost = numeric_limits<float>::max();
+    unsigned int bestSplit = 0;
+    Box right;
+    unsigned int rightCount = 0;
+    for (unsigned int i = BINS_NUMBER - 1; i > 0; --i)
+    {
+        right.grow(binBounds[i]);
+        rightCount += binCounts[i];
+        if (leftCounts[i - 1] == 0 || rightCount == 0)
+            continue;
+        float cost = leftAreas[i - 1] * leftCounts[i - 1] + right.area() * rightCount;
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = i;
+        }
+    }
+
+    float leafCost = INTERSECTION_COST * count;
+    float splitCost = TRAVERSAL_COST + INTERSECTION_COST * bestCost / max(bounds.area(), numeric_limits<float>::min());
+    if (bestSplit == 0 || (splitCost >= leafCost && count <= MAX_SAH_LEAF_OBJECTS))
+    {
+        makeLeaf();
+        return;
+    }
+
+    unsigned int* middle = partition(items.data() + first, items.data() + first + count,
+                                     [&](unsigned int item) { return binOf(item) < bestSplit; });
+    unsigned int leftSize = static_cast<unsigned int>(middle - (items.data() + first));
+
+    // children are allocated together, so the right one is always next to the left one
+    unsigned int leftNode = static_cast<unsigned int>(nodes.size());
+    nodes[index].left = leftNode;
+    nodes.resize(nodes.size() + 2);
+    buildNode(leftNode, index, first, leftSize, level + 1);
+    buildNode(leftNode + 1, index, first + leftSize, count - leftSize, level + 1);
+}
+
+void BoundingVolumeHierarchy::update(size_t object, const glm::vec4& sphere)
+{
+    spheres[object] = sphere;
+    const Node& leaf = nodes[leaves[object]];
+    for (unsigned int i = leaf.first; i < leaf.first + leaf.count; ++i)
+    {
+        if (items[i] == object)
+            itemSpheres.set(i, sphere);
+    }
+    // ancestors whose bounds don't change stop the refit
+    for (unsigned int node = leaves[object]; node != NO_PARENT && fitNode(node); node = nodes[node].parent)
+        ;
+}
+
+void BoundingVolumeHierarchy::refit(const ObjectStore& objects)
+{
+    spheres = objects.getBoundingSpheres();
+    for (size_t i = 0; i < items.size(); ++i)
+        itemSpheres.set(i, spheres[items[i]]);
+    // children follow their parents, so going backwards fits every child before its parent
+    for (size_t i = nodes.size(); i > 0; --i)
+        fitNode(static_cast<unsigned int>(i - 1));
+}
+
+bool BoundingVolumeHierarchy::fitNode(unsigned int index)
+{
+    Node& node = nodes[index];
+    Box bounds;
+    if (node.left == 0)
+    {
+        for (unsigned int i = node.first; i < node.first + node.count; ++i)
+            bounds.grow(spheres[items[i]]);
+    }
+    else
+    {
+        bounds.grow(Box{ nodes[node.left].boxMin, nodes[node.left].boxMax });
+        bounds.grow(Box{ nodes[node.left + 1].boxMin, nodes[node.left + 1].boxMax });
+    }
+
+    if (bounds.boxMin == node.boxMin && bounds.boxMax == node.boxMax)
+        return false;
+    node.boxMin = bounds.boxMin;
+    node.boxMax = bounds.boxMax;
+    return true;
+}
+
+void BoundingVolumeHierarchy::queryFrustum(const Frustum& frustum, vector<size_t>& result) const
+{
+    if (nodes.empty())
+        return;
+    if (JobSystem::getThreadsNumber() == 1 || items.size() < PARALLEL_QUERY_MIN_OBJECTS)
+    {
+        querySubtree(frustum, 0, result);
+        return;
+    }
+
+    // nodes crossing frustum are split breadth first until there are enough subtrees for all threads
+    size_t subtreesNumber = JobSystem::getThreadsNumber() * SUBTREES_PER_THREAD;
+    deque<unsigned int> pending = { 0 };
+    vector<unsigned int> subtrees;
+    while (!pending.empty() && pending.size() + subtrees.size() < subtreesNumber)
+    {
+        unsigned int index = pending.front();
+        pending.pop_front();
+        const Node& node = nodes[index];
+        Frustum::Containment containment = frustum.classify(node.boxMin, node.boxMax);
+        if (containment == Frustum::OUTSIDE)
+            continue;
+        if (containment == Frustum::INSIDE)
+            appendSubtree(node, result);
+        else if (node.left == 0)
+            subtrees.push_back(index);
+        else
+        {
+            pending.push_back(node.left);
+            pending.push_back(node.left + 1);
+        }
+    }
+    subtrees.insert(subtrees.end(), pending.begin(), pending.end());
+
+    vector<vector<size_t>> subtreeResults(subtrees.size());
+    JobSystem::parallelFor(subtrees.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            querySubtree(frustum, subtrees[i], subtreeResults[i]);
+    });
+    for (const vector<size_t>& subtreeResult : subtreeResults)
+        result.insert(result.end(), subtreeResult.begin(), subtreeResult.end());
+}
+
+void BoundingVolumeHierarchy::querySubtree(const Frustum& frustum, unsigned int root, vector<size_t>& result) const
+{
+    unsigned int visible[MAX_SAH_LEAF_OBJECTS];
+    unsigned int stack[MAX_DEPTH + 1];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = root;
+    while (stackSize != 0)
+    {
+        const Node& node = nodes[stack[--stackSize]];
+        Frustum::Containment containment = frustum.classify(node.boxMin, node.boxMax);
+        if (containment == Frustum::OUTSIDE)
+            continue;
+        if (containment == Frustum::INSIDE)
+        {
+            appendSubtree(node, result);
+            continue;
+        }
+
+        if (node.left != 0)
+        {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.left + 1;
+            continue;
+        }
+        // leaves of coincident objects or at the depth limit may be longer than the buffer
+        for (unsigned int first = node.first; first < node.first + node.count; first += MAX_SAH_LEAF_OBJECTS)
+        {
+            unsigned int count = min(MAX_SAH_LEAF_OBJECTS, node.first + node.count - first);
+            size_t visibleCount = CullingKernel::cullSpheres(frustum, itemSpheres, first, count, visible);
+            for (size_t i = 0; i < visibleCount; ++i)
+                result.push_back(items[first + visible[i]]);
+        }
+    }
+}
+
+void BoundingVolumeHierarchy::querySphere(const glm::vec4& sphere, vector<size_t>& result) const
+{
+    if (nodes.empty())
+        return;
+
+    unsigned int stack[MAX_DEPTH + 1];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize != 0)
+    {
+        const Node& node = nodes[stack[--stackSize]];
+        if (!overlaps(sphere, node.boxMin, node.boxMax))
+            continue;
+
+        if (node.left != 0)
+        {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.left + 1;
+            continue;
+        }
+        for (unsigned int i = node.first; i < node.first + node.count; ++i)
+        {
+            if (overlaps(sphere, spheres[items[i]]))
+                result.push_back(items[i]);
+        }
+    }
+}
+
+void BoundingVolumeHierarchy::queryBox(const glm::vec3& boxMin, const glm::vec3& boxMax, vector<size_t>& result) const
+{
+    if (nodes.empty())
+        return;
+
+    unsigned int stack[MAX_DEPTH + 1];
+    unsigned int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize != 0)
+    {
+        const Node& node = nodes[stack[--stackSize]];
+        if (!overlaps(boxMin, boxMax, node.boxMin, node.boxMax))
+            continue;
+
+        if (node.left != 0)
+        {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.left + 1;
+            continue;
+        }
+        for (unsigned int i = node.first; i < node.first + node.count; ++i)
+        {
+            if (overlaps(spheres[items[i]], boxMin, boxMax))
+                result.push_back(items[i]);
+        }
+    }
+}
+
+bool BoundingVolumeHierarchy::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+    if (nodes.empty())
+        return false;
+
+    // division by zero gives infinities, which slab test handles correctly
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool found = false;
+
+    unsigned int stack[MAX_DEPTH + 1];
+    unsigned int stackSize = 0;
+    if (intersectBox(origin, inverseDirection, closest, nodes[0].boxMin, nodes[0].boxMax) <= closest)
+        stack[stackSize++] = 0;
+    while (stackSize != 0)
+    {
+        const Node& node = nodes[stack[--stackSize]];
+        // node could be entered before a closer hit was found
+        if (intersectBox(origin, inverseDirection, closest, node.boxMin, node.boxMax) > closest)
+            continue;
+
+        if (node.left == 0)
+        {
+            for (unsigned int i = node.first; i < node.first + node.count; ++i)
+            {
+                float distance = intersectSphere(origin, direction, spheres[items[i]]);
+                if (distance <= closest)
+                {
+                    closest = distance;
+                    hit = { items[i], distance };
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // the nearer child is visited first, so farther one is often skipped
+        unsigned int nearChild = node.left;
+        unsigned int farChild = node.left + 1;
+        float nearDistance = intersectBox(origin, inverseDirection, closest, nodes[nearChild].boxMin, nodes[nearChild].boxMax);
+        float farDistance = intersectBox(origin, inverseDirection, closest, nodes[farChild].boxMin, nodes[farChild].boxMax);
+        if (farDistance < nearDistance)
+        {
+            swap(nearChild, farChild);
+            swap(nearDistance, farDistance);
+        }
+        if (farDistance <= closest)
+            stack[stackSize++] = farChild;
+        if (nearDistance <= closest)
+            stack[stackSize++] = nearChild;
+    }
+    return found;
+}
+
+void BoundingVolumeHierarchy::printStatistics(ostream& out) const
+{
+    size_t leavesNumber = 0;
+    for (const Node& node : nodes)
+        leavesNumber += node.left == 0 ? 1 : 0;
+    out << "BVH:: objects: " << spheres.size() << ", nodes: " << nodes.size()
+        << ", leaves: " << leavesNumber << ", depth: " << depth << endl;
+}
+
+void BoundingVolumeHierarchy::appendSubtree(const Node& node, vector<size_t>& result) const
+{
+    result.insert(result.end(), items.begin() + node.first, items.begin() + node.first + node.count);
+}
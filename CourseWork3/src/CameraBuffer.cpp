@@ -0,0 +1,35 @@
+#include <CameraBuffer.h>
+
+using namespace std;
+
+unsigned int CameraBuffer::buffer = 0;
+
+void CameraBuffer::update(const glm::mat4& projection, const glm::mat4& view)
+{
+    if (buffer == 0)
+    {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), nullptr, GL_DYNAMIC_DRAW);
+    }
+    else
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+    CameraData data = { projection, view };
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+}
+
+void CameraBuffer::setupShader(const Shader& shader)
+{
+    unsigned int block = glGetUniformBlockIndex(shader.ID, "Camera");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, block, BINDING);
+}
+
+void CameraBuffer::release()
+{
+    glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
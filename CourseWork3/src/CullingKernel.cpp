@@ -0,0 +1,339 @@
+#include <CullingKernel.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define CULLING_KERNEL_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        // MSVC compiles intrinsics of any instruction set without extra flags
+        #define CULLING_KERNEL_TARGET_SSE
+        #define CULLING_KERNEL_TARGET_AVX2
+    #else
+        #define CULLING_KERNEL_TARGET_SSE __attribute__((target("sse")))
+        #define CULLING_KERNEL_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+using namespace std;
+
+void SphereArray::push_back(const glm::vec4& sphere)
+{
+    x.push_back(sphere.x);
+    y.push_back(sphere.y);
+    z.push_back(sphere.z);
+    radius.push_back(sphere.w);
+}
+
+void SphereArray::set(size_t i, const glm::vec4& sphere)
+{
+    x[i] = sphere.x;
+    y[i] = sphere.y;
+    z[i] = sphere.z;
+    radius[i] = sphere.w;
+}
+
+void SphereArray::resize(size_t size)
+{
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+    radius.resize(size);
+}
+
+void BoxArray::push_back(const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    minX.push_back(boxMin.x);
+    minY.push_back(boxMin.y);
+    minZ.push_back(boxMin.z);
+    maxX.push_back(boxMax.x);
+    maxY.push_back(boxMax.y);
+    maxZ.push_back(boxMax.z);
+}
+
+void BoxArray::resize(size_t size)
+{
+    for (vector<float>* component : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ })
+        component->resize(size);
+}
+
+namespace
+{
+    const int PLANES_NUMBER = Frustum::PLANES_NUMBER;
+
+    // Components of box corner farthest along plane normal, box is visible if this corner is in front of every plane
+    struct BoxCorner
+    {
+        const float* x;
+        const float* y;
+        const float* z;
+    };
+
+    BoxCorner getFarCorner(const glm::vec4& plane, const BoxArray& boxes)
+    {
+        return { plane.x >= 0.0f ? boxes.maxX.data() : boxes.minX.data(),
+                 plane.y >= 0.0f ? boxes.maxY.data() : boxes.minY.data(),
+                 plane.z >= 0.0f ? boxes.maxZ.data() : boxes.minZ.data() };
+    }
+
+    // Appends indices of lanes set in mask without branches, slot after the last visible index is overwritten
+    inline void appendVisible(int mask, unsigned int lanes, size_t index, unsigned int* visible, size_t& visibleCount)
+    {
+        for (unsigned int lane = 0; lane < lanes; ++lane)
+        {
+            visible[visibleCount] = static_cast<unsigned int>(index + lane);
+            visibleCount += (mask >> lane) & 1;
+        }
+    }
+
+    size_t cullSpheresScalar(const Frustum& frustum, const SphereArray& spheres, size_t first, size_t count,
+                             size_t start, unsigned int* visible, size_t visibleCount)
+    {
+        for (size_t i = start; i < count; ++i)
+        {
+            size_t j = first + i;
+            bool inside = true;
+            for (int p = 0; p < PLANES_NUMBER; ++p)
+            {
+                const glm::vec4& plane = frustum.getPlane(p);
+                float distance = plane.x * spheres.x[j] + plane.y * spheres.y[j] + plane.z * spheres.z[j] + plane.w;
+                inside &= distance >= -spheres.radius[j];
+            }
+            visible[visibleCount] = static_cast<unsigned int>(i);
+            visibleCount += inside ? 1 : 0;
+        }
+        return visibleCount;
+    }
+
+    size_t cullBoxesScalar(const Frustum& frustum, const BoxArray& boxes, size_t first, size_t count,
+                           size_t start, unsigned int* visible, size_t visibleCount)
+    {
+        BoxCorner corners[PLANES_NUMBER];
+        for (int p = 0; p < PLANES_NUMBER; ++p)
+            corners[p] = getFarCorner(frustum.getPlane(p), boxes);
+
+        for (size_t i = start; i < count; ++i)
+        {
+            size_t j = first + i;
+            bool inside = true;
+            for (int p = 0; p < PLANES_NUMBER; ++p)
+            {
+                const glm::vec4& plane = frustum.getPlane(p);
+                inside &= plane.x * corners[p].x[j] + plane.y * corners[p].y[j] + plane.z * corners[p].z[j] + plane.w >= 0.0f;
+            }
+            visible[visibleCount] = static_cast<unsigned int>(i);
+            visibleCount += inside ? 1 : 0;
+        }
+        return visibleCount;
+    }
+
+#ifdef CULLING_KERNEL_X86
+    CULLING_KERNEL_TARGET_SSE
+    size_t cullSpheresSse(const Frustum& frustum, const SphereArray& spheres, size_t first, size_t count, unsigned int* visible)
+    {
+        __m128 planes[PLANES_NUMBER][4];
+        for (int p = 0; p < PLANES_NUMBER; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+                planes[p][c] = _mm_set1_ps(frustum.getPlane(p)[c]);
+        }
+
+        size_t visibleCount = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            size_t j = first + i;
+            __m128 x = _mm_loadu_ps(spheres.x.data() + j);
+            __m128 y = _mm_loadu_ps(spheres.y.data() + j);
+            __m128 z = _mm_loadu_ps(spheres.z.data() + j);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius.data() + j));
+
+            __m128 inside = _mm_cmpeq_ps(negativeRadius, negativeRadius);
+            for (int p = 0; p < PLANES_NUMBER; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+                                             _mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            appendVisible(_mm_movemask_ps(inside), 4, i, visible, visibleCount);
+        }
+        return cullSpheresScalar(frustum, spheres, first, count, i, visible, visibleCount);
+    }
+
+    CULLING_KERNEL_TARGET_SSE
+    size_t cullBoxesSse(const Frustum& frustum, const BoxArray& boxes, size_t first, size_t count, unsigned int* visible)
+    {
+        __m128 planes[PLANES_NUMBER][4];
+        BoxCorner corners[PLANES_NUMBER];
+        for (int p = 0; p < PLANES_NUMBER; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+                planes[p][c] = _mm_set1_ps(frustum.getPlane(p)[c]);
+            corners[p] = getFarCorner(frustum.getPlane(p), boxes);
+        }
+
+        size_t visibleCount = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            size_t j = first + i;
+            __m128 zero = _mm_setzero_ps();
+            __m128 inside = _mm_cmpeq_ps(zero, zero);
+            for (int p = 0; p < PLANES_NUMBER; ++p)
+            {
+                __m128 x = _mm_loadu_ps(corners[p].x + j);
+                __m128 y = _mm_loadu_ps(corners[p].y + j);
+                __m128 z = _mm_loadu_ps(corners[p].z + j);
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+                                             _mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+            }
+            appendVisible(_mm_movemask_ps(inside), 4, i, visible, visibleCount);
+        }
+        return cullBoxesScalar(frustum, boxes, first, count, i, visible, visibleCount);
+    }
+
+    CULLING_KERNEL_TARGET_AVX2
+    size_t cullSpheresAvx2(const Frustum& frustum, const SphereArray& spheres, size_t first, size_t count, unsigned int* visible)
+    {
+        __m256 planes[PLANES_NUMBER][4];
+        for (int p = 0; p < PLANES_NUMBER; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+                planes[p][c] = _mm256_set1_ps(frustum.getPlane(p)[c]);
+        }
+
+        size_t visibleCount = 0;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            size_t j = first + i;
+            __m256 x = _mm256_loadu_ps(spheres.x.data() + j);
+            __m256 y = _mm256_loadu_ps(spheres.y.data() + j);
+            __m256 z = _mm256_loadu_ps(spheres.z.data() + j);
+            __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius.data() + j));
+
+            __m256 inside = _mm256_cmp_ps(negativeRadius, negativeRadius, _CMP_EQ_OQ);
+            for (int p = 0; p < PLANES_NUMBER; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], x), _mm256_mul_ps(planes[p][1], y)),
+                                                _mm256_add_ps(_mm256_mul_ps(planes[p][2], z), planes[p][3]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            appendVisible(_mm256_movemask_ps(inside), 8, i, visible, visibleCount);
+        }
+        return cullSpheresScalar(frustum, spheres, first, count, i, visible, visibleCount);
+    }
+
+    CULLING_KERNEL_TARGET_AVX2
+    size_t cullBoxesAvx2(const Frustum& frustum, const BoxArray& boxes, size_t first, size_t count, unsigned int* visible)
+    {
+        __m256 planes[PLANES_NUMBER][4];
+        BoxCorner corners[PLANES_NUMBER];
+        for (int p = 0; p < PLANES_NUMBER; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+                planes[p][c] = _mm256_set1_ps(frustum.getPlane(p)[c]);
+            corners[p] = getFarCorner(frustum.getPlane(p), boxes);
+        }
+
+        size_t visibleCount = 0;
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            size_t j = first + i;
+            __m256 zero = _mm256_setzero_ps();
+            __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+            for (int p = 0; p < PLANES_NUMBER; ++p)
+            {
+                __m256 x = _mm256_loadu_ps(corners[p].x + j);
+                __m256 y = _mm256_loadu_ps(corners[p].y + j);
+                __m256 z = _mm256_loadu_ps(corners[p].z + j);
+                __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], x), _mm256_mul_ps(planes[p][1], y)),
+                                                _mm256_add_ps(_mm256_mul_ps(planes[p][2], z), planes[p][3]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+            }
+            appendVisible(_mm256_movemask_ps(inside), 8, i, visible, visibleCount);
+        }
+        return cullBoxesScalar(frustum, boxes, first, count, i, visible, visibleCount);
+    }
+#endif
+}
+
+CullingKernel::InstructionSet CullingKernel::instructionSet = CullingKernel::getSupportedInstructionSet();
+
+CullingKernel::InstructionSet CullingKernel::getSupportedInstructionSet()
+{
+#if defined(CULLING_KERNEL_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse = (info[3] & (1 << 25)) != 0;
+    // AVX registers must also be saved by operating system
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (osAvx && maxLeaf >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    return avx2 ? AVX2 : (sse ? SSE : SCALAR);
+#elif defined(CULLING_KERNEL_X86)
+    // checks operating system support of AVX registers as well
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return AVX2;
+    return __builtin_cpu_supports("sse") ? SSE : SCALAR;
+#else
+    return SCALAR;
+#endif
+}
+
+void CullingKernel::setInstructionSet(InstructionSet set)
+{
+    instructionSet = min(set, getSupportedInstructionSet());
+}
+
+const char* CullingKernel::getName(InstructionSet set)
+{
+    switch (set)
+    {
+        case SSE: return "SSE";
+        case AVX2: return "AVX2";
+        default: return "scalar";
+    }
+}
+
+size_t CullingKernel::cullSpheres(const Frustum& frustum, const SphereArray& spheres, size_t first, size_t count, unsigned int* visible)
+{
+#ifdef CULLING_KERNEL_X86
+    if (instructionSet == AVX2)
+        return cullSpheresAvx2(frustum, spheres, first, count, visible);
+    if (instructionSet == SSE)
+        return cullSpheresSse(frustum, spheres, first, count, visible);
+#endif
+    return cullSpheresScalar(frustum, spheres, first, count, 0, visible, 0);
+}
+
+size_t CullingKernel::cullBoxes(const Frustum& frustum, const BoxArray& boxes, size_t first, size_t count, unsigned int* visible)
+{
+#ifdef CULLING_KERNEL_X86
+    if (instructionSet == AVX2)
+        return cullBoxesAvx2(frustum, boxes, first, count, visible);
+    if (instructionSet == SSE)
+        return cullBoxesSse(frustum, boxes, first, count, visible);
+#endif
+    return cullBoxesScalar(frustum, boxes, first, count, 0, visible, 0);
+}
+
+void CullingKernel::cullSpheres(const Frustum& frustum, const SphereArray& spheres, vector<unsigned int>& visible)
+{
+    visible.resize(spheres.size());
+    visible.resize(cullSpheres(frustum, spheres, 0, spheres.size(), visible.data()));
+}
+
+void CullingKernel::cullBoxes(const Frustum& frustum, const BoxArray& boxes, vector<unsigned int>& visible)
+{
+    visible.resize(boxes.size());
+    visible.resize(cullBoxes(frustum, boxes, 0, boxes.size(), visible.data()));
+}
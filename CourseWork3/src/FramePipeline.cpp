@@ -0,0 +1,118 @@
+#include <FramePipeline.h>
+
+#include <chrono>
+
+using namespace std;
+
+namespace
+{
+    // Fences are waited in steps, so GL errors can't block the main thread forever
+    const GLuint64 FENCE_TIMEOUT = 100000000; // nanoseconds
+
+    double getMilliseconds(chrono::steady_clock::time_point start)
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+FramePacket& FramePipeline::beginPacket()
+{
+    FramePacket& packet = packets[nextPacket];
+    nextPacket = (nextPacket + 1) % PACKETS_NUMBER;
+    packet.number = ++frameNumber;
+    return packet;
+}
+
+void FramePipeline::prepareAhead(const PrepareFunction& prepare)
+{
+    invalidate();
+    FramePacket* packet = &packets[(nextPacket + PACKETS_NUMBER - 1) % PACKETS_NUMBER];
+    prepared = packet;
+    job = JobSystem::schedule([prepare, packet]() { prepare(*packet); });
+}
+
+void FramePipeline::prepareInPlace(const PrepareFunction& prepare)
+{
+    invalidate();
+    prepare(packets[(nextPacket + PACKETS_NUMBER - 1) % PACKETS_NUMBER]);
+    ++statistics.preparedInPlace;
+}
+
+FramePacket* FramePipeline::takePacket()
+{
+    statistics.preparationWait = 0;
+    if (!job)
+        return nullptr;
+
+    auto start = chrono::steady_clock::now();
+    JobSystem::wait(job);
+    statistics.preparationWait = getMilliseconds(start);
+
+    FramePacket* packet = prepared;
+    job = nullptr;
+    prepared = nullptr;
+    ++statistics.preparedAhead;
+    return packet;
+}
+
+void FramePipeline::invalidate()
+{
+    if (!job)
+        return;
+    JobSystem::wait(job);
+    job = nullptr;
+    prepared = nullptr;
+}
+
+void FramePipeline::waitForGpu()
+{
+    statistics.gpuWait = 0;
+    GLsync& fence = fences[nextFence];
+    if (!fence)
+        return;
+
+    auto start = chrono::steady_clock::now();
+    GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    while (status == GL_TIMEOUT_EXPIRED)
+        status = glClientWaitSync(fence, 0, FENCE_TIMEOUT);
+    if (status == GL_WAIT_FAILED)
+        cout << "ERROR::FRAME_PIPELINE::FENCE_WAIT_FAILED" << endl;
+    statistics.gpuWait = getMilliseconds(start);
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void FramePipeline::endFrame()
+{
+    GLsync& fence = fences[nextFence];
+    if (fence)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    nextFence = (nextFence + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void FramePipeline::release()
+{
+    invalidate();
+    for (GLsync& fence : fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void FramePipeline::setEnabled(bool enabled)
+{
+    if (!enabled)
+        invalidate();
+    this->enabled = enabled;
+}
+
+void FramePipeline::printStatistics(ostream& out) const
+{
+    out << "FRAME_PIPELINE:: " << (enabled ? "enabled" : "disabled")
+        << ", prepared ahead: " << statistics.preparedAhead << ", in place: " << statistics.preparedInPlace
+        << ", preparation wait: " << statistics.preparationWait << " ms, GPU wait: " << statistics.gpuWait << " ms" << endl;
+}
@@ -0,0 +1,67 @@
+#include <Frustum.h>
+
+using namespace std;
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // rows of the matrix, glm stores columns
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    // clip space point is inside when -w <= x, y, z <= w
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+
+    // normalized planes give real distances, so spheres can be tested
+    for (glm::vec4& plane : planes)
+        plane = plane / glm::length(glm::vec3(plane));
+}
+
+bool Frustum::intersects(const glm::vec4& sphere) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+    for (const glm::vec4& plane : planes)
+    {
+        // corner farthest along plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                         plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                         plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+Frustum::Containment Frustum::classify(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+{
+    Containment result = INSIDE;
+    for (const glm::vec4& plane : planes)
+    {
+        // corners farthest along plane normal and against it
+        glm::vec3 farCorner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                            plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                            plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        glm::vec3 nearCorner(plane.x >= 0.0f ? boxMin.x : boxMax.x,
+                             plane.y >= 0.0f ? boxMin.y : boxMax.y,
+                             plane.z >= 0.0f ? boxMin.z : boxMax.z);
+        if (glm::dot(glm::vec3(plane), farCorner) + plane.w < 0.0f)
+            return OUTSIDE;
+        if (glm::dot(glm::vec3(plane), nearCorner) + plane.w < 0.0f)
+            result = INTERSECTS;
+    }
+    return result;
+}
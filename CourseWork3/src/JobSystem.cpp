@@ -0,0 +1,270 @@
+#include <JobSystem.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+    // More ranges than threads balance uneven work, too many of them only add scheduling overhead
+    const size_t RANGES_PER_THREAD = 4;
+
+    // Index of the queue of current thread, threads outside the pool share the first one
+    thread_local unsigned int threadIndex = 0;
+
+    // Idle workers sleep until a job is queued
+    mutex sleepLock;
+    condition_variable wakeUp;
+}
+
+struct JobSystem::Job
+{
+    Function function;
+    atomic<size_t> unfinished{ 1 }; // dependencies which aren't finished, plus one held while job is being scheduled
+    atomic<bool> finished{ false };
+    mutex lock;                      // guards finished flag together with dependents
+    vector<JobHandle> dependents;
+};
+
+struct JobSystem::Queue
+{
+    mutex lock;
+    deque<JobHandle> jobs;
+};
+
+vector<unique_ptr<JobSystem::Queue>> JobSystem::queues;
+vector<thread> JobSystem::workers;
+atomic<size_t> JobSystem::queued{ 0 };
+atomic<bool> JobSystem::running{ false };
+atomic<size_t> JobSystem::executed{ 0 };
+atomic<size_t> JobSystem::stolen{ 0 };
+
+namespace
+{
+    // Workers are joined even if program exits without stop(), e.g. after a model failed to load
+    struct WorkersGuard
+    {
+        ~WorkersGuard() { JobSystem::stop(); }
+    } workersGuard;
+}
+
+void JobSystem::start(unsigned int workersNumber)
+{
+    stop();
+    executed = 0;
+    stolen = 0;
+    if (workersNumber == 0)
+        return;
+
+    queues.clear();
+    for (unsigned int i = 0; i <= workersNumber; ++i)
+        queues.push_back(make_unique<Queue>());
+    running = true;
+    for (unsigned int i = 1; i <= workersNumber; ++i)
+        workers.emplace_back(runWorker, i);
+}
+
+void JobSystem::stop()
+{
+    if (workers.empty())
+        return;
+    {
+        lock_guard<mutex> lock(sleepLock);
+        running = false;
+    }
+    wakeUp.notify_all();
+    for (thread& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+unsigned int JobSystem::getDefaultWorkersNumber()
+{
+    unsigned int cores = thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+JobSystem::JobHandle JobSystem::schedule(Function function, const vector<JobHandle>& dependencies)
+{
+    JobHandle job = make_shared<Job>();
+    job->function = move(function);
+    // without workers every job runs as soon as it is scheduled, so dependencies are already finished
+    if (workers.empty())
+    {
+        run(job);
+        return job;
+    }
+
+    for (const JobHandle& dependency : dependencies)
+    {
+        lock_guard<mutex> lock(dependency->lock);
+        if (!dependency->finished)
+        {
+            dependency->dependents.push_back(job);
+            ++job->unfinished;
+        }
+    }
+    // the last finished dependency queues the job
+    if (--job->unfinished == 0)
+        push(job);
+    return job;
+}
+
+bool JobSystem::isFinished(const JobHandle& job)
+{
+    return job->finished.load(memory_order_acquire);
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+    while (!isFinished(job))
+    {
+        if (JobHandle other = take())
+            run(other);
+        else
+            this_thread::yield();
+    }
+}
+
+void JobSystem::wait(const vector<JobHandle>& jobs)
+{
+    for (const JobHandle& job : jobs)
+        wait(job);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+    grain = max<size_t>(grain, 1);
+    size_t rangesNumber = min((count + grain - 1) / grain, getThreadsNumber() * RANGES_PER_THREAD);
+    if (rangesNumber <= 1 || workers.empty())
+    {
+        function(0, count);
+        return;
+    }
+
+    size_t rangeSize = (count + rangesNumber - 1) / rangesNumber;
+    vector<JobHandle> jobs;
+    jobs.reserve(rangesNumber);
+    for (size_t begin = rangeSize; begin < count; begin += rangeSize)
+    {
+        size_t end = min(begin + rangeSize, count);
+        jobs.push_back(schedule([&function, begin, end]() { function(begin, end); }));
+    }
+    // the first range is processed by the calling thread while workers take the others
+    function(0, rangeSize);
+    wait(jobs);
+}
+
+JobSystem::Statistics JobSystem::getStatistics()
+{
+    Statistics statistics;
+    statistics.executed = executed;
+    statistics.stolen = stolen;
+    return statistics;
+}
+
+void JobSystem::printStatistics(ostream& out)
+{
+    out << "JOB_SYSTEM:: threads: " << getThreadsNumber()
+        << ", jobs: " << executed << ", stolen: " << stolen << endl;
+}
+
+void JobSystem::runWorker(unsigned int index)
+{
+    threadIndex = index;
+    while (true)
+    {
+        if (JobHandle job = take())
+        {
+            run(job);
+            continue;
+        }
+
+        unique_lock<mutex> lock(sleepLock);
+        wakeUp.wait(lock, []() { return queued != 0 || !running; });
+        if (!running && queued == 0)
+            return;
+    }
+}
+
+void JobSystem::push(const JobHandle& job)
+{
+    Queue& queue = *queues[threadIndex];
+    {
+        lock_guard<mutex> lock(queue.lock);
+        queue.jobs.push_back(job);
+    }
+    // counter is changed under the lock, so a worker can't fall asleep between checking it and waiting
+    {
+        lock_guard<mutex> lock(sleepLock);
+        ++queued;
+    }
+    wakeUp.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::take()
+{
+    if (queued == 0)
+        return nullptr;
+
+    // the newest job of own queue
+    Queue& own = *queues[threadIndex];
+    {
+        lock_guard<mutex> lock(own.lock);
+        if (!own.jobs.empty())
+        {
+            JobHandle job = move(own.jobs.back());
+            own.jobs.pop_back();
+            --queued;
+            return job;
+        }
+    }
+
+    // the oldest job of another queue, victims are visited from a random one so thieves don't contend for the same queue
+    thread_local minstd_rand random(threadIndex + 1);
+    size_t first = random() % queues.size();
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+        size_t victim = (first + i) % queues.size();
+        if (victim == threadIndex)
+            continue;
+        Queue& queue = *queues[victim];
+        lock_guard<mutex> lock(queue.lock);
+        if (!queue.jobs.empty())
+        {
+            JobHandle job = move(queue.jobs.front());
+            queue.jobs.pop_front();
+            --queued;
+            ++stolen;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::run(const JobHandle& job)
+{
+    job->function();
+    // captured data is released as soon as job is done
+    job->function = nullptr;
+
+    vector<JobHandle> dependents;
+    {
+        lock_guard<mutex> lock(job->lock);
+        job->finished.store(true, memory_order_release);
+        dependents.swap(job->dependents);
+    }
+    ++executed;
+
+    for (const JobHandle& dependent : dependents)
+    {
+        if (--dependent->unfinished == 0)
+            push(dependent);
+    }
+}
@@ -0,0 +1,120 @@
+#include <LightGizmos.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+using namespace std;
+
+namespace
+{
+    const float POINT_LIGHT_SCALE = 0.125f;
+    const float SPOT_LIGHT_SCALE = 0.25f;
+
+    // first location of per-instance attributes, model matrix takes four of them
+    const GLuint MODEL_ATTRIBUTE = 2;
+    const GLuint COLOR_ATTRIBUTE = MODEL_ATTRIBUTE + 4;
+
+    // Model matrix turning apex of pyramid (+Y) away from light direction
+    glm::mat4 makeSpotLightModel(const glm::vec3& position, const glm::vec3& direction, float scale)
+    {
+        glm::vec3 y = -glm::normalize(direction);
+        // any axis which isn't parallel to y completes the basis
+        glm::vec3 helper = abs(y.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 x = glm::normalize(glm::cross(y, helper));
+        glm::vec3 z = glm::cross(x, y);
+
+        glm::mat4 model(1.0f);
+        model[0] = glm::vec4(x * scale, 0.0f);
+        model[1] = glm::vec4(y * scale, 0.0f);
+        model[2] = glm::vec4(z * scale, 0.0f);
+        model[3] = glm::vec4(position, 1.0f);
+        return model;
+    }
+}
+
+LightGizmos::LightGizmos()
+{
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &instanceBuffer);
+
+    glBindVertexArray(vertexArray);
+    Primitives::setupVertexAttributes();
+    for (GLuint i = 0; i < 4; ++i)
+    {
+        glEnableVertexAttribArray(MODEL_ATTRIBUTE + i);
+        glVertexAttribDivisor(MODEL_ATTRIBUTE + i, 1);
+    }
+    glEnableVertexAttribArray(COLOR_ATTRIBUTE);
+    glVertexAttribDivisor(COLOR_ATTRIBUTE, 1);
+    setFirstInstance(0);
+    glBindVertexArray(0);
+}
+
+LightGizmos::~LightGizmos()
+{
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &instanceBuffer);
+}
+
+void LightGizmos::update(const vector<PointLight>& pointLights, const vector<SpotLight>& spotLights)
+{
+    pointLightsNumber = static_cast<GLsizei>(pointLights.size());
+    spotLightsNumber = static_cast<GLsizei>(spotLights.size());
+    instances.resize(pointLights.size() + spotLights.size());
+
+    Instance* instance = instances.data();
+    for (const PointLight& light : pointLights)
+    {
+        // uniform scale and translation only
+        instance->model = glm::mat4(POINT_LIGHT_SCALE);
+        instance->model[3] = glm::vec4(light.getPosition(), 1.0f);
+        instance->color = light.getColor();
+        ++instance;
+    }
+    for (const SpotLight& light : spotLights)
+    {
+        instance->model = makeSpotLightModel(light.getPosition(), light.getDirection(), SPOT_LIGHT_SCALE);
+        instance->color = light.getColor();
+        ++instance;
+    }
+
+    // storage is orphaned every frame, so the driver doesn't wait until previous frame stops reading it
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    instanceBufferCapacity = max(instanceBufferCapacity, instances.size());
+    glBufferData(GL_ARRAY_BUFFER, instanceBufferCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    if (!instances.empty())
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void LightGizmos::render() const
+{
+    if (instances.empty())
+        return;
+
+    glBindVertexArray(vertexArray);
+    if (pointLightsNumber != 0)
+        Primitives::drawInstanced(Primitives::CUBE, pointLightsNumber);
+    if (spotLightsNumber != 0)
+    {
+        setFirstInstance(pointLightsNumber);
+        Primitives::drawInstanced(Primitives::PYRAMID, spotLightsNumber);
+        setFirstInstance(0);
+    }
+    glBindVertexArray(0);
+}
+
+void LightGizmos::setFirstInstance(size_t first) const
+{
+    // GL 3.3 has no base instance, so attributes are pointed to the first instance of a draw
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    size_t offset = first * sizeof(Instance);
+    for (GLuint i = 0; i < 4; ++i)
+    {
+        glVertexAttribPointer(MODEL_ATTRIBUTE + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              (void*)(offset + offsetof(Instance, model) + i * sizeof(glm::vec4)));
+    }
+    glVertexAttribPointer(COLOR_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, color)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
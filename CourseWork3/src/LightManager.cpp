@@ -49,7 +49,15 @@ void LightManager::switchLightType(ActiveLightType type)
         activeType = type;
 }
 
-void LightManager::translateCurrentLight(Direction dir)
+void LightManager::lightsChanged()
+{
+    if (curPointLight >= static_cast<int>(pointLights.size()))
+        curPointLight = pointLights.empty() ? 0 : pointLights.size() - 1;
+    if (curSpotLight >= static_cast<int>(spotLights.size()))
+        curSpotLight = spotLights.empty() ? 0 : spotLights.size() - 1;
+}
+
+void LightManager::translateCurrentLight(Direction dir, float deltaTime)
 {
     if (activeType == ActiveLightType::NONE ||
         (activeType == ActiveLightType::POINT && pointLights.size() == 0) ||
@@ -97,20 +105,24 @@ void LightManager::key_callback(GLFWwindow* window, int key, int scancode, int a
         switchToPrevious();
     if (key == GLFW_KEY_RIGHT&& action == GLFW_PRESS)
         switchToNext();
-    if (key == GLFW_KEY_U && action == GLFW_REPEAT)
-        translateCurrentLight(Direction::UP);
-    if (key == GLFW_KEY_O && action == GLFW_REPEAT)
-        translateCurrentLight(Direction::DOWN);
-    if (key == GLFW_KEY_I && action == GLFW_REPEAT)
-        translateCurrentLight(Direction::FRONT);
-    if (key == GLFW_KEY_K && action == GLFW_REPEAT)
-        translateCurrentLight(Direction::BACK);
-    if (key == GLFW_KEY_J && action == GLFW_REPEAT)
-        translateCurrentLight(Direction::LEFT);
-    if (key == GLFW_KEY_L && action == GLFW_REPEAT)
-        translateCurrentLight(Direction::RIGHT);
     if (key == GLFW_KEY_EQUAL && action == GLFW_PRESS)
         movementSpeed = movementSpeed >= 10.0f ? 10.0f : movementSpeed + 1.0f;
     if (key == GLFW_KEY_MINUS && action == GLFW_PRESS)
         movementSpeed = movementSpeed <= 0.0f ? 0.0f : movementSpeed - 1.0f;
-}
\ No newline at end of file
+}
+
+void LightManager::update(GLFWwindow* window, float step)
+{
+    if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS)
+        translateCurrentLight(Direction::UP, step);
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
+        translateCurrentLight(Direction::DOWN, step);
+    if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
+        translateCurrentLight(Direction::FRONT, step);
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
+        translateCurrentLight(Direction::BACK, step);
+    if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS)
+        translateCurrentLight(Direction::LEFT, step);
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
+        translateCurrentLight(Direction::RIGHT, step);
+}
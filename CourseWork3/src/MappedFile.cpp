@@ -0,0 +1,115 @@
+#include <MappedFile.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& path)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    _file = file;
+    _size = static_cast<size_t>(size.QuadPart);
+    _open = true;
+
+    // empty files can't be mapped, but they are valid
+    if (_size == 0)
+        return true;
+
+    _mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (_mapping)
+        _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!_data)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mapping)
+        CloseHandle(_mapping);
+    if (_file)
+        CloseHandle(_file);
+
+    _data = nullptr;
+    _mapping = nullptr;
+    _file = nullptr;
+    _size = 0;
+    _open = false;
+}
+
+#else
+
+bool MappedFile::open(const string& path)
+{
+    close();
+
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+    _descriptor = descriptor;
+    _size = static_cast<size_t>(status.st_size);
+    _open = true;
+
+    // empty files can't be mapped, but they are valid
+    if (_size == 0)
+        return true;
+
+    void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    madvise(data, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const char*>(data);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data)
+        munmap(const_cast<char*>(_data), _size);
+    if (_descriptor >= 0)
+        ::close(_descriptor);
+
+    _data = nullptr;
+    _descriptor = -1;
+    _size = 0;
+    _open = false;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include <MouseLook.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    // Smoothed offsets smaller than that are applied at once instead of approaching zero forever
+    const float MIN_PENDING_OFFSET = 0.01f; // pixels
+}
+
+const float MouseLook::DEFAULT_SMOOTHING_TIME = 0.03f;
+
+void MouseLook::move(float xoffset, float yoffset, double time)
+{
+    if (!hasNewInput)
+    {
+        inputTime = time;
+        hasNewInput = true;
+    }
+    pending += glm::vec2(xoffset, yoffset);
+}
+
+double MouseLook::apply(Camera& camera, double time)
+{
+    float elapsed = lastApply < 0 ? 0.0f : static_cast<float>(max(time - lastApply, 0.0));
+    lastApply = time;
+
+    glm::vec2 offset = pending;
+    if (smoothing && smoothingTime > 0.0f)
+    {
+        offset *= 1.0f - exp(-elapsed / smoothingTime);
+        if (glm::length(pending - offset) < MIN_PENDING_OFFSET)
+            offset = pending;
+    }
+    pending -= offset;
+    if (offset.x != 0.0f || offset.y != 0.0f)
+        camera.ProcessMouseMovement(offset.x, offset.y);
+
+    if (!hasNewInput)
+        return -1.0;
+    hasNewInput = false;
+    return inputTime;
+}
+
+void MouseLook::measure(double inputTime, double presentTime)
+{
+    double latency = (presentTime - inputTime) * 1000.0;
+    ++statistics.frames;
+    statistics.lastLatency = latency;
+    statistics.averageLatency += (latency - statistics.averageLatency) / statistics.frames;
+    statistics.maxLatency = max(statistics.maxLatency, latency);
+}
+
+void MouseLook::printStatistics(ostream& out) const
+{
+    out << "MOUSE_LOOK:: smoothing: " << (smoothing ? "on" : "off")
+        << ", input to swap latency: " << statistics.lastLatency << " ms, average: " << statistics.averageLatency
+        << " ms, max: " << statistics.maxLatency << " ms over " << statistics.frames << " frames" << endl;
+}
@@ -0,0 +1,95 @@
+#include <Objects/CompactVertex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+vector<CompactVertex> compressVertices(const vector<Vertex>& vertices, glm::vec3& positionScale, glm::vec3& positionOffset)
+{
+    glm::vec3 minimum(0.0f);
+    glm::vec3 maximum(0.0f);
+    if (!vertices.empty())
+        minimum = maximum = vertices[0].Position;
+    for (const Vertex& vertex : vertices)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            minimum[i] = min(minimum[i], vertex.Position[i]);
+            maximum[i] = max(maximum[i], vertex.Position[i]);
+        }
+    }
+
+    // attributes are normalized, so shader receives positions in [0, 1] range of the bounds
+    positionOffset = minimum;
+    positionScale = maximum - minimum;
+
+    vector<CompactVertex> result(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        for (int j = 0; j < 3; ++j)
+        {
+            float relative = positionScale[j] > 0.0f ? (vertices[i].Position[j] - minimum[j]) / positionScale[j] : 0.0f;
+            result[i].Position[j] = static_cast<uint16_t>(lround(relative * 65535.0f));
+        }
+        result[i].padding = 0;
+        result[i].Normal = packNormal(vertices[i].Normal);
+        result[i].TexCoords[0] = toHalf(vertices[i].TexCoords.x);
+        result[i].TexCoords[1] = toHalf(vertices[i].TexCoords.y);
+    }
+    return result;
+}
+
+uint32_t packNormal(const glm::vec3& normal)
+{
+    uint32_t result = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        long component = lround(clamp(normal[i], -1.0f, 1.0f) * 511.0f);
+        result |= (static_cast<uint32_t>(component) & 0x3FF) << (10 * i);
+    }
+    return result;
+}
+
+uint16_t toHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t floatExponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // infinity and NaN
+    if (floatExponent == 0xFF)
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+    int exponent = static_cast<int>(floatExponent) - 127 + 15;
+    // too large values become infinity
+    if (exponent >= 0x1F)
+        return sign | 0x7C00;
+    // too small values become zero
+    if (exponent < -10)
+        return sign;
+
+    if (exponent <= 0)
+    {
+        // subnormal half, implicit leading bit becomes explicit
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            ++half;
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    // carry of rounding may increase exponent, up to infinity, which is correct
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+    return sign | static_cast<uint16_t>(half);
+}
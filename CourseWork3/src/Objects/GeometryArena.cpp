@@ -0,0 +1,363 @@
+#include <Objects/GeometryArena.h>
+#include <Objects/CompactVertex.h>
+#include <Objects/Mesh.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    // Arenas start with room for this many vertices and indices and at least double when they grow
+    const size_t MIN_VERTEX_CAPACITY = 1 << 16;
+    const size_t MIN_INDEX_CAPACITY = 1 << 18;
+
+    const size_t NO_RANGE = ~size_t(0);
+
+    // Arenas are never destroyed: geometries owned by global models are released after main returns
+    GeometryArena* arenas[2][2] = {};
+
+    unsigned int indirectBuffer = 0;
+    unsigned int materialBuffer = 0; // material index of every indirect draw, read as instanced attribute
+}
+
+GeometryArena& GeometryArena::get(bool compact, GLenum indexType)
+{
+    GeometryArena*& arena = arenas[compact][indexType == GL_UNSIGNED_SHORT];
+    if (!arena)
+        arena = new GeometryArena(compact, indexType);
+    return *arena;
+}
+
+void GeometryArena::compactAll()
+{
+    for (auto& row : arenas)
+    {
+        for (GeometryArena* arena : row)
+        {
+            if (arena)
+                arena->compact();
+        }
+    }
+}
+
+void GeometryArena::printStatistics(ostream& out)
+{
+    for (auto& row : arenas)
+    {
+        for (GeometryArena* arena : row)
+        {
+            if (!arena)
+                continue;
+            out << "GEOMETRY_ARENA:: " << (arena->compactVertices ? "compact" : "full") << " vertices, "
+                << (arena->indexType == GL_UNSIGNED_SHORT ? 16 : 32) << "-bit indices"
+                << ", used: " << (arena->usedVertices * arena->vertexSize + arena->usedIndices * arena->indexSize) / 1024 << " KB"
+                << ", allocated: " << (arena->vertexCapacity * arena->vertexSize + arena->indexCapacity * arena->indexSize) / 1024 << " KB" << endl;
+        }
+    }
+}
+
+GeometryArena::GeometryArena(bool compact, GLenum indexType)
+    : compactVertices(compact)
+    , indexType(indexType)
+    , vertexSize(compact ? sizeof(CompactVertex) : sizeof(Vertex))
+    , indexSize(indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint))
+{
+}
+
+unsigned int GeometryArena::allocate(const void* vertices, size_t vertexCount, const void* indices, size_t indexCount)
+{
+    size_t vertexOffset = freeVertices.allocate(vertexCount);
+    size_t indexOffset = freeIndices.allocate(indexCount);
+    if (vertexOffset == NO_RANGE || indexOffset == NO_RANGE)
+    {
+        // space which was just taken is returned, so it becomes part of the range at the end of larger buffers
+        if (vertexOffset != NO_RANGE)
+            freeVertices.free(vertexOffset, vertexCount);
+        if (indexOffset != NO_RANGE)
+            freeIndices.free(indexOffset, indexCount);
+
+        grow(max({ vertexCapacity * 2, vertexCapacity + vertexCount, MIN_VERTEX_CAPACITY }),
+             max({ indexCapacity * 2, indexCapacity + indexCount, MIN_INDEX_CAPACITY }));
+        vertexOffset = freeVertices.allocate(vertexCount);
+        indexOffset = freeIndices.allocate(indexCount);
+    }
+
+    // copy targets are used, so element buffer binding of currently bound vertex array isn't changed
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset * vertexSize, vertexCount * vertexSize, vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset * indexSize, indexCount * indexSize, indices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    unsigned int id;
+    if (freeBlocks.empty())
+    {
+        id = static_cast<unsigned int>(blocks.size());
+        blocks.emplace_back();
+    }
+    else
+    {
+        id = freeBlocks.back();
+        freeBlocks.pop_back();
+    }
+
+    Block& block = blocks[id];
+    block.vertexOffset = vertexOffset;
+    block.vertexCount = vertexCount;
+    block.indexOffset = indexOffset;
+    block.indexCount = indexCount;
+    block.live = true;
+
+    usedVertices += vertexCount;
+    usedIndices += indexCount;
+    return id;
+}
+
+void GeometryArena::free(unsigned int id)
+{
+    Block& block = blocks[id];
+    freeVertices.free(block.vertexOffset, block.vertexCount);
+    freeIndices.free(block.indexOffset, block.indexCount);
+    usedVertices -= block.vertexCount;
+    usedIndices -= block.indexCount;
+    block.live = false;
+    freeBlocks.push_back(id);
+}
+
+void GeometryArena::compact()
+{
+    if (usedVertices == vertexCapacity && usedIndices == indexCapacity)
+        return;
+
+    unsigned int buffers[2];
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, usedVertices * vertexSize, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, usedIndices * indexSize, nullptr, GL_STATIC_DRAW);
+
+    // blocks are copied one after another in their current order
+    vector<Block*> live;
+    for (Block& block : blocks)
+    {
+        if (block.live)
+            live.push_back(&block);
+    }
+    sort(live.begin(), live.end(), [](const Block* left, const Block* right) { return left->vertexOffset < right->vertexOffset; });
+
+    size_t vertexOffset = 0;
+    size_t indexOffset = 0;
+    for (Block* block : live)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            block->vertexOffset * vertexSize, vertexOffset * vertexSize, block->vertexCount * vertexSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            block->indexOffset * indexSize, indexOffset * indexSize, block->indexCount * indexSize);
+
+        block->vertexOffset = vertexOffset;
+        block->indexOffset = indexOffset;
+        vertexOffset += block->vertexCount;
+        indexOffset += block->indexCount;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    VBO = buffers[0];
+    EBO = buffers[1];
+    vertexCapacity = usedVertices;
+    indexCapacity = usedIndices;
+    freeVertices.clear();
+    freeIndices.clear();
+    setupVertexArray();
+}
+
+void GeometryArena::grow(size_t newVertexCapacity, size_t newIndexCapacity)
+{
+    unsigned int buffers[2];
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+    glBufferData(GL_COPY_WRITE_BUFFER, newVertexCapacity * vertexSize, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+    glBufferData(GL_COPY_WRITE_BUFFER, newIndexCapacity * indexSize, nullptr, GL_STATIC_DRAW);
+
+    if (VBO != 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertexCapacity * vertexSize);
+        glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, indexCapacity * indexSize);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    freeVertices.free(vertexCapacity, newVertexCapacity - vertexCapacity);
+    freeIndices.free(indexCapacity, newIndexCapacity - indexCapacity);
+    VBO = buffers[0];
+    EBO = buffers[1];
+    vertexCapacity = newVertexCapacity;
+    indexCapacity = newIndexCapacity;
+    setupVertexArray();
+}
+
+void GeometryArena::setupVertexArray()
+{
+    if (VAO == 0)
+        glGenVertexArrays(1, &VAO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    // Set the vertex attribute pointers
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    if (compactVertices)
+    {
+        // Positions, normalized to mesh bounds
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, Position));
+        // Normals
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, Normal));
+        // Texture coords
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), (void*)offsetof(CompactVertex, TexCoords));
+    }
+    else
+    {
+        // Positions
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // Normals
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        // Texture coords
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+size_t GeometryArena::FreeList::allocate(size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    // first fit keeps used ranges close to the beginning of buffer
+    for (auto it = ranges.begin(); it != ranges.end(); ++it)
+    {
+        if (it->second < size)
+            continue;
+
+        size_t offset = it->first;
+        size_t rest = it->second - size;
+        ranges.erase(it);
+        if (rest > 0)
+            ranges.emplace(offset + size, rest);
+        return offset;
+    }
+    return NO_RANGE;
+}
+
+void GeometryArena::FreeList::free(size_t offset, size_t size)
+{
+    if (size == 0)
+        return;
+
+    auto next = ranges.lower_bound(offset);
+    // merge with following range
+    if (next != ranges.end() && offset + size == next->first)
+    {
+        size += next->second;
+        next = ranges.erase(next);
+    }
+    // merge with preceding range
+    if (next != ranges.begin())
+    {
+        auto previous = prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += size;
+            return;
+        }
+    }
+    ranges.emplace_hint(next, offset, size);
+}
+
+bool MultiDraw::accepts(const Geometry& geometry, unsigned int material) const
+{
+    return empty() || (geometry.arena == arena
+                       && geometry.positionScale == first->positionScale
+                       && geometry.positionOffset == first->positionOffset
+                       && (GLAD_GL_VERSION_4_3 || material == materials.front()));
+}
+
+void MultiDraw::add(const Geometry& geometry, unsigned int lod, unsigned int material)
+{
+    if (empty())
+        first = &geometry;
+    arena = geometry.arena;
+    const GeometryArena::Block& block = arena->getBlock(geometry.block);
+    const Geometry::Lod& range = geometry.lods[min<size_t>(lod, geometry.lods.size() - 1)];
+
+    size_t firstIndex = block.indexOffset + range.indexOffset;
+    counts.push_back(static_cast<GLsizei>(range.indexCount));
+    offsets.push_back(reinterpret_cast<const void*>(firstIndex * arena->getIndexSize()));
+    baseVertices.push_back(static_cast<GLint>(block.vertexOffset));
+    // base instance points instanced material attribute to this draw's entry
+    commands.push_back({ range.indexCount, 1, static_cast<GLuint>(firstIndex), static_cast<GLint>(block.vertexOffset),
+                         static_cast<GLuint>(materials.size()) });
+    materials.push_back(material);
+}
+
+void MultiDraw::submit(const Shader& shader)
+{
+    if (empty())
+        return;
+
+    shader.setVec3("positionScale", first->positionScale);
+    shader.setVec3("positionOffset", first->positionOffset);
+    arena->bind();
+    if (GLAD_GL_VERSION_4_3)
+    {
+        if (indirectBuffer == 0)
+        {
+            glGenBuffers(1, &indirectBuffer);
+            glGenBuffers(1, &materialBuffer);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, materialBuffer);
+        glBufferData(GL_ARRAY_BUFFER, materials.size() * sizeof(GLuint), materials.data(), GL_STREAM_DRAW);
+        // the array is enabled only for this call, other draws of the arena use current attribute value
+        glEnableVertexAttribArray(MATERIAL_ATTRIBUTE);
+        glVertexAttribIPointer(MATERIAL_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+        glVertexAttribDivisor(MATERIAL_ATTRIBUTE, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, arena->getIndexType(), nullptr, static_cast<GLsizei>(commands.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDisableVertexAttribArray(MATERIAL_ATTRIBUTE);
+    }
+    else
+    {
+        glVertexAttribI4ui(MATERIAL_ATTRIBUTE, materials.front(), 0, 0, 0);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), arena->getIndexType(), offsets.data(),
+                                      static_cast<GLsizei>(counts.size()), baseVertices.data());
+    }
+    glBindVertexArray(0);
+
+    counts.clear();
+    offsets.clear();
+    baseVertices.clear();
+    commands.clear();
+    materials.clear();
+}
@@ -0,0 +1,134 @@
+#include <Objects/GeometryCache.h>
+#include <Objects/CompactVertex.h>
+#include <Objects/GeometryArena.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+unordered_map<uint64_t, vector<weak_ptr<const Geometry>>> GeometryCache::geometries;
+size_t GeometryCache::shared = 0;
+size_t GeometryCache::savedMemory = 0;
+
+shared_ptr<const Geometry> GeometryCache::acquire(vector<Vertex> vertices, vector<unsigned int> indices, vector<Geometry::Lod> lods, bool compact)
+{
+    if (lods.empty())
+        lods.push_back({ 0, static_cast<unsigned int>(indices.size()), 0.0f });
+
+    vector<weak_ptr<const Geometry>>& bucket = geometries[hash(vertices, indices)];
+    // geometries of unloaded models are gone already
+    bucket.erase(remove_if(bucket.begin(), bucket.end(), [](const weak_ptr<const Geometry>& entry) { return entry.expired(); }),
+                 bucket.end());
+    for (const weak_ptr<const Geometry>& entry : bucket)
+    {
+        shared_ptr<const Geometry> geometry = entry.lock();
+        if (equal(*geometry, vertices, indices, lods, compact))
+        {
+            ++shared;
+            savedMemory += geometry->getMemoryUsage();
+            return geometry;
+        }
+    }
+
+    shared_ptr<Geometry> geometry = make_shared<Geometry>();
+    geometry->vertices = move(vertices);
+    geometry->indices = move(indices);
+    geometry->lods = move(lods);
+    geometry->compact = compact;
+    if (!geometry->vertices.empty())
+        geometry->boundsMin = geometry->boundsMax = geometry->vertices[0].Position;
+    for (const Vertex& vertex : geometry->vertices)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            geometry->boundsMin[i] = min(geometry->boundsMin[i], vertex.Position[i]);
+            geometry->boundsMax[i] = max(geometry->boundsMax[i], vertex.Position[i]);
+        }
+    }
+    // every index fits 16 bits when there are no more vertices than 16-bit values
+    if (geometry->vertices.size() <= size_t(numeric_limits<GLushort>::max()) + 1)
+        geometry->indexType = GL_UNSIGNED_SHORT;
+    upload(*geometry);
+    bucket.push_back(geometry);
+    return geometry;
+}
+
+void GeometryCache::printStatistics(ostream& out)
+{
+    size_t live = 0;
+    for (const auto& bucket : geometries)
+    {
+        for (const weak_ptr<const Geometry>& entry : bucket.second)
+            live += entry.expired() ? 0 : 1;
+    }
+
+    out << "GEOMETRY_CACHE:: unique geometries: " << live
+        << ", shared: " << shared
+        << ", memory saved: " << savedMemory / 1024 << " KB" << endl;
+}
+
+uint64_t GeometryCache::hash(const vector<Vertex>& vertices, const vector<unsigned int>& indices)
+{
+    // FNV-1a over raw bytes of vertex and index data
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    uint64_t result = FNV_OFFSET_BASIS;
+    auto process = [&result](const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            result ^= bytes[i];
+            result *= FNV_PRIME;
+        }
+    };
+    process(vertices.data(), vertices.size() * sizeof(Vertex));
+    // separate vertex and index data, so different splits of the same bytes don't collide
+    uint64_t vertexCount = vertices.size();
+    process(&vertexCount, sizeof(vertexCount));
+    process(indices.data(), indices.size() * sizeof(unsigned int));
+    return result;
+}
+
+bool GeometryCache::equal(const Geometry& geometry, const vector<Vertex>& vertices, const vector<unsigned int>& indices,
+                          const vector<Geometry::Lod>& lods, bool compact)
+{
+    auto equalLods = [](const Geometry::Lod& left, const Geometry::Lod& right)
+    {
+        return left.indexOffset == right.indexOffset && left.indexCount == right.indexCount;
+    };
+    return geometry.compact == compact &&
+           std::equal(geometry.lods.begin(), geometry.lods.end(), lods.begin(), lods.end(), equalLods) &&
+           geometry.vertices.size() == vertices.size() &&
+           geometry.indices.size() == indices.size() &&
+           memcmp(geometry.vertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0 &&
+           memcmp(geometry.indices.data(), indices.data(), indices.size() * sizeof(unsigned int)) == 0;
+}
+
+void GeometryCache::upload(Geometry& geometry)
+{
+    GeometryArena& arena = GeometryArena::get(geometry.compact, geometry.indexType);
+
+    // data is converted to GPU layout only for the copy, CPU side always keeps full vertices
+    vector<CompactVertex> compactVertices;
+    const void* vertices = geometry.vertices.data();
+    if (geometry.compact)
+    {
+        compactVertices = compressVertices(geometry.vertices, geometry.positionScale, geometry.positionOffset);
+        vertices = compactVertices.data();
+    }
+
+    vector<GLushort> shortIndices;
+    const void* indices = geometry.indices.data();
+    if (geometry.indexType == GL_UNSIGNED_SHORT)
+    {
+        shortIndices.assign(geometry.indices.begin(), geometry.indices.end());
+        indices = shortIndices.data();
+    }
+
+    geometry.block = arena.allocate(vertices, geometry.vertices.size(), indices, geometry.indices.size());
+    geometry.arena = &arena;
+}
@@ -0,0 +1,269 @@
+#include <Objects/ImpostorRenderer.h>
+#include <Objects/Material.h>
+#include <CameraBuffer.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    const unsigned int INITIAL_CAPACITY = 8;
+
+    // Direction for point of octahedral map in [-1, 1] range, must match impostor.vert
+    glm::vec3 octahedralDecode(glm::vec2 point)
+    {
+        glm::vec3 result(point.x, point.y, 1.0f - abs(point.x) - abs(point.y));
+        if (result.z < 0.0f)
+        {
+            float x = (1.0f - abs(result.y)) * (result.x >= 0.0f ? 1.0f : -1.0f);
+            float y = (1.0f - abs(result.x)) * (result.y >= 0.0f ? 1.0f : -1.0f);
+            result.x = x;
+            result.y = y;
+        }
+        return glm::normalize(result);
+    }
+
+    // Up direction of the view along direction, must match impostor.vert
+    glm::vec3 viewUp(const glm::vec3& direction)
+    {
+        return abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+ImpostorRenderer::ImpostorRenderer(float distance)
+    : distance(distance)
+    , bakeShader("shaders/pbr.vert", "shaders/impostor_bake.frag")
+{
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, ATLAS_SIZE, ATLAS_SIZE);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    MaterialLibrary::setupShader(bakeShader);
+    CameraBuffer::setupShader(bakeShader);
+    allocate(INITIAL_CAPACITY);
+
+    // unit quad, corners are placed in vertex shader
+    float corners[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f
+    };
+    glGenVertexArrays(1, &quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    // per-instance attributes
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, sphere));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, rotation));
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, layer));
+    glVertexAttribDivisor(3, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+ImpostorRenderer::~ImpostorRenderer()
+{
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteTextures(1, &albedoTexture);
+    glDeleteTextures(1, &normalDepthTexture);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void ImpostorRenderer::bake(const shared_ptr<Model>& model)
+{
+    if (isBaked(model.get()))
+        return;
+
+    unsigned int layer;
+    if (!freeLayers.empty())
+    {
+        layer = freeLayers.back();
+        freeLayers.pop_back();
+        baked[layer] = model;
+    }
+    else
+    {
+        if (baked.size() == capacity)
+        {
+            // texture arrays can't grow, so all models are baked again into larger ones
+            allocate(capacity * 2);
+            for (unsigned int i = 0; i < baked.size(); ++i)
+            {
+                if (shared_ptr<Model> previous = baked[i].lock())
+                    bakeLayer(*previous, i);
+            }
+        }
+        layer = static_cast<unsigned int>(baked.size());
+        baked.push_back(model);
+    }
+    layers[model.get()] = layer;
+    bakeLayer(*model, layer);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, albedoTexture);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, normalDepthTexture);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void ImpostorRenderer::releaseUnused()
+{
+    // address of destroyed model may be taken by a new one, so its entry must go before next bake
+    for (auto it = layers.begin(); it != layers.end();)
+    {
+        if (baked[it->second].expired())
+        {
+            freeLayers.push_back(it->second);
+            it = layers.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+bool ImpostorRenderer::isFar(const ObjectStore& objects, size_t index, const glm::vec3& cameraPosition) const
+{
+    return isFar(objects.getBoundingSphere(index), cameraPosition);
+}
+
+bool ImpostorRenderer::isFar(const glm::vec4& sphere, const glm::vec3& cameraPosition) const
+{
+    return glm::length(glm::vec3(sphere) - cameraPosition) - sphere.w > distance;
+}
+
+void ImpostorRenderer::add(const ObjectStore& objects, size_t index)
+{
+    // the same rotation as in model matrices of ObjectStore
+    const glm::vec3& angles = objects.getRotation(index);
+    glm::quat rotation(glm::vec3(glm::radians(angles.x), glm::radians(angles.y), glm::radians(angles.z)));
+
+    Instance instance;
+    instance.sphere = objects.getBoundingSphere(index);
+    instance.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+    instance.layer = static_cast<float>(layers.at(&objects.getModel(index)));
+    instances.push_back(instance);
+}
+
+void ImpostorRenderer::render(const Shader& shader, const glm::vec3& cameraPosition)
+{
+    if (instances.empty())
+        return;
+
+    // buffer is orphaned every frame, so driver doesn't wait until previous frame is drawn
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shader.use();
+    shader.setVec3("cameraPos", cameraPosition);
+    shader.setInt("framesNumber", FRAMES_NUMBER);
+    shader.setInt("impostorAlbedo", 0);
+    shader.setInt("impostorNormalDepth", 1);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, albedoTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, normalDepthTexture);
+
+    glBindVertexArray(quadVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    instances.clear();
+}
+
+void ImpostorRenderer::allocate(unsigned int capacity)
+{
+    this->capacity = capacity;
+    glDeleteTextures(1, &albedoTexture);
+    glDeleteTextures(1, &normalDepthTexture);
+
+    for (unsigned int* texture : { &albedoTexture, &normalDepthTexture })
+    {
+        glGenTextures(1, texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, *texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, ATLAS_SIZE, ATLAS_SIZE, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // frames are small, coarser mipmaps would mix neighbouring views
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 3);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void ImpostorRenderer::bakeLayer(Model& model, unsigned int layer)
+{
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, albedoTexture, 0, layer);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, normalDepthTexture, 0, layer);
+    GLenum attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+
+    // zero alpha marks pixels not covered by model
+    glViewport(0, 0, ATLAS_SIZE, ATLAS_SIZE);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // model space is rendered, so normals are stored in model space too
+    bakeShader.use();
+    bakeShader.setMat4("model", glm::mat4(1.0f));
+    bakeShader.setMat3("normalMatrix", glm::mat3(1.0f));
+    MaterialLibrary::bind();
+
+    glm::vec3 center = model.getBoundsCenter();
+    float radius = model.getBoundsRadius();
+    // depth is 0 on the sphere side facing the view and 1 on the opposite side
+    glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+
+    for (int y = 0; y < FRAMES_NUMBER; ++y)
+    {
+        for (int x = 0; x < FRAMES_NUMBER; ++x)
+        {
+            glm::vec2 point((x + 0.5f) / FRAMES_NUMBER * 2.0f - 1.0f, (y + 0.5f) / FRAMES_NUMBER * 2.0f - 1.0f);
+            glm::vec3 direction = octahedralDecode(point);
+
+            glViewport(x * FRAME_SIZE, y * FRAME_SIZE, FRAME_SIZE, FRAME_SIZE);
+            // camera buffer is written again before the next frame is submitted
+            CameraBuffer::update(projection, glm::lookAt(center + direction * radius, center, viewUp(direction)));
+            model.Draw(bakeShader);
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,307 @@
+#include <Objects/InstanceCuller.h>
+#include <Objects/Material.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+using namespace std;
+
+namespace
+{
+    // Location of bounding sphere attribute, must match instance_cull.vert
+    const GLuint SPHERE_ATTRIBUTE = 0;
+}
+
+void InstanceCuller::build(const ObjectStore& objects)
+{
+    release();
+    instanced.assign(objects.size(), false);
+
+    // objects of every model in order of first appearance
+    map<ModelHandle, size_t> modelIndices;
+    vector<vector<size_t>> modelObjects;
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (!objects.isStatic(i))
+            continue;
+        auto inserted = modelIndices.emplace(objects.getModelHandle(i), modelObjects.size());
+        if (inserted.second)
+            modelObjects.emplace_back();
+        modelObjects[inserted.first->second].push_back(i);
+    }
+
+    vector<glm::vec4> spheres;
+    vector<glm::mat4> transforms;
+    for (const vector<size_t>& indices : modelObjects)
+    {
+        if (indices.size() < MIN_INSTANCES)
+            continue;
+
+        Group group;
+        group.model = objects.getModelPointer(objects.getModelHandle(indices.front())).get();
+        group.first = spheres.size();
+        group.count = indices.size();
+        group.lods = min(group.model->getLodsNumber(), ObjectStore::getMaxLods());
+        group.firstResult = resultsNumber;
+        group.firstOutput = outputsNumber;
+        resultsNumber += group.lods;
+        outputsNumber += group.lods * group.count;
+
+        glm::vec3 boundsMin(numeric_limits<float>::max());
+        glm::vec3 boundsMax(-numeric_limits<float>::max());
+        for (size_t i : indices)
+        {
+            const glm::vec4& sphere = objects.getBoundingSphere(i);
+            boundsMin = glm::min(boundsMin, glm::vec3(sphere) - glm::vec3(sphere.w));
+            boundsMax = glm::max(boundsMax, glm::vec3(sphere) + glm::vec3(sphere.w));
+            spheres.push_back(sphere);
+            transforms.push_back(objects.getModelMatrix(i));
+            instanced[i] = true;
+        }
+        group.center = (boundsMin + boundsMax) * 0.5f;
+
+        for (const Mesh& mesh : group.model->meshes)
+        {
+            if (MaterialLibrary::get(mesh.getMaterial()).isTransparent())
+                group.transparent = true;
+            else
+                group.opaque = true;
+        }
+        groups.push_back(group);
+    }
+    instancesNumber = spheres.size();
+    if (groups.empty())
+        return;
+
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &sphereBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereBuffer);
+    glBufferData(GL_ARRAY_BUFFER, spheres.size() * sizeof(glm::vec4), spheres.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(SPHERE_ATTRIBUTE);
+    glVertexAttribPointer(SPHERE_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glBindVertexArray(0);
+
+    // every matrix takes four texels, one per column
+    glGenBuffers(1, &transformBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, transformBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, transforms.size() * sizeof(glm::mat4), transforms.data(), GL_STATIC_DRAW);
+    glGenTextures(1, &transformTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, transformTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, transformBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    for (Frame& frame : frames)
+    {
+        glGenBuffers(1, &frame.buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, frame.buffer);
+        glBufferData(GL_ARRAY_BUFFER, outputsNumber * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+        frame.queries.resize(resultsNumber);
+        frame.counts.assign(resultsNumber, 0);
+        glGenQueries(static_cast<GLsizei>(resultsNumber), frame.queries.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    cout << "INSTANCE_CULLER:: models: " << groups.size() << ", instances: " << instancesNumber << endl;
+}
+
+void InstanceCuller::release()
+{
+    for (Frame& frame : frames)
+    {
+        if (frame.buffer != 0)
+            glDeleteBuffers(1, &frame.buffer);
+        if (!frame.queries.empty())
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        frame = Frame();
+    }
+    if (vertexArray != 0)
+        glDeleteVertexArrays(1, &vertexArray);
+    if (sphereBuffer != 0)
+        glDeleteBuffers(1, &sphereBuffer);
+    if (transformTexture != 0)
+        glDeleteTextures(1, &transformTexture);
+    if (transformBuffer != 0)
+        glDeleteBuffers(1, &transformBuffer);
+    vertexArray = sphereBuffer = transformTexture = transformBuffer = 0;
+
+    groups.clear();
+    instanced.clear();
+    instancesNumber = resultsNumber = outputsNumber = 0;
+    frameNumber = 0;
+    drawn = nullptr;
+}
+
+void InstanceCuller::cull(const Shader& cullShader, const Frustum& frustum, const glm::vec3& cameraPosition, float fieldOfView)
+{
+    drawn = nullptr;
+    if (groups.empty())
+        return;
+
+    ++frameNumber;
+    Frame& frame = frames[frameNumber % FRAMES_NUMBER];
+
+    cullShader.use();
+    for (int i = 0; i < Frustum::PLANES_NUMBER; ++i)
+        cullShader.setVec4("planes[" + to_string(i) + "]", frustum.getPlane(i));
+    cullShader.setVec3("cameraPos", cameraPosition);
+    cullShader.setFloat("tanHalfFov", tan(fieldOfView * 0.5f));
+
+    // only transform feedback output is needed
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(vertexArray);
+    for (const Group& group : groups)
+    {
+        for (unsigned int lod = 0; lod < group.lods; ++lod)
+        {
+            // the last level takes everything smaller than the previous one
+            cullShader.setFloat("minScreenSize", lod + 1 < group.lods ? ObjectStore::getLodScreenSize(lod) : 0.0f);
+            cullShader.setFloat("maxScreenSize", lod == 0 ? numeric_limits<float>::max() : ObjectStore::getLodScreenSize(lod - 1));
+
+            GLintptr offset = static_cast<GLintptr>((group.firstOutput + lod * group.count) * sizeof(GLuint));
+            glBindBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, 0, frame.buffer, offset, group.count * sizeof(GLuint));
+            glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, frame.queries[group.firstResult + lod]);
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, static_cast<GLint>(group.first), static_cast<GLsizei>(group.count));
+            glEndTransformFeedback();
+            glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+        }
+    }
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    frame.number = frameNumber;
+    frame.resolved = false;
+
+    // the latest results which are ready, this frame is waited for only when none of previous ones has them
+    for (int age = 1; age < FRAMES_NUMBER && !drawn; ++age)
+    {
+        Frame& previous = frames[(frameNumber - age) % FRAMES_NUMBER];
+        if (previous.number != 0 && previous.number + age == frameNumber && resolve(previous, false))
+            drawn = &previous;
+    }
+    if (!drawn)
+    {
+        resolve(frame, true);
+        drawn = &frame;
+    }
+}
+
+bool InstanceCuller::resolve(Frame& frame, bool wait)
+{
+    if (frame.resolved)
+        return true;
+
+    if (!wait)
+    {
+        for (GLuint query : frame.queries)
+        {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE)
+                return false;
+        }
+    }
+    for (size_t i = 0; i < frame.queries.size(); ++i)
+        glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT, &frame.counts[i]);
+    frame.resolved = true;
+    return true;
+}
+
+void InstanceCuller::submit(RenderQueue& queue, unsigned int program, unsigned int transparentProgram)
+{
+    if (!drawn)
+        return;
+
+    for (const Group& group : groups)
+    {
+        GLuint visible = 0;
+        for (unsigned int lod = 0; lod < group.lods; ++lod)
+            visible += drawn->counts[group.firstResult + lod];
+        if (visible == 0)
+            continue;
+
+        float depth = queue.getDepth(group.center);
+        if (group.opaque)
+        {
+            queue.submit(RenderQueue::PASS_OPAQUE, program, depth,
+                [this, &group](const Shader& shader) { render(shader, group, false); });
+        }
+        if (group.transparent)
+        {
+            queue.submit(RenderQueue::PASS_TRANSPARENT, transparentProgram, depth,
+                [this, &group](const Shader& shader) { render(shader, group, true); });
+        }
+    }
+}
+
+void InstanceCuller::render(const Shader& shader, const Group& group, bool transparent) const
+{
+    glActiveTexture(GL_TEXTURE0 + TRANSFORMS_TEXTURE_INDEX);
+    glBindTexture(GL_TEXTURE_BUFFER, transformTexture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setBool("instanced", true);
+
+    for (unsigned int lod = 0; lod < group.lods; ++lod)
+    {
+        GLuint count = drawn->counts[group.firstResult + lod];
+        if (count == 0)
+            continue;
+
+        size_t offset = (group.firstOutput + lod * group.count) * sizeof(GLuint);
+        for (const Mesh& mesh : group.model->meshes)
+        {
+            if (MaterialLibrary::get(mesh.getMaterial()).isTransparent() != transparent)
+                continue;
+
+            const Geometry& geometry = *mesh.getGeometry();
+            const GeometryArena::Block& block = geometry.arena->getBlock(geometry.block);
+            const Geometry::Lod& range = geometry.lods[min<size_t>(lod, geometry.lods.size() - 1)];
+            shader.setVec3("positionScale", geometry.positionScale);
+            shader.setVec3("positionOffset", geometry.positionOffset);
+
+            // the array is enabled only for this call, like materials of multi-draws
+            geometry.arena->bind();
+            glBindBuffer(GL_ARRAY_BUFFER, drawn->buffer);
+            glEnableVertexAttribArray(INSTANCE_ATTRIBUTE);
+            glVertexAttribIPointer(INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, sizeof(GLuint), reinterpret_cast<const void*>(offset));
+            glVertexAttribDivisor(INSTANCE_ATTRIBUTE, 1);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glVertexAttribI4ui(MATERIAL_ATTRIBUTE, mesh.getMaterial(), 0, 0, 0);
+
+            size_t firstIndex = block.indexOffset + range.indexOffset;
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), geometry.arena->getIndexType(),
+                                              reinterpret_cast<const void*>(firstIndex * geometry.arena->getIndexSize()),
+                                              static_cast<GLsizei>(count), static_cast<GLint>(block.vertexOffset));
+
+            glVertexAttribDivisor(INSTANCE_ATTRIBUTE, 0);
+            glDisableVertexAttribArray(INSTANCE_ATTRIBUTE);
+        }
+    }
+    glBindVertexArray(0);
+    shader.setBool("instanced", false);
+}
+
+void InstanceCuller::setupShader(const Shader& shader)
+{
+    shader.use();
+    shader.setInt("instanceTransforms", TRANSFORMS_TEXTURE_INDEX);
+}
+
+void InstanceCuller::printStatistics(ostream& out) const
+{
+    size_t visible = 0;
+    if (drawn)
+    {
+        for (GLuint count : drawn->counts)
+            visible += count;
+    }
+    out << "INSTANCE_CULLER:: models: " << groups.size()
+        << ", instances: " << instancesNumber
+        << ", visible: " << visible
+        << ", latency: " << (drawn ? frameNumber - drawn->number : 0) << " frames" << endl;
+}
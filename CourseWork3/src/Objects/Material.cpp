@@ -0,0 +1,63 @@
+#include <Objects/Material.h>
+
+#include <algorithm>
+
+using namespace std;
+
+vector<Material> MaterialLibrary::materials;
+size_t MaterialLibrary::uploaded = 0;
+unsigned int MaterialLibrary::buffer = 0;
+
+unsigned int MaterialLibrary::acquire(const Material& material)
+{
+    auto found = find(materials.begin(), materials.end(), material);
+    if (found != materials.end())
+        return static_cast<unsigned int>(found - materials.begin());
+
+    if (materials.size() == MAX_MATERIALS)
+    {
+        cout << "ERROR::MATERIAL_LIBRARY::TOO_MANY_MATERIALS first material is used instead" << endl;
+        return 0;
+    }
+    materials.push_back(material);
+    return static_cast<unsigned int>(materials.size() - 1);
+}
+
+void MaterialLibrary::bind()
+{
+    if (buffer == 0)
+    {
+        // buffer has room for all materials, so it is never reallocated
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(MaterialData), nullptr, GL_STATIC_DRAW);
+    }
+    else
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+    if (uploaded < materials.size())
+    {
+        vector<MaterialData> data;
+        for (size_t i = uploaded; i < materials.size(); ++i)
+        {
+            const Material& material = materials[i];
+            data.push_back({ { material.albedo.array, material.albedo.layer, material.normal.array, material.normal.layer },
+                             { material.metallic.array, material.metallic.layer, material.roughness.array, material.roughness.layer },
+                             { material.opacityRatio, material.refractionRatio, 0.0f, 0.0f } });
+        }
+        glBufferSubData(GL_UNIFORM_BUFFER, uploaded * sizeof(MaterialData), data.size() * sizeof(MaterialData), data.data());
+        uploaded = materials.size();
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, buffer);
+
+    TexturePool::bind();
+}
+
+void MaterialLibrary::setupShader(const Shader& shader)
+{
+    unsigned int block = glGetUniformBlockIndex(shader.ID, "Materials");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, block, BINDING);
+    TexturePool::setupShader(shader);
+}
@@ -0,0 +1,372 @@
+#include <Objects/MeshOptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+    // Parameters of Forsyth's vertex scoring, values are taken from the original article
+    const int   SCORING_CACHE_SIZE  = 32;
+    const float CACHE_DECAY_POWER   = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    const unsigned int NO_INDEX = ~0u;
+
+    float vertexScore(int cachePosition, unsigned int activeTriangles)
+    {
+        // vertex isn't used by any remaining triangle
+        if (activeTriangles == 0)
+            return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // vertices of the last triangle get fixed score, so the next one doesn't just reuse its edge
+            if (cachePosition < 3)
+                score = LAST_TRIANGLE_SCORE;
+            else
+                score = pow(1.0f - float(cachePosition - 3) / (SCORING_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        // vertices with few triangles left are preferred to get rid of them quickly
+        score += VALENCE_BOOST_SCALE * pow(float(activeTriangles), -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    // FIFO cache simulation, vertex is in cache if it was added less than cacheSize misses ago
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t verticesNumber, unsigned int cacheSize)
+            : cacheSize(cacheSize)
+            , timestamps(verticesNumber, 0)
+            , timestamp(cacheSize + 1)
+        {
+        }
+
+        // returns number of vertices of the triangle which had to be transformed
+        unsigned int add(const unsigned int* triangle)
+        {
+            unsigned int misses = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                unsigned int vertex = triangle[i];
+                if (timestamp - timestamps[vertex] > cacheSize)
+                {
+                    timestamps[vertex] = timestamp++;
+                    ++misses;
+                }
+            }
+            return misses;
+        }
+
+        void clear() { timestamp += cacheSize + 1; }
+
+    private:
+        unsigned int cacheSize;
+        vector<unsigned int> timestamps;
+        unsigned int timestamp;
+    };
+
+    struct VertexHash
+    {
+        size_t operator()(const Vertex& vertex) const
+        {
+            // FNV-1a over raw bytes of the vertex
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+            uint64_t result = 14695981039346656037ull;
+            for (size_t i = 0; i < sizeof(Vertex); ++i)
+            {
+                result ^= bytes[i];
+                result *= 1099511628211ull;
+            }
+            return static_cast<size_t>(result);
+        }
+    };
+
+    struct VertexEqual
+    {
+        bool operator()(const Vertex& left, const Vertex& right) const
+        {
+            return memcmp(&left, &right, sizeof(Vertex)) == 0;
+        }
+    };
+}
+
+MeshOptimizer::Statistics MeshOptimizer::optimize(vector<Vertex>& vertices, vector<unsigned int>& indices)
+{
+    Statistics statistics;
+    statistics.verticesBefore = vertices.size();
+    statistics.acmrBefore = computeACMR(indices, vertices.size());
+
+    weldVertices(vertices, indices);
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+
+    statistics.verticesAfter = vertices.size();
+    statistics.acmrAfter = computeACMR(indices, vertices.size());
+    return statistics;
+}
+
+void MeshOptimizer::weldVertices(vector<Vertex>& vertices, vector<unsigned int>& indices)
+{
+    unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+    unique.reserve(vertices.size());
+
+    vector<unsigned int> remap(vertices.size());
+    vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        auto it = unique.emplace(vertices[i], static_cast<unsigned int>(welded.size())).first;
+        if (it->second == welded.size())
+            welded.push_back(vertices[i]);
+        remap[i] = it->second;
+    }
+
+    for (unsigned int& index : indices)
+        index = remap[index];
+    vertices.swap(welded);
+}
+
+void MeshOptimizer::optimizeVertexCache(vector<unsigned int>& indices, size_t verticesNumber)
+{
+    size_t trianglesNumber = indices.size() / 3;
+    if (trianglesNumber == 0)
+        return;
+
+    // triangles using every vertex, emitted triangles are moved past the active ones
+    vector<unsigned int> activeTriangles(verticesNumber, 0);
+    for (unsigned int index : indices)
+        ++activeTriangles[index];
+
+    vector<unsigned int> offsets(verticesNumber + 1, 0);
+    for (size_t i = 0; i < verticesNumber; ++i)
+        offsets[i + 1] = offsets[i] + activeTriangles[i];
+
+    vector<unsigned int> adjacency(indices.size());
+    vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[filled[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+    vector<int> cachePositions(verticesNumber, -1);
+    vector<float> vertexScores(verticesNumber);
+    for (size_t i = 0; i < verticesNumber; ++i)
+        vertexScores[i] = vertexScore(-1, activeTriangles[i]);
+
+    vector<float> triangleScores(trianglesNumber);
+    for (size_t i = 0; i < trianglesNumber; ++i)
+        triangleScores[i] = vertexScores[indices[i * 3]] + vertexScores[indices[i * 3 + 1]] + vertexScores[indices[i * 3 + 2]];
+
+    vector<bool> emitted(trianglesNumber, false);
+    vector<unsigned int> result;
+    result.reserve(trianglesNumber * 3);
+
+    vector<unsigned int> cache;
+    vector<unsigned int> nextCache;
+    cache.reserve(SCORING_CACHE_SIZE + 3);
+    nextCache.reserve(SCORING_CACHE_SIZE + 3);
+
+    size_t scanPosition = 0;
+    unsigned int bestTriangle = static_cast<unsigned int>(max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    while (result.size() < trianglesNumber * 3)
+    {
+        if (bestTriangle == NO_INDEX)
+        {
+            // no candidates among cached vertices, continue with any remaining triangle
+            while (emitted[scanPosition])
+                ++scanPosition;
+            bestTriangle = static_cast<unsigned int>(scanPosition);
+        }
+
+        const unsigned int* triangle = &indices[bestTriangle * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[bestTriangle] = true;
+
+        // emitted triangle doesn't count for its vertices anymore
+        for (int i = 0; i < 3; ++i)
+        {
+            unsigned int vertex = triangle[i];
+            unsigned int* begin = &adjacency[offsets[vertex]];
+            unsigned int* end = begin + activeTriangles[vertex];
+            swap(*find(begin, end, bestTriangle), *(end - 1));
+            --activeTriangles[vertex];
+        }
+
+        // vertices of the triangle go to the front of LRU cache, the rest is shifted
+        nextCache.assign(triangle, triangle + 3);
+        for (unsigned int vertex : cache)
+        {
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                nextCache.push_back(vertex);
+        }
+        cache.swap(nextCache);
+
+        // update scores of cached and evicted vertices and their remaining triangles
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            unsigned int vertex = cache[i];
+            cachePositions[vertex] = i < SCORING_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+            float score = vertexScore(cachePositions[vertex], activeTriangles[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+            for (unsigned int j = offsets[vertex]; j < offsets[vertex] + activeTriangles[vertex]; ++j)
+                triangleScores[adjacency[j]] += delta;
+        }
+        if (cache.size() > SCORING_CACHE_SIZE)
+            cache.resize(SCORING_CACHE_SIZE);
+
+        // next triangle is the best one among triangles of cached vertices
+        bestTriangle = NO_INDEX;
+        float bestScore = -1.0f;
+        for (unsigned int vertex : cache)
+        {
+            for (unsigned int j = offsets[vertex]; j < offsets[vertex] + activeTriangles[vertex]; ++j)
+            {
+                unsigned int candidate = adjacency[j];
+                if (triangleScores[candidate] > bestScore)
+                {
+                    bestScore = triangleScores[candidate];
+                    bestTriangle = candidate;
+                }
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(vector<unsigned int>& indices, const vector<Vertex>& vertices, float threshold)
+{
+    size_t trianglesNumber = indices.size() / 3;
+    if (trianglesNumber == 0)
+        return;
+
+    // hard boundaries: triangles which miss the cache completely, splitting there costs nothing
+    vector<size_t> hardBoundaries;
+    FifoCache cache(vertices.size(), REPORT_CACHE_SIZE);
+    for (size_t i = 0; i < trianglesNumber; ++i)
+    {
+        if (cache.add(&indices[i * 3]) == 3)
+            hardBoundaries.push_back(i);
+    }
+    hardBoundaries.push_back(trianglesNumber);
+
+    // soft boundaries: cluster may be split as soon as its ACMR from cold cache is close to ACMR of the whole hard cluster
+    vector<size_t> boundaries;
+    for (size_t i = 0; i + 1 < hardBoundaries.size(); ++i)
+    {
+        size_t begin = hardBoundaries[i];
+        size_t end = hardBoundaries[i + 1];
+
+        cache.clear();
+        unsigned int misses = 0;
+        for (size_t j = begin; j < end; ++j)
+            misses += cache.add(&indices[j * 3]);
+        float clusterThreshold = threshold * misses / (end - begin);
+
+        cache.clear();
+        boundaries.push_back(begin);
+        size_t start = begin;
+        misses = 0;
+        for (size_t j = begin; j < end; ++j)
+        {
+            misses += cache.add(&indices[j * 3]);
+            if (j + 1 < end && misses <= clusterThreshold * (j + 1 - start))
+            {
+                boundaries.push_back(j + 1);
+                start = j + 1;
+                misses = 0;
+                cache.clear();
+            }
+        }
+    }
+    boundaries.push_back(trianglesNumber);
+
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    vector<glm::vec3> clusterCentroids(boundaries.size() - 1, glm::vec3(0.0f));
+    vector<glm::vec3> clusterNormals(boundaries.size() - 1, glm::vec3(0.0f));
+    for (size_t i = 0; i + 1 < boundaries.size(); ++i)
+    {
+        float clusterArea = 0.0f;
+        for (size_t j = boundaries[i]; j < boundaries[i + 1]; ++j)
+        {
+            const glm::vec3& a = vertices[indices[j * 3]].Position;
+            const glm::vec3& b = vertices[indices[j * 3 + 1]].Position;
+            const glm::vec3& c = vertices[indices[j * 3 + 2]].Position;
+
+            // length of the cross product is doubled area, so the sums below are area weighted
+            glm::vec3 normal = glm::cross(b - a, c - a);
+            float area = glm::length(normal);
+            glm::vec3 centroid = (a + b + c) * (area / 3.0f);
+
+            clusterCentroids[i] += centroid;
+            clusterNormals[i] += normal;
+            clusterArea += area;
+            meshCentroid += centroid;
+            meshArea += area;
+        }
+        if (clusterArea > 0.0f)
+            clusterCentroids[i] /= clusterArea;
+        float normalLength = glm::length(clusterNormals[i]);
+        if (normalLength > 0.0f)
+            clusterNormals[i] /= normalLength;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // clusters facing away from the center are likely to be on the outside and occlude others
+    vector<float> sortKeys(boundaries.size() - 1);
+    vector<size_t> order(boundaries.size() - 1);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        sortKeys[i] = glm::dot(clusterCentroids[i] - meshCentroid, clusterNormals[i]);
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&sortKeys](size_t left, size_t right) { return sortKeys[left] > sortKeys[right]; });
+
+    vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (size_t cluster : order)
+        result.insert(result.end(), indices.begin() + boundaries[cluster] * 3, indices.begin() + boundaries[cluster + 1] * 3);
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(vector<Vertex>& vertices, vector<unsigned int>& indices)
+{
+    vector<unsigned int> remap(vertices.size(), NO_INDEX);
+    vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == NO_INDEX)
+        {
+            remap[index] = static_cast<unsigned int>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+float MeshOptimizer::computeACMR(const vector<unsigned int>& indices, size_t verticesNumber, unsigned int cacheSize)
+{
+    size_t trianglesNumber = indices.size() / 3;
+    if (trianglesNumber == 0)
+        return 0.0f;
+
+    FifoCache cache(verticesNumber, cacheSize);
+    size_t misses = 0;
+    for (size_t i = 0; i < trianglesNumber; ++i)
+        misses += cache.add(&indices[i * 3]);
+    return float(misses) / trianglesNumber;
+}
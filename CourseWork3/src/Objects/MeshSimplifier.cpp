@@ -0,0 +1,271 @@
+#include <Objects/MeshSimplifier.h>
+#include <Objects/MeshOptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+using namespace std;
+
+namespace
+{
+    // Largest allowed error of every level relative to mesh size, coarser levels are shown smaller on screen
+    const float LOD_ERRORS[MeshSimplifier::MAX_LODS - 1] = { 0.01f, 0.02f, 0.04f };
+
+    // Every level aims to have half the triangles of previous one, smaller reduction isn't worth a level
+    const float MIN_LOD_REDUCTION = 0.75f;
+
+    // Cosine of the largest allowed rotation of triangle normal by one collapse
+    const float MAX_NORMAL_ROTATION_COS = 0.25f;
+
+    // Symmetric 4x4 matrix of squared distances to planes, weighted by areas of triangles
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double weight = 0;
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+            b2 += other.b2; bc += other.bc; bd += other.bd;
+            c2 += other.c2; cd += other.cd;
+            d2 += other.d2;
+            weight += other.weight;
+            return *this;
+        }
+
+        // mean squared distance from point to planes
+        double error(const glm::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double result = a2 * x * x + b2 * y * y + c2 * z * z
+                          + 2 * (ab * x * y + ac * x * z + bc * y * z)
+                          + 2 * (ad * x + bd * y + cd * z) + d2;
+            return weight > 0 ? max(result, 0.0) / weight : 0.0;
+        }
+    };
+
+    Quadric planeQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+    {
+        Quadric result;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        double area = glm::length(normal);
+        if (area == 0)
+            return result;
+
+        double a = normal.x / area, b = normal.y / area, c = normal.z / area;
+        double d = -(a * p0.x + b * p0.y + c * p0.z);
+        result.a2 = area * a * a; result.ab = area * a * b; result.ac = area * a * c; result.ad = area * a * d;
+        result.b2 = area * b * b; result.bc = area * b * c; result.bd = area * b * d;
+        result.c2 = area * c * c; result.cd = area * c * d;
+        result.d2 = area * d * d;
+        result.weight = area;
+        return result;
+    }
+
+    struct Collapse
+    {
+        unsigned int from;
+        unsigned int to;
+        double error;
+    };
+
+    // Vertices of edges which belong to exactly one triangle
+    vector<bool> findBorderVertices(const vector<unsigned int>& indices, size_t verticesNumber)
+    {
+        unordered_set<unsigned long long> edges;
+        edges.reserve(indices.size());
+        auto key = [](unsigned int from, unsigned int to) { return (static_cast<unsigned long long>(from) << 32) | to; };
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (int j = 0; j < 3; ++j)
+                edges.insert(key(indices[i + j], indices[i + (j + 1) % 3]));
+        }
+
+        vector<bool> result(verticesNumber, false);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                unsigned int from = indices[i + j];
+                unsigned int to = indices[i + (j + 1) % 3];
+                // consistently oriented neighbour has the same edge in opposite direction
+                if (edges.count(key(to, from)) == 0)
+                    result[from] = result[to] = true;
+            }
+        }
+        return result;
+    }
+}
+
+vector<Geometry::Lod> MeshSimplifier::generateLods(const vector<Vertex>& vertices, vector<unsigned int>& indices)
+{
+    vector<Geometry::Lod> lods{ { 0, static_cast<unsigned int>(indices.size()), 0.0f } };
+    if (vertices.empty())
+        return lods;
+
+    glm::vec3 minimum = vertices[0].Position;
+    glm::vec3 maximum = vertices[0].Position;
+    for (const Vertex& vertex : vertices)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            minimum[i] = min(minimum[i], vertex.Position[i]);
+            maximum[i] = max(maximum[i], vertex.Position[i]);
+        }
+    }
+    float size = glm::length(maximum - minimum);
+
+    vector<unsigned int> previous = indices;
+    for (unsigned int level = 1; level < MAX_LODS; ++level)
+    {
+        vector<unsigned int> lod = previous;
+        float error = simplify(vertices, lod, previous.size() / 6 * 3, LOD_ERRORS[level - 1] * size);
+        if (lod.size() > previous.size() * MIN_LOD_REDUCTION)
+            break;
+
+        MeshOptimizer::optimizeVertexCache(lod, vertices.size());
+        // errors of consecutive simplifications add up
+        lods.push_back({ static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(lod.size()), lods.back().error + error });
+        indices.insert(indices.end(), lod.begin(), lod.end());
+        previous = move(lod);
+    }
+    return lods;
+}
+
+float MeshSimplifier::simplify(const vector<Vertex>& vertices, vector<unsigned int>& indices, size_t targetIndices, float maxError)
+{
+    vector<Quadric> quadrics(vertices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        Quadric quadric = planeQuadric(vertices[indices[i]].Position, vertices[indices[i + 1]].Position, vertices[indices[i + 2]].Position);
+        for (int j = 0; j < 3; ++j)
+            quadrics[indices[i + j]] += quadric;
+    }
+    vector<bool> locked = findBorderVertices(indices, vertices.size());
+
+    double maxErrorSquared = double(maxError) * maxError;
+    double resultError = 0;
+
+    vector<unsigned int> offsets(vertices.size() + 1);
+    vector<unsigned int> adjacency;
+    vector<unsigned int> remap(vertices.size());
+    vector<bool> touched(vertices.size());
+    vector<Collapse> collapses;
+
+    // every pass collapses independent edges with the smallest errors, then triangles are rebuilt
+    while (indices.size() > targetIndices)
+    {
+        // triangles around every vertex
+        fill(offsets.begin(), offsets.end(), 0);
+        for (unsigned int index : indices)
+            ++offsets[index + 1];
+        for (size_t i = 0; i < vertices.size(); ++i)
+            offsets[i + 1] += offsets[i];
+        adjacency.resize(indices.size());
+        vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[filled[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+        // interior edges are shared by two triangles, so only the one with ascending vertices is taken
+        collapses.clear();
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                unsigned int a = indices[i + j];
+                unsigned int b = indices[i + (j + 1) % 3];
+                if (a > b || (locked[a] && locked[b]))
+                    continue;
+
+                Quadric quadric = quadrics[a];
+                quadric += quadrics[b];
+                double toB = locked[a] ? HUGE_VAL : quadric.error(vertices[b].Position);
+                double toA = locked[b] ? HUGE_VAL : quadric.error(vertices[a].Position);
+                if (toB <= toA)
+                    collapses.push_back({ a, b, toB });
+                else
+                    collapses.push_back({ b, a, toA });
+            }
+        }
+        sort(collapses.begin(), collapses.end(), [](const Collapse& left, const Collapse& right) { return left.error < right.error; });
+
+        for (size_t i = 0; i < remap.size(); ++i)
+            remap[i] = static_cast<unsigned int>(i);
+        fill(touched.begin(), touched.end(), false);
+
+        size_t trianglesToRemove = (indices.size() - targetIndices + 2) / 3;
+        size_t removed = 0;
+        size_t collapsed = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (collapse.error > maxErrorSquared || removed >= trianglesToRemove)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            // moving vertex must not flip any of its triangles which remain
+            const glm::vec3& target = vertices[collapse.to].Position;
+            bool flips = false;
+            size_t shared = 0;
+            for (unsigned int j = offsets[collapse.from]; j < offsets[collapse.from + 1] && !flips; ++j)
+            {
+                const unsigned int* triangle = &indices[adjacency[j] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+                {
+                    ++shared;
+                    continue;
+                }
+
+                glm::vec3 before[3];
+                glm::vec3 after[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    before[k] = vertices[triangle[k]].Position;
+                    after[k] = triangle[k] == collapse.from ? target : before[k];
+                }
+                glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                // large rotations are rejected too, several of them in a row would flip the triangle as well
+                flips = glm::dot(normalBefore, normalAfter) <= MAX_NORMAL_ROTATION_COS * glm::length(normalBefore) * glm::length(normalAfter);
+            }
+            if (flips)
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            // neighbours are frozen until next pass, so checks above stay valid for all collapses of the pass
+            for (unsigned int j = offsets[collapse.from]; j < offsets[collapse.from + 1]; ++j)
+            {
+                const unsigned int* triangle = &indices[adjacency[j] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+
+            removed += shared;
+            ++collapsed;
+            resultError = max(resultError, collapse.error);
+        }
+        if (collapsed == 0)
+            break;
+
+        // drop triangles which became degenerate
+        size_t written = 0;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            unsigned int a = remap[indices[i]];
+            unsigned int b = remap[indices[i + 1]];
+            unsigned int c = remap[indices[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            indices[written++] = a;
+            indices[written++] = b;
+            indices[written++] = c;
+        }
+        indices.resize(written);
+    }
+
+    return static_cast<float>(sqrt(resultError));
+}
@@ -1,39 +1,124 @@
 #include <Objects/Model.h>
+#include <Objects/GeometryArena.h>
+#include <Objects/GeometryCache.h>
+#include <Objects/Material.h>
+#include <Objects/MeshOptimizer.h>
+#include <Objects/MeshSimplifier.h>
 
 
-Model::Model(string const & path)
-{   
-    loadModel(path);
+Model::Model(string const & path, const ModelImportOptions& options)
+    : Model(import(path, options))
+{
 }
 
-void Model::Draw(Shader shader)
+Model::Model(ImportedModel&& imported)
+    : directory(imported.directory)
+    , path(imported.path)
+    , importOptions(imported.options)
 {
+    if (!imported.error.empty())
+    {
+        cout << "ERROR::ASSIMP:: " << imported.error << endl;
+        glfwTerminate();
+        //cin.ignore();
+        cin.get();
+        exit(-1);
+    }
+    cout << imported.log;
+
+    for (ImportedModel::ImportedMesh& mesh : imported.meshes)
+    {
+        // only the first map of every type is used
+        Material material = mesh.material;
+        TextureLayer* layers[] = { &material.albedo, &material.normal, &material.metallic, &material.roughness };
+        for (int type = 0; type < 4; ++type)
+        {
+            if (!mesh.texturePaths[type].empty())
+                *layers[type] = loadTexture(mesh.texturePaths[type], static_cast<TextureType>(type), imported).layer;
+        }
+
+        // meshes with byte-identical geometry share GPU buffers
+        bool compact = (importOptions.importSteps & IMPORT_COMPACT_VERTICES) != 0;
+        // equal materials of all models share one entry of material library
+        meshes.push_back(Mesh(GeometryCache::acquire(move(mesh.vertices), move(mesh.indices), move(mesh.lods), compact),
+                              MaterialLibrary::acquire(material)));
+    }
+
+    // bounds of the whole model, they are used to choose level of detail
+    if (meshes.empty())
+        return;
+    glm::vec3 boundsMin = meshes[0].getGeometry()->boundsMin;
+    glm::vec3 boundsMax = meshes[0].getGeometry()->boundsMax;
+    for (const Mesh& mesh : meshes)
+    {
+        const Geometry& geometry = *mesh.getGeometry();
+        for (int i = 0; i < 3; ++i)
+        {
+            boundsMin[i] = std::min(boundsMin[i], geometry.boundsMin[i]);
+            boundsMax[i] = std::max(boundsMax[i], geometry.boundsMax[i]);
+        }
+        lodsNumber = std::max(lodsNumber, static_cast<unsigned int>(geometry.lods.size()));
+    }
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+}
+
+void Model::Draw(Shader shader, unsigned int lod)
+{
+    // meshes are drawn with as few multi-draw calls as their arenas and materials allow
+    MultiDraw batch;
     for (unsigned int i = 0; i < meshes.size(); i++)
-        meshes[i].Draw(shader);
+    {
+        const Geometry& geometry = *meshes[i].getGeometry();
+        if (!batch.accepts(geometry, meshes[i].getMaterial()))
+            batch.submit(shader);
+        batch.add(geometry, lod, meshes[i].getMaterial());
+    }
+    batch.submit(shader);
+}
+
+std::size_t Model::getMemoryUsage() const
+{
+    std::size_t result = 0;
+    for (const Mesh& mesh : meshes)
+        result += mesh.getMemoryUsage();
+    for (const Texture& texture : textures_loaded)
+        result += texture.size;
+    return result;
 }
 
-void Model::loadModel(string const& path)
+std::size_t Model::getTrianglesNumber() const
 {
+    std::size_t result = 0;
+    for (const Mesh& mesh : meshes)
+        result += mesh.getGeometry()->lods.front().indexCount / 3;
+    return result;
+}
+
+ImportedModel Model::import(string const& path, const ModelImportOptions& options)
+{
+    ImportedModel model;
+    model.path = path;
+    model.options = options;
+
     // read file via ASSIMP
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate /*| aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices*/);
+    const aiScene* scene = importer.ReadFile(path, options.postProcessFlags);
     // check for errors
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
     {
-        cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-        glfwTerminate();
-        //cin.ignore();
-        cin.get();
-        exit(-1);
+        model.error = importer.GetErrorString();
+        return model;
     }
     // retrieve the directory path of the filepath
-    directory = path.substr(0, path.find_last_of('/'));
+    model.directory = path.substr(0, path.find_last_of('/'));
 
     // process ASSIMP's root node recursively
-    processNode(scene->mRootNode, scene);
+    processNode(scene->mRootNode, scene, model);
+    return model;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, ImportedModel& model)
 {
     // process each mesh located at the current node
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -41,21 +126,21 @@ void Model::processNode(aiNode* node, const aiScene* scene)
         // the node object only contains indices to index the actual objects in the scene. 
         // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        model.meshes.push_back(processMesh(mesh, scene, model));
     }
     // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, model);
     }
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+ImportedModel::ImportedMesh Model::processMesh(aiMesh* mesh, const aiScene* scene, ImportedModel& model)
 {
     // data to fill
-    vector<Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Texture> textures;
+    ImportedModel::ImportedMesh result;
+    vector<Vertex>& vertices = result.vertices;
+    vector<unsigned int>& indices = result.indices;
 
     // Walk through each of the mesh's vertices
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -102,100 +187,68 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
     // process materials
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];  
 
-    // albedo maps
-    vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, TextureType::Albedo); // map_Kd in .mtl
-    textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-    // metallic maps
-    vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, TextureType::Metallic); // map_Ks in .mtl
-    textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-    // normal maps
-    std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, TextureType::Normal); // map_Bump in .mtl
-    textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-    // roughness maps
-    std::vector<Texture> roughnessMaps = loadMaterialTextures(material, aiTextureType_NORMALS, TextureType::Roughness); // map_Kn in .mtl
-    textures.insert(textures.end(), roughnessMaps.begin(), roughnessMaps.end());
-
-    Mesh result(vertices, indices, textures);
-    
-    float opacity;
-    material->Get(AI_MATKEY_OPACITY, opacity);
-    result.setOpacityRatio(opacity);
-
-    float refraction;
-    material->Get(AI_MATKEY_REFRACTI, refraction);
-    result.setRefractionRatio(refraction);
-    // return a mesh object created from the extracted mesh data
-    return result;
-}
+    // only the first map of every type is used, textures are decoded here and uploaded when model is created
+    result.texturePaths[static_cast<int>(TextureType::Albedo)] = importTexture(material, aiTextureType_DIFFUSE, model);     // map_Kd in .mtl
+    result.texturePaths[static_cast<int>(TextureType::Metallic)] = importTexture(material, aiTextureType_SPECULAR, model);  // map_Ks in .mtl
+    result.texturePaths[static_cast<int>(TextureType::Normal)] = importTexture(material, aiTextureType_HEIGHT, model);     // map_Bump in .mtl
+    result.texturePaths[static_cast<int>(TextureType::Roughness)] = importTexture(material, aiTextureType_NORMALS, model); // map_Kn in .mtl
 
-vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, TextureType typeName)
-{
-    vector<Texture> textures;
-    for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
+    material->Get(AI_MATKEY_OPACITY, result.material.opacityRatio);
+    material->Get(AI_MATKEY_REFRACTI, result.material.refractionRatio);
+
+    if (model.options.importSteps & IMPORT_OPTIMIZE_MESHES)
     {
-        aiString str;
-        mat->GetTexture(type, i, &str);
-        // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++)
-        {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-                textures.push_back(textures_loaded[j]);
-                skip = true; // a texture with the same filepath has already been loaded, continue to next one.
-                break;
-            }
-        }
-        if (!skip)
-        {   // if texture hasn't been loaded already, load it
-            Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure that there is no duplications.
-        }
+        MeshOptimizer::Statistics statistics = MeshOptimizer::optimize(vertices, indices);
+        ostringstream log;
+        log << "MESH_OPTIMIZER:: " << model.path << " mesh " << mesh->mName.C_Str()
+            << " vertices: " << statistics.verticesBefore << " -> " << statistics.verticesAfter
+            << ", ACMR: " << statistics.acmrBefore << " -> " << statistics.acmrAfter << endl;
+        model.log += log.str();
     }
-    return textures;
+
+    // coarser levels are appended to indices
+    if (model.options.importSteps & IMPORT_GENERATE_LODS)
+    {
+        result.lods = MeshSimplifier::generateLods(vertices, indices);
+        ostringstream log;
+        log << "MESH_SIMPLIFIER:: " << model.path << " mesh " << mesh->mName.C_Str() << " triangles:";
+        for (const Geometry::Lod& lod : result.lods)
+            log << " " << lod.indexCount / 3;
+        log << endl;
+        model.log += log.str();
+    }
+    return result;
 }
 
-unsigned int TextureFromFile(const char *path, const string &directory)
+string Model::importTexture(aiMaterial* mat, aiTextureType type, ImportedModel& model)
 {
-    string filename = string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    if (mat->GetTextureCount(type) == 0)
+        return string();
+    aiString str;
+    mat->GetTexture(type, 0, &str);
+
+    // textures already in the pool or shared by meshes are decoded once
+    string fullPath = model.directory + '/' + str.C_Str();
+    if (!TexturePool::contains(fullPath) && model.images.count(fullPath) == 0)
+        model.images.emplace(fullPath, TexturePool::decode(fullPath));
+    return str.C_Str();
+}
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-        glBindTexture(GL_TEXTURE_2D, 0);//set texture to default
-    }
-    else
+Texture Model::loadTexture(const string& texturePath, TextureType typeName, const ImportedModel& model)
+{
+    // check if texture was loaded before and if so, skip loading a new texture
+    for (const Texture& texture : textures_loaded)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        if (texture.path == texturePath)
+            return texture;
     }
 
-    return textureID;
-}
\ No newline at end of file
+    Texture texture;
+    string fullPath = this->directory + '/' + texturePath;
+    auto image = model.images.find(fullPath);
+    texture.layer = TexturePool::acquire(fullPath, &texture.size, image != model.images.end() ? &image->second : nullptr);
+    texture.type = typeName;
+    texture.path = texturePath;
+    textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure that there is no duplications.
+    return texture;
+}
@@ -0,0 +1,253 @@
+#include <Objects/ObjectStore.h>
+#include <JobSystem.h>
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+using namespace std;
+
+namespace
+{
+    // Part of screen height below which level i + 1 is used instead of level i
+    const float LOD_SCREEN_SIZES[] = { 0.5f, 0.25f, 0.125f };
+
+    // Level changes only when size is this much past the threshold, so objects near it don't flicker between levels
+    const float LOD_HYSTERESIS = 0.1f;
+
+    // Transform updates are split into jobs of at least this many objects
+    const size_t TRANSFORMS_PER_JOB = 256;
+}
+
+ModelHandle ObjectStore::addModel(const shared_ptr<Model>& model)
+{
+    auto it = modelHandlesByPointer.find(model.get());
+    if (it != modelHandlesByPointer.end())
+        return it->second;
+
+    ModelHandle handle;
+    if (!freeModels.empty())
+    {
+        handle = freeModels.back();
+        freeModels.pop_back();
+        models[handle] = model;
+    }
+    else
+    {
+        handle = static_cast<ModelHandle>(models.size());
+        models.push_back(model);
+    }
+    modelHandlesByPointer.emplace(model.get(), handle);
+    return handle;
+}
+
+ModelHandle ObjectStore::findModel(const Model* model) const
+{
+    auto it = modelHandlesByPointer.find(model);
+    return it != modelHandlesByPointer.end() ? it->second : NO_MODEL;
+}
+
+size_t ObjectStore::releaseUnusedModels()
+{
+    vector<bool> used(models.size(), false);
+    for (ModelHandle handle : modelHandles)
+        used[handle] = true;
+
+    size_t released = 0;
+    for (ModelHandle handle = 0; handle < models.size(); ++handle)
+    {
+        if (used[handle] || !models[handle])
+            continue;
+        modelHandlesByPointer.erase(models[handle].get());
+        models[handle] = nullptr;
+        freeModels.push_back(handle);
+        ++released;
+    }
+    return released;
+}
+
+ObjectId ObjectStore::add(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale, ModelHandle model)
+{
+    size_t index = positions.size();
+    ObjectId id;
+    if (!freeSlots.empty())
+    {
+        id.slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else
+    {
+        id.slot = static_cast<uint32_t>(slots.size());
+        slots.push_back({ 0, 0 });
+    }
+    id.generation = slots[id.slot].generation;
+    slots[id.slot].index = static_cast<uint32_t>(index);
+
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    modelMatrices.emplace_back();
+    spheres.emplace_back();
+    modelHandles.push_back(model);
+    lods.push_back(0);
+    statics.push_back(1);
+    ids.push_back(id);
+    isOutdated.push_back(0);
+    updateTransform(index);
+    return id;
+}
+
+void ObjectStore::remove(const vector<size_t>& indices)
+{
+    if (indices.empty())
+        return;
+    // pending indices would be shifted
+    updateTransforms();
+
+    size_t removed = 0;
+    size_t kept = indices.front();
+    for (size_t i = kept; i < size(); ++i)
+    {
+        if (removed < indices.size() && indices[removed] == i)
+        {
+            // old ids of the slot never match again
+            Slot& slot = slots[ids[i].slot];
+            ++slot.generation;
+            freeSlots.push_back(ids[i].slot);
+            ++removed;
+            continue;
+        }
+
+        positions[kept] = positions[i];
+        rotations[kept] = rotations[i];
+        scales[kept] = scales[i];
+        modelMatrices[kept] = modelMatrices[i];
+        spheres[kept] = spheres[i];
+        modelHandles[kept] = modelHandles[i];
+        lods[kept] = lods[i];
+        statics[kept] = statics[i];
+        ids[kept] = ids[i];
+        slots[ids[kept].slot].index = static_cast<uint32_t>(kept);
+        ++kept;
+    }
+
+    positions.resize(kept);
+    rotations.resize(kept);
+    scales.resize(kept);
+    modelMatrices.resize(kept);
+    spheres.resize(kept);
+    modelHandles.resize(kept);
+    lods.resize(kept);
+    statics.resize(kept);
+    ids.resize(kept);
+    isOutdated.resize(kept);
+}
+
+void ObjectStore::clear()
+{
+    vector<size_t> indices(size());
+    for (size_t i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+    remove(indices);
+}
+
+void ObjectStore::reserve(size_t capacity)
+{
+    positions.reserve(capacity);
+    rotations.reserve(capacity);
+    scales.reserve(capacity);
+    modelMatrices.reserve(capacity);
+    spheres.reserve(capacity);
+    modelHandles.reserve(capacity);
+    lods.reserve(capacity);
+    statics.reserve(capacity);
+    ids.reserve(capacity);
+    isOutdated.reserve(capacity);
+}
+
+size_t ObjectStore::getIndex(ObjectId id) const
+{
+    if (id.slot >= slots.size() || slots[id.slot].generation != id.generation)
+        return NO_INDEX;
+    return slots[id.slot].index;
+}
+
+void ObjectStore::setTransform(size_t index, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale)
+{
+    positions[index] = position;
+    rotations[index] = rotation;
+    scales[index] = scale;
+    if (!isOutdated[index])
+    {
+        isOutdated[index] = 1;
+        outdated.push_back(index);
+    }
+}
+
+void ObjectStore::updateTransforms()
+{
+    // ascending order keeps writes sequential, every job gets its own range of objects
+    sort(outdated.begin(), outdated.end());
+    JobSystem::parallelFor(outdated.size(), TRANSFORMS_PER_JOB, [this](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            updateTransform(outdated[i]);
+            isOutdated[outdated[i]] = 0;
+        }
+    });
+    outdated.clear();
+}
+
+void ObjectStore::updateTransform(size_t index)
+{
+    const glm::vec3& rotation = rotations[index];
+    const glm::vec3& scale = scales[index];
+
+    glm::mat4 model{};
+    // translate
+    model = glm::translate(model, positions[index]);
+    // rotate model using quaternion
+    glm::quat quaternion(glm::vec3(glm::radians(rotation.x), glm::radians(rotation.y), glm::radians(rotation.z)));
+    model = model * toMat4(quaternion);
+    // scale
+    model = glm::scale(model, scale);
+    modelMatrices[index] = model;
+
+    const Model& object = *models[modelHandles[index]];
+    glm::vec3 center = glm::vec3(model * glm::vec4(object.getBoundsCenter(), 1.0f));
+    float maxScale = max(abs(scale.x), max(abs(scale.y), abs(scale.z)));
+    spheres[index] = glm::vec4(center, object.getBoundsRadius() * maxScale);
+}
+
+void ObjectStore::selectLod(size_t index, const glm::vec3& cameraPosition, float fieldOfView)
+{
+    unsigned int levels = min(getModel(index).getLodsNumber(), getMaxLods());
+
+    const glm::vec4& sphere = spheres[index];
+    float radius = sphere.w;
+    float distance = glm::length(glm::vec3(sphere) - cameraPosition);
+
+    // camera inside bounds sees the object at full size
+    float screenSize = distance > radius ? radius / (distance * tan(fieldOfView * 0.5f)) : 1.0f;
+
+    unsigned int& lod = lods[index];
+    lod = min(lod, levels - 1);
+    while (lod + 1 < levels && screenSize < LOD_SCREEN_SIZES[lod] * (1.0f - LOD_HYSTERESIS))
+        ++lod;
+    while (lod > 0 && screenSize > LOD_SCREEN_SIZES[lod - 1] * (1.0f + LOD_HYSTERESIS))
+        --lod;
+}
+
+unsigned int ObjectStore::getMaxLods()
+{
+    return static_cast<unsigned int>(std::size(LOD_SCREEN_SIZES) + 1);
+}
+
+float ObjectStore::getLodScreenSize(unsigned int lod)
+{
+    return lod < std::size(LOD_SCREEN_SIZES) ? LOD_SCREEN_SIZES[lod] : 0.0f;
+}
@@ -0,0 +1,161 @@
+#include <Objects/StaticBatcher.h>
+#include <Objects/GeometryCache.h>
+#include <Objects/Material.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+using namespace std;
+
+namespace
+{
+    // Vertices and indices of a batch collected before upload
+    struct Group
+    {
+        unsigned int material;
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        bool compact = true; // batch is compact only if all merged meshes were
+    };
+}
+
+StaticBatcher::StaticBatcher(float cellSize)
+    : cellSize(cellSize)
+{
+}
+
+void StaticBatcher::build(const ObjectStore& objects, const InstanceCuller& instances)
+{
+    clear();
+    batched.assign(objects.size(), false);
+
+    map<tuple<int, int, int>, size_t> cellIndices;
+    vector<vector<Group>> groups;
+    size_t drawsBefore = 0;
+    size_t batchedObjects = 0;
+
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (!objects.isStatic(i) || instances.isInstanced(i) || objects.getModel(i).getTrianglesNumber() >= MAX_OBJECT_TRIANGLES)
+            continue;
+
+        const glm::vec4& sphere = objects.getBoundingSphere(i);
+        tuple<int, int, int> key(static_cast<int>(floor(sphere.x / cellSize)),
+                                 static_cast<int>(floor(sphere.y / cellSize)),
+                                 static_cast<int>(floor(sphere.z / cellSize)));
+        auto inserted = cellIndices.emplace(key, cells.size());
+        if (inserted.second)
+        {
+            cells.emplace_back();
+            groups.emplace_back();
+            Cell& cell = cells.back();
+            cell.boundsMin = glm::vec3(sphere) - glm::vec3(sphere.w);
+            cell.boundsMax = glm::vec3(sphere) + glm::vec3(sphere.w);
+        }
+        Cell& cell = cells[inserted.first->second];
+        vector<Group>& cellGroups = groups[inserted.first->second];
+        for (int j = 0; j < 3; ++j)
+        {
+            cell.boundsMin[j] = min(cell.boundsMin[j], sphere[j] - sphere.w);
+            cell.boundsMax[j] = max(cell.boundsMax[j], sphere[j] + sphere.w);
+        }
+        cell.objects.push_back(i);
+        batched[i] = true;
+        ++batchedObjects;
+
+        const glm::mat4& model = objects.getModelMatrix(i);
+        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        for (const Mesh& mesh : objects.getModel(i).meshes)
+        {
+            ++drawsBefore;
+            const Geometry& geometry = *mesh.getGeometry();
+
+            // the latest group of the material is filled until it runs out of 16-bit indices
+            auto group = find_if(cellGroups.rbegin(), cellGroups.rend(),
+                                 [&mesh](const Group& group) { return group.material == mesh.getMaterial(); });
+            if (group == cellGroups.rend() || group->vertices.size() + geometry.vertices.size() > MAX_BATCH_VERTICES)
+            {
+                cellGroups.emplace_back();
+                cellGroups.back().material = mesh.getMaterial();
+                group = cellGroups.rbegin();
+            }
+
+            unsigned int base = static_cast<unsigned int>(group->vertices.size());
+            for (const Vertex& vertex : geometry.vertices)
+            {
+                Vertex transformed = vertex;
+                transformed.Position = glm::vec3(model * glm::vec4(vertex.Position, 1.0f));
+                transformed.Normal = glm::normalize(normalMatrix * vertex.Normal);
+                group->vertices.push_back(transformed);
+            }
+            const Geometry::Lod& finest = geometry.lods.front();
+            for (unsigned int j = 0; j < finest.indexCount; ++j)
+                group->indices.push_back(base + geometry.indices[finest.indexOffset + j]);
+            group->compact = group->compact && geometry.compact;
+        }
+    }
+
+    size_t drawsAfter = 0;
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        Cell& cell = cells[i];
+        glm::vec3 center = (cell.boundsMin + cell.boundsMax) * 0.5f;
+        cell.sphere = glm::vec4(center, glm::length(cell.boundsMax - center));
+
+        for (Group& group : groups[i])
+        {
+            if (group.indices.empty())
+                continue;
+
+            shared_ptr<const Geometry> geometry = GeometryCache::acquire(move(group.vertices), move(group.indices), {}, group.compact);
+            cell.batches.push_back({ Mesh(geometry, group.material), geometry->boundsMin, geometry->boundsMax });
+            ++drawsAfter;
+        }
+    }
+
+    cout << "STATIC_BATCHER:: objects: " << batchedObjects << ", cells: " << cells.size()
+         << ", draws: " << drawsBefore << " -> " << drawsAfter << endl;
+}
+
+void StaticBatcher::clear()
+{
+    cells.clear();
+    batched.clear();
+    drawCount = 0;
+}
+
+void StaticBatcher::submit(RenderQueue& queue, unsigned int program, unsigned int transparentProgram, const Frustum& frustum, ImpostorRenderer& impostors,
+                           const ObjectStore& objects, const glm::vec3& cameraPosition)
+{
+    drawCount = 0;
+    // batches are in world space already
+    unsigned int transform = queue.addTransform(glm::mat4(1.0f));
+
+    for (const Cell& cell : cells)
+    {
+        if (!frustum.intersects(cell.boundsMin, cell.boundsMax))
+            continue;
+
+        // the whole cell switches to impostors, so batches are never split by distance
+        if (impostors.isFar(cell.sphere, cameraPosition))
+        {
+            for (size_t object : cell.objects)
+                impostors.add(objects, object);
+            continue;
+        }
+
+        for (const Batch& batch : cell.batches)
+        {
+            if (!frustum.intersects(batch.boundsMin, batch.boundsMax))
+                continue;
+            glm::vec3 center = (batch.boundsMin + batch.boundsMax) * 0.5f;
+            if (MaterialLibrary::get(batch.mesh.getMaterial()).isTransparent())
+                queue.submit(RenderQueue::PASS_TRANSPARENT, transparentProgram, queue.getDepth(center), batch.mesh, 0, transform);
+            else
+                queue.submit(RenderQueue::PASS_OPAQUE, program, queue.getDepth(center), batch.mesh, 0, transform);
+            ++drawCount;
+        }
+    }
+}
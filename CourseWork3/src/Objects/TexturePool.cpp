@@ -0,0 +1,219 @@
+#include <Objects/TexturePool.h>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace
+{
+    const int INITIAL_CAPACITY = 4;
+
+    // Framebuffer which reads layers of old texture when array grows
+    unsigned int copyFramebuffer = 0;
+
+    // Bilinear resampling of RGBA8 pixels, texture coordinates of models stay valid for any size
+    vector<unsigned char> resize(const TextureImage& image, int width, int height)
+    {
+        vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+        for (int y = 0; y < height; ++y)
+        {
+            float sourceY = max((y + 0.5f) * image.height / height - 0.5f, 0.0f);
+            int y0 = min(static_cast<int>(sourceY), image.height - 1);
+            int y1 = min(y0 + 1, image.height - 1);
+            float fy = sourceY - y0;
+            for (int x = 0; x < width; ++x)
+            {
+                float sourceX = max((x + 0.5f) * image.width / width - 0.5f, 0.0f);
+                int x0 = min(static_cast<int>(sourceX), image.width - 1);
+                int x1 = min(x0 + 1, image.width - 1);
+                float fx = sourceX - x0;
+                for (int channel = 0; channel < 4; ++channel)
+                {
+                    auto texel = [&image, channel](int column, int row)
+                    {
+                        return static_cast<float>(image.pixels[(static_cast<size_t>(row) * image.width + column) * 4 + channel]);
+                    };
+                    float top = texel(x0, y0) + (texel(x1, y0) - texel(x0, y0)) * fx;
+                    float bottom = texel(x0, y1) + (texel(x1, y1) - texel(x0, y1)) * fx;
+                    pixels[(static_cast<size_t>(y) * width + x) * 4 + channel] =
+                        static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+                }
+            }
+        }
+        return pixels;
+    }
+
+    // How much texture is distorted by resizing it, 0 for the same size
+    float getResizeCost(int width, int height, int arrayWidth, int arrayHeight)
+    {
+        return abs(log2(static_cast<float>(arrayWidth) / width)) + abs(log2(static_cast<float>(arrayHeight) / height));
+    }
+}
+
+vector<TexturePool::Array> TexturePool::arrays;
+unordered_map<string, TextureLayer> TexturePool::textures;
+mutex TexturePool::texturesMutex;
+
+TextureLayer TexturePool::acquire(const string& path, size_t* size, const TextureImage* image)
+{
+    // only this thread inserts textures, so it reads the map without locking
+    auto found = textures.find(path);
+    if (found != textures.end())
+    {
+        if (size && found->second.array >= 0)
+        {
+            const Array& array = arrays[found->second.array];
+            *size = static_cast<size_t>(array.width) * array.height * 4 * 4 / 3;
+        }
+        return found->second;
+    }
+
+    TextureLayer result;
+    TextureImage decoded;
+    if (!image)
+    {
+        decoded = decode(path);
+        image = &decoded;
+    }
+    int width = image->width;
+    int height = image->height;
+    if (image->pixels.empty())
+    {
+        cout << "Texture failed to load at path: " << path << endl;
+        insert(path, result);
+        return result;
+    }
+
+    auto array = find_if(arrays.begin(), arrays.end(),
+                         [width, height](const Array& array) { return array.width == width && array.height == height; });
+    vector<unsigned char> resized;
+    const unsigned char* pixels = image->pixels.data();
+    if (array == arrays.end() && arrays.size() == MAX_ARRAYS)
+    {
+        // shaders have no room for another array, so texture is resized to the nearest size already used
+        array = min_element(arrays.begin(), arrays.end(), [width, height](const Array& a, const Array& b)
+        {
+            return getResizeCost(width, height, a.width, a.height) < getResizeCost(width, height, b.width, b.height);
+        });
+        cout << "TEXTURE_POOL:: " << path << " resized from " << width << "x" << height
+             << " to " << array->width << "x" << array->height << endl;
+        width = array->width;
+        height = array->height;
+        resized = resize(*image, width, height);
+        pixels = resized.data();
+    }
+    else if (array == arrays.end())
+    {
+        arrays.emplace_back();
+        array = arrays.end() - 1;
+        array->width = width;
+        array->height = height;
+    }
+    if (array->layers == array->capacity)
+        grow(*array, max(INITIAL_CAPACITY, array->capacity * 2));
+
+    result.array = static_cast<int>(array - arrays.begin());
+    result.layer = array->layers++;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array->texture);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, result.layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    array->dirty = true;
+
+    if (size)
+        *size = static_cast<size_t>(width) * height * 4 * 4 / 3; // full mipmap chain takes 1/3 more
+    insert(path, result);
+    return result;
+}
+
+bool TexturePool::contains(const string& path)
+{
+    lock_guard<mutex> lock(texturesMutex);
+    return textures.count(path) != 0;
+}
+
+void TexturePool::insert(const string& path, const TextureLayer& layer)
+{
+    lock_guard<mutex> lock(texturesMutex);
+    textures[path] = layer;
+}
+
+TextureImage TexturePool::decode(const string& path)
+{
+    TextureImage image;
+    int nrComponents;
+    // every texture is expanded to four channels, so textures of any format share arrays
+    unsigned char* data = stbi_load(path.c_str(), &image.width, &image.height, &nrComponents, 4);
+    if (!data)
+        return image;
+    image.pixels.assign(data, data + static_cast<size_t>(image.width) * image.height * 4);
+    stbi_image_free(data);
+    return image;
+}
+
+void TexturePool::bind()
+{
+    for (size_t i = 0; i < arrays.size(); ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[i].texture);
+        // mipmaps are generated once for all layers added since previous frame
+        if (arrays[i].dirty)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            arrays[i].dirty = false;
+        }
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void TexturePool::setupShader(const Shader& shader)
+{
+    shader.use();
+    for (int i = 0; i < MAX_ARRAYS; ++i)
+        shader.setInt("textureArrays[" + to_string(i) + "]", i);
+}
+
+void TexturePool::printStatistics(ostream& out)
+{
+    for (const Array& array : arrays)
+    {
+        out << "TEXTURE_POOL:: " << array.width << "x" << array.height
+            << " layers: " << array.layers << "/" << array.capacity
+            << ", memory: " << static_cast<size_t>(array.width) * array.height * 4 * array.capacity * 4 / 3 / 1024 << " KB" << endl;
+    }
+}
+
+void TexturePool::grow(Array& array, int capacity)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, array.width, array.height, capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // GL 3.3 can't copy between textures directly, so old layers are read through framebuffer
+    if (array.texture != 0)
+    {
+        if (copyFramebuffer == 0)
+            glGenFramebuffers(1, &copyFramebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, copyFramebuffer);
+        for (int layer = 0; layer < array.layers; ++layer)
+        {
+            glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, array.texture, 0, layer);
+            glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, 0, 0, array.width, array.height);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glDeleteTextures(1, &array.texture);
+        array.dirty = true;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    array.texture = texture;
+    array.capacity = capacity;
+}
@@ -0,0 +1,371 @@
+#include <OcclusionCuller.h>
+#include <Primitives.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+    // The last reduced level is read back, it is the first one not wider than that
+    const int MAX_READBACK_WIDTH = 160;
+
+    // Depth older than that many frames is too far from the current view to be reprojected
+    const unsigned long long MAX_LATENCY = 4;
+
+    // Points this close to camera plane or behind it can't be projected
+    const float MIN_CLIP_W = 1e-4f;
+
+    // Reprojected texels are marked with it until some depth lands there
+    const float NO_DEPTH = -1.0f;
+
+    // Largest size in texels of reprojected texel which is still filled
+    const int MAX_FOOTPRINT = 8;
+}
+
+void OcclusionCuller::resize(int width, int height)
+{
+    if (width == this->width && height == this->height)
+        return;
+
+    release();
+    this->width = width;
+    this->height = height;
+    if (width > 0 && height > 0)
+        create();
+}
+
+void OcclusionCuller::create()
+{
+    // copy of default framebuffer depth, its format must match for the blit
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glGenFramebuffers(1, &depthFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    // levels are halved until the one small enough for read back
+    glm::ivec2 size(max(width / 2, 1), max(height / 2, 1));
+    levelSizes.push_back(size);
+    while (size.x > MAX_READBACK_WIDTH && (size.x > 1 || size.y > 1))
+    {
+        size = glm::ivec2(max(size.x / 2, 1), max(size.y / 2, 1));
+        levelSizes.push_back(size);
+    }
+
+    glGenTextures(1, &pyramidTexture);
+    glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+    for (size_t i = 0; i < levelSizes.size(); ++i)
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), GL_R32F, levelSizes[i].x, levelSizes[i].y, 0, GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levelSizes.size() - 1));
+
+    levelFramebuffers.resize(levelSizes.size());
+    glGenFramebuffers(static_cast<GLsizei>(levelFramebuffers.size()), levelFramebuffers.data());
+    for (size_t i = 0; i < levelFramebuffers.size(); ++i)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, levelFramebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pyramidTexture, static_cast<GLint>(i));
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            cout << "ERROR::OCCLUSION_CULLER::FRAMEBUFFER_INCOMPLETE level: " << i << endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    const glm::ivec2& readbackSize = levelSizes.back();
+    for (Readback& readback : readbacks)
+    {
+        glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, readbackSize.x * readbackSize.y * sizeof(float), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void OcclusionCuller::release()
+{
+    for (Readback& readback : readbacks)
+    {
+        if (readback.fence)
+            glDeleteSync(readback.fence);
+        if (readback.buffer)
+            glDeleteBuffers(1, &readback.buffer);
+        readback = Readback();
+    }
+    if (!levelFramebuffers.empty())
+        glDeleteFramebuffers(static_cast<GLsizei>(levelFramebuffers.size()), levelFramebuffers.data());
+    if (pyramidTexture)
+        glDeleteTextures(1, &pyramidTexture);
+    if (depthFramebuffer)
+        glDeleteFramebuffers(1, &depthFramebuffer);
+    if (depthTexture)
+        glDeleteTextures(1, &depthTexture);
+
+    levelFramebuffers.clear();
+    levelSizes.clear();
+    pyramidTexture = 0;
+    depthFramebuffer = 0;
+    depthTexture = 0;
+    width = 0;
+    height = 0;
+    invalidate();
+}
+
+void OcclusionCuller::invalidate()
+{
+    hasCapture = false;
+    levels.clear();
+}
+
+void OcclusionCuller::prepare(const glm::mat4& viewProjection)
+{
+    ++frame;
+    tested = 0;
+    culled = 0;
+    this->viewProjection = viewProjection;
+
+    // finished read backs are collected without waiting, the newest one is kept
+    for (Readback& readback : readbacks)
+    {
+        if (!readback.fence)
+            continue;
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            continue;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        if (hasCapture && readback.frame <= capturedFrame)
+            continue;
+
+        const glm::ivec2& size = levelSizes.back();
+        capturedDepths.resize(size.x * size.y);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, capturedDepths.size() * sizeof(float), GL_MAP_READ_BIT);
+        if (data)
+        {
+            memcpy(capturedDepths.data(), data, capturedDepths.size() * sizeof(float));
+            capturedViewProjection = readback.viewProjection;
+            capturedFrame = readback.frame;
+            hasCapture = true;
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    levels.clear();
+    if (!enabled || !hasCapture || frame - capturedFrame > MAX_LATENCY)
+        return;
+    reproject(viewProjection);
+}
+
+void OcclusionCuller::reproject(const glm::mat4& viewProjection)
+{
+    const glm::ivec2& size = levelSizes.back();
+    Level base = { size.x, size.y, vector<float>(size.x * size.y, NO_DEPTH) };
+
+    // captured texels go from old clip space through world space to the current one
+    glm::mat4 toCurrent = viewProjection * glm::inverse(capturedViewProjection);
+    for (int y = 0; y < size.y; ++y)
+    {
+        for (int x = 0; x < size.x; ++x)
+        {
+            float depth = capturedDepths[y * size.x + x];
+            // background doesn't hide anything
+            if (depth >= 1.0f)
+                continue;
+
+            // texel is reprojected as a flat square, so magnified depth doesn't break into separate points
+            glm::vec2 footprintMin(numeric_limits<float>::max());
+            glm::vec2 footprintMax(-numeric_limits<float>::max());
+            float reprojectedDepth = 0.0f;
+            bool behindCamera = false;
+            for (int corner = 0; corner < 4 && !behindCamera; ++corner)
+            {
+                glm::vec4 ndc(static_cast<float>(x + (corner & 1)) / size.x * 2.0f - 1.0f,
+                              static_cast<float>(y + (corner >> 1)) / size.y * 2.0f - 1.0f,
+                              depth * 2.0f - 1.0f, 1.0f);
+                glm::vec4 clip = toCurrent * ndc;
+                behindCamera = clip.w < MIN_CLIP_W;
+                glm::vec3 point = glm::vec3(clip) / clip.w;
+                glm::vec2 texel((point.x * 0.5f + 0.5f) * size.x, (point.y * 0.5f + 0.5f) * size.y);
+                footprintMin = glm::min(footprintMin, texel);
+                footprintMax = glm::max(footprintMax, texel);
+                reprojectedDepth = max(reprojectedDepth, min(max(point.z * 0.5f + 0.5f, 0.0f), 1.0f));
+            }
+            if (behindCamera)
+                continue;
+
+            // texels whose centers are covered, at least one when the square shrank
+            int x0 = static_cast<int>(ceil(footprintMin.x - 0.5f));
+            int y0 = static_cast<int>(ceil(footprintMin.y - 0.5f));
+            int x1 = max(static_cast<int>(ceil(footprintMax.x - 0.5f)) - 1, x0);
+            int y1 = max(static_cast<int>(ceil(footprintMax.y - 0.5f)) - 1, y0);
+            // huge footprints come from surfaces seen at grazing angles, they are left as holes
+            if (x1 - x0 >= MAX_FOOTPRINT || y1 - y0 >= MAX_FOOTPRINT)
+                continue;
+
+            for (int targetY = max(y0, 0); targetY <= min(y1, size.y - 1); ++targetY)
+            {
+                for (int targetX = max(x0, 0); targetX <= min(x1, size.x - 1); ++targetX)
+                {
+                    // several texels may land on one, the farthest of them is kept
+                    float& target = base.depths[targetY * size.x + targetX];
+                    target = max(target, reprojectedDepth);
+                }
+            }
+        }
+    }
+    // holes are disoccluded areas, anything may be visible there
+    for (float& depth : base.depths)
+    {
+        if (depth == NO_DEPTH)
+            depth = 1.0f;
+    }
+    levels.push_back(move(base));
+
+    // farther levels are reduced the same way as on GPU
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        const Level& source = levels.back();
+        Level level = { max(source.width / 2, 1), max(source.height / 2, 1), {} };
+        level.depths.resize(level.width * level.height);
+        for (int y = 0; y < level.height; ++y)
+        {
+            int lastY = y == level.height - 1 ? source.height - 1 : min(2 * y + 1, source.height - 1);
+            for (int x = 0; x < level.width; ++x)
+            {
+                int lastX = x == level.width - 1 ? source.width - 1 : min(2 * x + 1, source.width - 1);
+                float depth = 0.0f;
+                for (int sourceY = 2 * y; sourceY <= lastY; ++sourceY)
+                {
+                    for (int sourceX = 2 * x; sourceX <= lastX; ++sourceX)
+                        depth = max(depth, source.depths[sourceY * source.width + sourceX]);
+                }
+                level.depths[y * level.width + x] = depth;
+            }
+        }
+        levels.push_back(move(level));
+    }
+}
+
+bool OcclusionCuller::isOccluded(const glm::vec4& sphere)
+{
+    if (levels.empty())
+        return false;
+    ++tested;
+
+    // screen rectangle and the nearest depth of the box around the sphere
+    glm::vec2 screenMin(numeric_limits<float>::max());
+    glm::vec2 screenMax(-numeric_limits<float>::max());
+    float nearestDepth = 1.0f;
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec3 corner = glm::vec3(sphere) + glm::vec3(i & 1 ? sphere.w : -sphere.w,
+                                                         i & 2 ? sphere.w : -sphere.w,
+                                                         i & 4 ? sphere.w : -sphere.w);
+        glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+        // object crosses near plane
+        if (clip.w < MIN_CLIP_W)
+            return false;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        screenMin = glm::min(screenMin, glm::vec2(ndc.x, ndc.y));
+        screenMax = glm::max(screenMax, glm::vec2(ndc.x, ndc.y));
+        nearestDepth = min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    const Level& base = levels.front();
+    auto toTexel = [](float ndc, int size) { return min(max(static_cast<int>(floor((ndc * 0.5f + 0.5f) * size)), 0), size - 1); };
+    int x0 = toTexel(screenMin.x, base.width);
+    int y0 = toTexel(screenMin.y, base.height);
+    int x1 = toTexel(screenMax.x, base.width);
+    int y1 = toTexel(screenMax.y, base.height);
+
+    // level where rectangle covers at most 2x2 texels
+    size_t levelIndex = 0;
+    while (levelIndex + 1 < levels.size() && ((x1 >> levelIndex) - (x0 >> levelIndex) > 1 || (y1 >> levelIndex) - (y0 >> levelIndex) > 1))
+        ++levelIndex;
+    const Level& level = levels[levelIndex];
+    // the last texel of a level also covers the remainder of odd sizes
+    int levelX0 = min(x0 >> levelIndex, level.width - 1);
+    int levelY0 = min(y0 >> levelIndex, level.height - 1);
+    int levelX1 = min(x1 >> levelIndex, level.width - 1);
+    int levelY1 = min(y1 >> levelIndex, level.height - 1);
+
+    float farthestDepth = 0.0f;
+    for (int y = levelY0; y <= levelY1; ++y)
+    {
+        for (int x = levelX0; x <= levelX1; ++x)
+            farthestDepth = max(farthestDepth, level.depths[y * level.width + x]);
+    }
+
+    bool occluded = nearestDepth > farthestDepth;
+    if (occluded)
+        ++culled;
+    return occluded;
+}
+
+void OcclusionCuller::capture(const Shader& reduceShader, const glm::mat4& viewProjection)
+{
+    if (!enabled || levelSizes.empty())
+        return;
+    // all buffers are still in flight, GPU is too far behind
+    Readback& readback = readbacks[nextReadback];
+    if (readback.fence)
+        return;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFramebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    glDisable(GL_DEPTH_TEST);
+    reduceShader.use();
+    reduceShader.setInt("source", 0);
+    glActiveTexture(GL_TEXTURE0);
+    for (size_t i = 0; i < levelSizes.size(); ++i)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, levelFramebuffers[i]);
+        glViewport(0, 0, levelSizes[i].x, levelSizes[i].y);
+        if (i == 0)
+            glBindTexture(GL_TEXTURE_2D, depthTexture);
+        else
+        {
+            // only the previous level is read, so it doesn't overlap the one being written
+            glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(i - 1));
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(i - 1));
+        }
+        Primitives::draw(Primitives::QUAD);
+    }
+
+    // read back is queued now and waited for in one of the next frames
+    const glm::ivec2& readbackSize = levelSizes.back();
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, levelFramebuffers.back());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glReadPixels(0, 0, readbackSize.x, readbackSize.y, GL_RED, GL_FLOAT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.viewProjection = viewProjection;
+    readback.frame = frame;
+    nextReadback = (nextReadback + 1) % READBACKS_NUMBER;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void OcclusionCuller::printStatistics(ostream& out) const
+{
+    out << "OCCLUSION_CULLER:: " << (enabled ? "enabled" : "disabled")
+        << ", tested: " << tested << ", culled: " << culled << endl;
+}
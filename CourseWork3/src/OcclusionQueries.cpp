@@ -0,0 +1,269 @@
+#include <OcclusionQueries.h>
+#include <Primitives.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace
+{
+    // Objects with fewer triangles are cheaper to draw than to query, heavier ones are never batched
+    const size_t MIN_TRIANGLES = StaticBatcher::MAX_OBJECT_TRIANGLES;
+
+    const size_t MAX_GROUP_OBJECTS = 8;
+
+    // Boxes closer than this to camera may be clipped by near plane, so objects inside them are always drawn
+    const float CAMERA_MARGIN = 0.5f;
+
+    const unsigned int NO_ENTRY = ~0u;
+
+    bool contains(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& point)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (point[i] < boxMin[i] - CAMERA_MARGIN || point[i] > boxMax[i] + CAMERA_MARGIN)
+                return false;
+        }
+        return true;
+    }
+
+    // Returns false if result of the query isn't available yet
+    bool getResult(GLuint query, bool& visible)
+    {
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE)
+            return false;
+        GLuint passed = 0;
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, &passed);
+        visible = passed != 0;
+        return true;
+    }
+}
+
+void OcclusionQueries::build(const ObjectStore& objects, const StaticBatcher& batcher, const InstanceCuller& instances)
+{
+    release();
+    entryIndices.assign(objects.size(), NO_ENTRY);
+
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        if (batcher.isBatched(i) || instances.isInstanced(i) || objects.getModel(i).getTrianglesNumber() < MIN_TRIANGLES)
+            continue;
+        entries.push_back(Entry());
+        entries.back().object = i;
+    }
+    if (entries.empty())
+        return;
+
+    buildGroups(objects, 0, entries.size());
+
+    vector<GLuint> queries(entries.size() + groups.size());
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    for (size_t i = 0; i < groups.size(); ++i)
+    {
+        Group& group = groups[i];
+        group.query = queries[i];
+        for (size_t j = group.first; j < group.first + group.count; ++j)
+        {
+            entries[j].group = i;
+            entries[j].query = queries[groups.size() + j];
+            entryIndices[entries[j].object] = static_cast<unsigned int>(j);
+        }
+    }
+
+    cout << "OCCLUSION_QUERIES:: objects: " << entries.size() << ", groups: " << groups.size() << endl;
+}
+
+void OcclusionQueries::buildGroups(const ObjectStore& objects, size_t first, size_t count)
+{
+    if (count <= MAX_GROUP_OBJECTS)
+    {
+        Group group;
+        group.first = first;
+        group.count = count;
+        groups.push_back(group);
+        return;
+    }
+
+    glm::vec3 centersMin(numeric_limits<float>::max());
+    glm::vec3 centersMax(-numeric_limits<float>::max());
+    for (size_t i = first; i < first + count; ++i)
+    {
+        glm::vec3 center = glm::vec3(objects.getBoundingSphere(entries[i].object));
+        centersMin = glm::min(centersMin, center);
+        centersMax = glm::max(centersMax, center);
+    }
+    glm::vec3 extent = centersMax - centersMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    size_t half = count / 2;
+    nth_element(entries.begin() + first, entries.begin() + first + half, entries.begin() + first + count,
+                [&objects, axis](const Entry& a, const Entry& b)
+                {
+                    return objects.getBoundingSphere(a.object)[axis] < objects.getBoundingSphere(b.object)[axis];
+                });
+    buildGroups(objects, first, half);
+    buildGroups(objects, first + half, count - half);
+}
+
+void OcclusionQueries::release()
+{
+    for (const Entry& entry : entries)
+        glDeleteQueries(1, &entry.query);
+    for (const Group& group : groups)
+        glDeleteQueries(1, &group.query);
+    entries.clear();
+    groups.clear();
+    entryIndices.clear();
+    statistics = Statistics();
+}
+
+void OcclusionQueries::update()
+{
+    statistics.hidden = 0;
+    if (!enabled)
+        return;
+
+    bool visible = false;
+    for (Group& group : groups)
+    {
+        if (group.refined)
+        {
+            // group is queried as a whole again only when all objects are hidden
+            group.refine = false;
+            for (size_t i = group.first; i < group.first + group.count; ++i)
+            {
+                const Entry& entry = entries[i];
+                if (!entry.queried)
+                    continue;
+                if (getResult(entry.query, visible) && !visible)
+                    ++statistics.hidden;
+                else
+                    group.refine = true;
+            }
+        }
+        else if (group.queried && getResult(group.query, visible))
+        {
+            group.refine = visible;
+            if (!visible)
+                statistics.hidden += group.count;
+        }
+        else
+            group.refine = false;
+    }
+}
+
+GLuint OcclusionQueries::getCondition(size_t objectIndex) const
+{
+    if (!enabled || objectIndex >= entryIndices.size() || entryIndices[objectIndex] == NO_ENTRY)
+        return 0;
+
+    const Entry& entry = entries[entryIndices[objectIndex]];
+    const Group& group = groups[entry.group];
+    if (group.refined)
+        return entry.queried ? entry.query : 0;
+    return group.queried ? group.query : 0;
+}
+
+void OcclusionQueries::issue(const Shader& shader, const ObjectStore& objects, const Frustum& frustum, const glm::vec3& cameraPosition)
+{
+    statistics.queries = 0;
+    if (!enabled || groups.empty())
+        return;
+
+    // boxes only count samples passing depth test, back faces are needed when camera is close to them
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+
+    vector<glm::vec3> boxes(MAX_GROUP_OBJECTS * 2);
+    for (Group& group : groups)
+    {
+        glm::vec3 groupMin(numeric_limits<float>::max());
+        glm::vec3 groupMax(-numeric_limits<float>::max());
+        for (size_t i = 0; i < group.count; ++i)
+        {
+            const glm::vec4& sphere = objects.getBoundingSphere(entries[group.first + i].object);
+            boxes[2 * i] = glm::vec3(sphere) - glm::vec3(sphere.w);
+            boxes[2 * i + 1] = glm::vec3(sphere) + glm::vec3(sphere.w);
+            groupMin = glm::min(groupMin, boxes[2 * i]);
+            groupMax = glm::max(groupMax, boxes[2 * i + 1]);
+            entries[group.first + i].queried = false;
+        }
+
+        group.queried = false;
+        group.refined = group.refine;
+        if (!frustum.intersects(groupMin, groupMax))
+            continue;
+
+        // box around camera can't hide anything
+        if (contains(groupMin, groupMax, cameraPosition))
+            group.refined = true;
+
+        if (!group.refined)
+        {
+            drawBox(shader, group.query, groupMin, groupMax);
+            group.queried = true;
+            continue;
+        }
+
+        for (size_t i = 0; i < group.count; ++i)
+        {
+            const glm::vec3& boxMin = boxes[2 * i];
+            const glm::vec3& boxMax = boxes[2 * i + 1];
+            if (!frustum.intersects(boxMin, boxMax) || contains(boxMin, boxMax, cameraPosition))
+                continue;
+            Entry& entry = entries[group.first + i];
+            drawBox(shader, entry.query, boxMin, boxMax);
+            entry.queried = true;
+        }
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_CULL_FACE);
+}
+
+void OcclusionQueries::drawBox(const Shader& shader, GLuint query, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    // unit cube spans [-1, 1]
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), (boxMin + boxMax) * 0.5f);
+    model = glm::scale(model, (boxMax - boxMin) * 0.5f);
+    shader.setMat4("model", model);
+
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+    Primitives::draw(Primitives::CUBE);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    ++statistics.queries;
+}
+
+void OcclusionQueries::invalidate()
+{
+    for (Entry& entry : entries)
+        entry.queried = false;
+    for (Group& group : groups)
+    {
+        group.queried = false;
+        group.refined = false;
+        group.refine = false;
+    }
+}
+
+void OcclusionQueries::setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+    invalidate();
+}
+
+void OcclusionQueries::printStatistics(ostream& out) const
+{
+    out << "OCCLUSION_QUERIES:: enabled: " << enabled
+        << ", objects: " << entries.size()
+        << ", groups: " << groups.size()
+        << ", queries: " << statistics.queries
+        << ", hidden: " << statistics.hidden << endl;
+}
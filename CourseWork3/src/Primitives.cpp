@@ -0,0 +1,209 @@
+#include <Primitives.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    // position and texture coordinates
+    const GLsizei VERTEX_SIZE = 5;
+
+    const float CUBE_POSITIONS[] = {
+        // back face
+        -1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        // front face
+        -1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+        // left face
+        -1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        // right face
+         1.0f,  1.0f,  1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+        // bottom face
+        -1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f, -1.0f,
+        // top face
+        -1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+    };
+
+    const float PYRAMID_POSITIONS[] = {
+        // front face
+         0.5f, -0.5f,  0.5f,
+         0.0f,  0.5f,  0.0f,
+        -0.5f, -0.5f,  0.5f,
+        // right face
+         0.5f, -0.5f, -0.5f,
+         0.0f,  0.5f,  0.0f,
+         0.5f, -0.5f,  0.5f,
+        // left face
+        -0.5f, -0.5f,  0.5f,
+         0.0f,  0.5f,  0.0f,
+        -0.5f, -0.5f, -0.5f,
+        // back face
+        -0.5f, -0.5f, -0.5f,
+         0.0f,  0.5f,  0.0f,
+         0.5f, -0.5f, -0.5f,
+        // bottom face
+         0.5f, -0.5f, -0.5f,
+         0.5f, -0.5f,  0.5f,
+        -0.5f, -0.5f,  0.5f,
+
+         0.5f, -0.5f, -0.5f,
+        -0.5f, -0.5f,  0.5f,
+        -0.5f, -0.5f, -0.5f,
+    };
+
+    // positions and texture coordinates
+    const float QUAD_VERTICES[] = {
+        -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
+        -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
+         1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
+         1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
+    };
+
+    const float SKYBOX_POSITIONS[] = {
+        -1.0f,  1.0f, -1.0f,
+        -1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f, -1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+
+        -1.0f, -1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f,
+        -1.0f, -1.0f,  1.0f,
+
+        -1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f, -1.0f,
+         1.0f,  1.0f,  1.0f,
+         1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f,  1.0f,
+        -1.0f,  1.0f, -1.0f,
+
+        -1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f, -1.0f,
+         1.0f, -1.0f, -1.0f,
+        -1.0f, -1.0f,  1.0f,
+         1.0f, -1.0f,  1.0f
+    };
+
+    // Appends shape given by positions only, texture coordinates are zero
+    Primitives::Range appendPositions(vector<float>& vertices, const float* positions, size_t size, GLenum mode)
+    {
+        Primitives::Range range = { mode, static_cast<GLint>(vertices.size() / VERTEX_SIZE), static_cast<GLsizei>(size / 3) };
+        for (size_t i = 0; i < size; i += 3)
+            vertices.insert(vertices.end(), { positions[i], positions[i + 1], positions[i + 2], 0.0f, 0.0f });
+        return range;
+    }
+}
+
+GLuint Primitives::vertexArray = 0;
+GLuint Primitives::vertexBuffer = 0;
+Primitives::Range Primitives::ranges[SHAPES_NUMBER] = {};
+
+void Primitives::initialize()
+{
+    if (vertexArray != 0)
+        return;
+
+    vector<float> vertices;
+    ranges[CUBE] = appendPositions(vertices, CUBE_POSITIONS, size(CUBE_POSITIONS), GL_TRIANGLES);
+    ranges[PYRAMID] = appendPositions(vertices, PYRAMID_POSITIONS, size(PYRAMID_POSITIONS), GL_TRIANGLES);
+    ranges[QUAD] = { GL_TRIANGLE_STRIP, static_cast<GLint>(vertices.size() / VERTEX_SIZE), static_cast<GLsizei>(size(QUAD_VERTICES) / VERTEX_SIZE) };
+    vertices.insert(vertices.end(), begin(QUAD_VERTICES), end(QUAD_VERTICES));
+    ranges[SKYBOX] = appendPositions(vertices, SKYBOX_POSITIONS, size(SKYBOX_POSITIONS), GL_TRIANGLES);
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    setupVertexAttributes();
+    glBindVertexArray(0);
+}
+
+void Primitives::release()
+{
+    glDeleteVertexArrays(1, &vertexArray);
+    glDeleteBuffers(1, &vertexBuffer);
+    vertexArray = 0;
+    vertexBuffer = 0;
+}
+
+void Primitives::draw(Shape shape)
+{
+    if (vertexArray == 0)
+    {
+        cout << "ERROR::PRIMITIVES::NOT_INITIALIZED" << endl;
+        return;
+    }
+    const Range& range = ranges[shape];
+    glBindVertexArray(vertexArray);
+    glDrawArrays(range.mode, range.first, range.count);
+    glBindVertexArray(0);
+}
+
+void Primitives::drawInstanced(Shape shape, GLsizei instanceCount)
+{
+    const Range& range = ranges[shape];
+    glDrawArraysInstanced(range.mode, range.first, range.count, instanceCount);
+}
+
+void Primitives::setupVertexAttributes()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_SIZE * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, VERTEX_SIZE * sizeof(float), (void*)(3 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,205 @@
+#include <RenderQueue.h>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace
+{
+    const unsigned int COMMAND_BITS = 24;
+    const unsigned int DEPTH_BITS = 24;
+    const unsigned int MATERIAL_BITS = 8;
+    const unsigned int PROGRAM_BITS = 6;
+
+    const uint64_t COMMAND_MASK = (uint64_t(1) << COMMAND_BITS) - 1;
+    const uint64_t DEPTH_MAX = (uint64_t(1) << DEPTH_BITS) - 1;
+    const uint64_t MATERIAL_MASK = (uint64_t(1) << MATERIAL_BITS) - 1;
+    const uint64_t PROGRAM_MASK = (uint64_t(1) << PROGRAM_BITS) - 1;
+
+    const unsigned int NO_VALUE = ~0u;
+}
+
+unsigned int RenderQueue::addProgram(const Shader& shader)
+{
+    programs.push_back(&shader);
+    return static_cast<unsigned int>(programs.size() - 1);
+}
+
+void RenderQueue::setCamera(const glm::vec3& position, float farPlane)
+{
+    cameraPosition = position;
+    this->farPlane = farPlane;
+}
+
+float RenderQueue::getDepth(const glm::vec3& point, const glm::vec3& cameraPosition, float farPlane)
+{
+    return glm::length(point - cameraPosition) / farPlane;
+}
+
+unsigned int RenderQueue::addTransform(const glm::mat4& model)
+{
+    transforms.push_back(model);
+    return static_cast<unsigned int>(transforms.size() - 1);
+}
+
+void RenderQueue::submit(Pass pass, unsigned int program, float depth, const Mesh& mesh, unsigned int lod, unsigned int transform,
+                         GLuint condition)
+{
+    keys.push_back(makeKey(pass, program, mesh.getMaterial(), depth, commands.size()));
+    commands.push_back({ program, &mesh, lod, transform, condition, nullptr });
+}
+
+void RenderQueue::submit(Pass pass, unsigned int program, float depth, DrawFunction draw)
+{
+    keys.push_back(makeKey(pass, program, 0, depth, commands.size()));
+    commands.push_back({ program, nullptr, 0, NO_VALUE, 0, move(draw) });
+}
+
+void RenderQueue::setPassHooks(Pass pass, PassHook begin, PassHook end)
+{
+    passHooks[pass] = { move(begin), move(end) };
+}
+
+void RenderQueue::execute()
+{
+    sortKeys();
+
+    statistics = Statistics();
+    unsigned int currentPass = NO_VALUE;
+    unsigned int currentProgram = NO_VALUE;
+    unsigned int currentMaterial = NO_VALUE;
+    unsigned int currentTransform = NO_VALUE;
+    for (uint64_t key : keys)
+    {
+        const Command& command = commands[key & COMMAND_MASK];
+        const Shader& shader = *programs[command.program];
+        unsigned int pass = static_cast<unsigned int>(key >> 62);
+        if (pass != currentPass)
+        {
+            if (currentProgram != NO_VALUE)
+                flush(*programs[currentProgram]);
+            setCondition(0);
+            if (currentPass != NO_VALUE && passHooks[currentPass].end)
+                passHooks[currentPass].end();
+            if (passHooks[pass].begin)
+                passHooks[pass].begin();
+            // hooks may change any state
+            currentPass = pass;
+            currentProgram = NO_VALUE;
+        }
+        if (command.program != currentProgram)
+        {
+            if (currentProgram != NO_VALUE)
+                flush(*programs[currentProgram]);
+            shader.use();
+            currentProgram = command.program;
+            currentMaterial = NO_VALUE;
+            currentTransform = NO_VALUE;
+            ++statistics.programChanges;
+        }
+        ++statistics.draws;
+
+        if (!command.mesh)
+        {
+            flush(shader);
+            setCondition(0);
+            command.draw(shader);
+            // custom draws may change any uniform
+            currentMaterial = NO_VALUE;
+            currentTransform = NO_VALUE;
+            continue;
+        }
+
+        // meshes of one object with the same material are merged into one multi-draw
+        const Geometry& geometry = *command.mesh->getGeometry();
+        if (command.transform != currentTransform || command.condition != currentCondition
+            || !batch.accepts(geometry, command.mesh->getMaterial()))
+            flush(shader);
+        if (command.condition != currentCondition)
+            setCondition(command.condition);
+        if (command.transform != currentTransform)
+        {
+            const glm::mat4& model = transforms[command.transform];
+            shader.setMat4("model", model);
+            // Fixes normals in case of non-uniform model scaling
+            shader.setMat3("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
+            currentTransform = command.transform;
+            ++statistics.transformChanges;
+        }
+        if (command.mesh->getMaterial() != currentMaterial)
+        {
+            currentMaterial = command.mesh->getMaterial();
+            ++statistics.materialChanges;
+        }
+        batch.add(geometry, command.lod, command.mesh->getMaterial());
+    }
+    if (currentProgram != NO_VALUE)
+        flush(*programs[currentProgram]);
+    setCondition(0);
+    if (currentPass != NO_VALUE && passHooks[currentPass].end)
+        passHooks[currentPass].end();
+
+    keys.clear();
+    commands.clear();
+    transforms.clear();
+}
+
+void RenderQueue::printStatistics(ostream& out) const
+{
+    out << "RENDER_QUEUE:: draws: " << statistics.draws
+        << ", program changes: " << statistics.programChanges
+        << ", material changes: " << statistics.materialChanges
+        << ", transform changes: " << statistics.transformChanges << endl;
+}
+
+uint64_t RenderQueue::makeKey(Pass pass, unsigned int program, unsigned int material, float depth, size_t command)
+{
+    uint64_t quantizedDepth = static_cast<uint64_t>(min(max(depth, 0.0f), 1.0f) * DEPTH_MAX);
+    uint64_t key = uint64_t(pass) << 62;
+    key |= (program & PROGRAM_MASK) << (COMMAND_BITS + DEPTH_BITS + MATERIAL_BITS);
+    key |= (material & MATERIAL_MASK) << (COMMAND_BITS + DEPTH_BITS);
+    key |= quantizedDepth << COMMAND_BITS;
+    return key | (command & COMMAND_MASK);
+}
+
+void RenderQueue::sortKeys()
+{
+    sortBuffer.resize(keys.size());
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (uint64_t key : keys)
+            ++counts[(key >> shift) & 0xFF];
+        // pass wouldn't move anything
+        if (counts[(keys.empty() ? 0 : keys.front() >> shift) & 0xFF] == keys.size())
+            continue;
+
+        size_t offset = 0;
+        for (size_t& count : counts)
+        {
+            size_t next = offset + count;
+            count = offset;
+            offset = next;
+        }
+        for (uint64_t key : keys)
+            sortBuffer[counts[(key >> shift) & 0xFF]++] = key;
+        keys.swap(sortBuffer);
+    }
+}
+
+void RenderQueue::flush(const Shader& shader)
+{
+    batch.submit(shader);
+}
+
+void RenderQueue::setCondition(GLuint query)
+{
+    if (query == currentCondition)
+        return;
+    if (currentCondition != 0)
+        glEndConditionalRender();
+    // results which aren't ready yet let the draws through instead of stalling
+    if (query != 0)
+        glBeginConditionalRender(query, GL_QUERY_NO_WAIT);
+    currentCondition = query;
+}
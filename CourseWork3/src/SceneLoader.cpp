@@ -1,249 +1,184 @@
 #include <SceneLoader.h>
-#include <GLFW/glfw3.h>
 
-using namespace std;
+#include <algorithm>
 
-const glm::vec3::value_type  SceneLoader::MIN_ALLOWED_POSITION       = -1000;
-const glm::vec3::value_type  SceneLoader::MAX_ALLOWED_POSITION       =  1000;
-const glm::vec3::value_type  SceneLoader::MIN_ALLOWED_COLOR          =     0;
-const glm::vec3::value_type  SceneLoader::MAX_ALLOWED_COLOR          =  1000;
-const float                  SceneLoader::MIN_ALLOWED_DEGREES_ANGLE  =     0;
-const float                  SceneLoader::MAX_ALLOWED_DEGREES_ANGLE  =    90;
+using namespace std;
 
-void SceneLoader::loadScene(string lightsDataPath, string objectsDataPath,
+bool SceneLoader::loadScene(string lightsDataPath, string objectsDataPath,
     DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights, 
     Models& models, Objects& objects)
 {    
-    ifstream file;    
-    // Read point lights info
+    SceneDescription scene;
     try
     {
-        file.open(lightsDataPath);
-        stringstream lightData;
-        lightData << file.rdbuf();
-        file.close();
-
-        bool good = true;
-        int counter = 1;
-        string type;
-        while (getline(lightData, type))
-        {           
-            if (type == "point")            
-                pointLights.push_back(loadPointLight(lightData, good));                                
-            else if (type == "spot")
-                spotLights.push_back(loadSpotLight(lightData, good));            
-            else if (type == "directional")
-                dirLights.push_back(loadDirectionalLight(lightData, good));
-            else
-            {
-                cout << "ERROR::SCENE_LOADER::UNKNOWN_TYPE type: " << type << endl;
-                exitOnError();
-            }
-            if (!good)
-            {
-                cout << "ERROR::SCENE_LOADER::FAILED_TO_LOAD_LIGHT type: " << type << ", number: " << counter << endl;
-                exitOnError();
-            }
-            ++counter;   
-            //getline(lightData, type);
-        }
+        SceneParser::parseLightsFile(lightsDataPath, scene);
+        SceneParser::parseObjectsFile(objectsDataPath, scene);
     }
-    catch (std::ifstream::failure e)
+    catch (const SceneParseError& e)
     {
-        cout << "ERROR::SCENE_LOADER::FAILED_TO_READ_LIGHTS_DATA" << endl;
-        exitOnError();
+        cout << "ERROR::SCENE_LOADER::" << e.what() 
+             << " file: " << e.getFile() << ", line: " << e.getLine() << ", column: " << e.getColumn() << endl;
+        return false;
     }
 
-    ifstream modelFile;
-    vector<glm::vec3> positions;
-    vector<glm::vec3> rotations;
-    vector<glm::vec3> scales;
-    vector<string> paths;
-    vector<int> modelIndexes;
+    loadScene(scene, dirLights, pointLights, spotLights, models, objects);
+    return true;
+}
 
-    try
+void SceneLoader::loadScene(const SceneDescription& scene,
+    DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights,
+    Models& models, Objects& objects)
+{
+    dirLights.insert(dirLights.end(), scene.dirLights.begin(), scene.dirLights.end());
+    pointLights.insert(pointLights.end(), scene.pointLights.begin(), scene.pointLights.end());
+    spotLights.insert(spotLights.end(), scene.spotLights.begin(), scene.spotLights.end());
+
+    // models are imported in parallel, then every distinct path is resolved once and objects refer to models by index
+    vector<pair<string, ModelImportOptions>> requests;
+    for (const string& path : scene.modelPaths)
+        requests.emplace_back(path, ModelImportOptions());
+    assets.preload(requests);
+
+    vector<shared_ptr<Model>> sceneModels;
+    sceneModels.reserve(scene.modelPaths.size());
+    for (const string& path : scene.modelPaths)
     {
-        file.open(objectsDataPath);
-        stringstream objectsData;
-        objectsData << file.rdbuf();
-        file.close();
-        int i = 0;
+        size_t loadedModels = assets.size();
+        sceneModels.push_back(assets.getModel(path));
+        if (assets.size() != loadedModels)
+            models.push_back(sceneModels.back());
+    }
 
-        while (!objectsData.eof())
-        {
-            positions.push_back(getVec3(objectsData));
-            rotations.push_back(getVec3(objectsData));
-            scales.push_back(getVec3(objectsData));
-
-            if (!checkRangeVec3(positions[positions.size() - 1], -1000, 1000, "ERROR::SCENE_LOADER::WRONG_MODEL_POSITION model number: " + to_string(positions.size())) ||
-                !checkScale(scales[scales.size() - 1]))
-                exitOnError();
-
-            string path;                     
-            getline(objectsData, path);
-            paths.push_back(path);
-            
-            int index = getModelIndex(path, models);
-            if (index < 0)
-            {
-                Model model(path);
-                models.push_back(make_shared<Model>(model));
-                modelIndexes.push_back(models.size() - 1);
-            }
-            else            
-                modelIndexes.push_back(index);
-        }
+    vector<ModelHandle> handles;
+    handles.reserve(sceneModels.size());
+    for (const shared_ptr<Model>& model : sceneModels)
+        handles.push_back(objects.addModel(model));
 
-        for (int i = 0; i < modelIndexes.size(); ++i)
-        {
-            Object obj(positions[i], rotations[i], scales[i], models[modelIndexes[i]]);
-            objects.push_back(obj);
-        }        
-    }
-    catch (std::ifstream::failure e)
-    {
-        cout << "ERROR::SCENE_LOADER::FAILED_TO_READ_MODELS_DATA" << endl;  
-        exitOnError();
-    }
-    catch (exception e)
-    {
-        cout << "ERROR::SCENE_LOADER::FAILED_TO_LOAD_MODELS" << endl;
-        exitOnError();
-    }
+    objects.reserve(objects.size() + scene.objects.size());
+    for (const ObjectDescription& object : scene.objects)
+        objects.add(object.position, object.rotation, object.scale, handles[object.modelIndex]);
 }
 
-DirectionalLight SceneLoader::loadDirectionalLight(stringstream& lightData, bool& good)
+void SceneLoader::loadScene(const SceneSnapshot& snapshot,
+    DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights,
+    Models& models, Objects& objects)
 {
-    glm::vec3 color = getVec3(lightData);
-    glm::vec3 direction = getVec3(lightData);
+    const snapshot::Header& header = snapshot.getHeader();
 
-    good = checkRangeVec3(color, 0, 1000, "ERROR:SCENE_LOADER::WRONG_COLOR");
+    const snapshot::DirectionalLightRecord* dirLightRecords = snapshot.getDirLights();
+    dirLights.reserve(dirLights.size() + header.dirLightsNumber);
+    for (uint32_t i = 0; i < header.dirLightsNumber; ++i)
+        dirLights.push_back(DirectionalLight(dirLightRecords[i].direction, dirLightRecords[i].color));
 
-    DirectionalLight light(direction, color/*, ambient, diffuse, specular*/);
-    return light;
-}
+    const snapshot::PointLightRecord* pointLightRecords = snapshot.getPointLights();
+    pointLights.reserve(pointLights.size() + header.pointLightsNumber);
+    for (uint32_t i = 0; i < header.pointLightsNumber; ++i)
+    {
+        const snapshot::PointLightRecord& light = pointLightRecords[i];
+        pointLights.push_back(PointLight(light.position, light.color,
+                                         light.constant, light.linear, light.quadratic));
+    }
 
-PointLight SceneLoader::loadPointLight(stringstream& lightData, bool& good)
-{
-    glm::vec3 position = getVec3(lightData);
-    glm::vec3 color = getVec3(lightData);
-
-    float constant;
-    float linear;
-    float quadratic;      
-    lightData >> constant >> linear >> quadratic;   
-    string str;//dummy
-    getline(lightData, str);
-
-    good =  checkRangeVec3(position, -1000, 1000, "ERROR::SCENE_LOADER::WRONG_POSITION") &&
-            checkRangeVec3(color, 0, 1000, "ERROR:SCENE_LOADER::WRONG_COLOR") &&
-            checkAttenuation(constant, linear, quadratic);
-
-    PointLight pointLight(position, color, 
-                          constant, linear, quadratic);
-    return pointLight;
-}
+    const snapshot::SpotLightRecord* spotLightRecords = snapshot.getSpotLights();
+    spotLights.reserve(spotLights.size() + header.spotLightsNumber);
+    for (uint32_t i = 0; i < header.spotLightsNumber; ++i)
+    {
+        const snapshot::SpotLightRecord& light = spotLightRecords[i];
+        spotLights.push_back(SpotLight(light.position, light.color, light.direction,
+                                       light.constant, light.linear, light.quadratic,
+                                       light.cutOff, light.outerCutOff));
+    }
 
-SpotLight SceneLoader::loadSpotLight(std::stringstream & lightData, bool& good)
-{
-    glm::vec3 position = getVec3(lightData);
-    glm::vec3 color = getVec3(lightData);
-    glm::vec3 direction = getVec3(lightData);
-
-    float constant;
-    float linear;
-    float quadratic;
-    float cutOff;
-    float outerCutOff;  
-    string str;//dummy
-    lightData >> constant >> linear >> quadratic;
-    getline(lightData, str);
-    lightData >> cutOff >> outerCutOff;
-    getline(lightData, str);
-
-    good = checkRangeVec3(position, MIN_ALLOWED_POSITION, MAX_ALLOWED_POSITION, "ERROR::SCENE_LOADER::WRONG_POSITION") &&
-        checkRangeVec3(color, MIN_ALLOWED_COLOR, MAX_ALLOWED_COLOR, "ERROR:SCENE_LOADER::WRONG_COLOR") &&
-        checkAttenuation(constant, linear, quadratic) &&
-        checkAngles(cutOff, outerCutOff);
-
-    SpotLight spotLight(position, color, direction, 
-                        constant, linear, quadratic,
-                        cutOff, outerCutOff);
-
-    return spotLight;
-}
+    const snapshot::ModelRecord* modelRecords = snapshot.getModels();
+    vector<pair<string, ModelImportOptions>> requests;
+    requests.reserve(header.modelsNumber);
+    for (uint32_t i = 0; i < header.modelsNumber; ++i)
+    {
+        ModelImportOptions options;
+        options.postProcessFlags = modelRecords[i].postProcessFlags;
+        options.importSteps = modelRecords[i].importSteps;
+        requests.emplace_back(snapshot.getModelPath(modelRecords[i]), options);
+    }
+    assets.preload(requests);
 
-int SceneLoader::getModelIndex(string path, const Models& models)
-{
-    int i = 0;
-    bool modelExists = false;
-    while (!modelExists && i < models.size())
+    vector<ModelHandle> handles;
+    handles.reserve(header.modelsNumber);
+    for (uint32_t i = 0; i < header.modelsNumber; ++i)
     {
-        modelExists = (path.substr(0, path.find_last_of('/')) == models[i]->directory);
-        ++i;
+        size_t loadedModels = assets.size();
+        shared_ptr<Model> model = assets.getModel(requests[i].first, requests[i].second);
+        if (assets.size() != loadedModels)
+            models.push_back(model);
+        handles.push_back(objects.addModel(model));
     }
-    if (modelExists)
-        return i - 1;
-    else
-        return -1;
-}
 
-glm::vec3 SceneLoader::getVec3(stringstream& data)
-{
-    glm::vec3 vec3;
-    data >> vec3.x;
-    data >> vec3.y;
-    data >> vec3.z; 
-    string str;//dummy
-    getline(data, str);
-    return vec3;
+    const snapshot::ObjectRecord* objectRecords = snapshot.getObjects();
+    objects.reserve(objects.size() + header.objectsNumber);
+    for (uint32_t i = 0; i < header.objectsNumber; ++i)
+    {
+        const snapshot::ObjectRecord& object = objectRecords[i];
+        objects.add(object.position, object.rotation, object.scale, handles[object.modelIndex]);
+    }
 }
 
-bool SceneLoader::checkRangeVec3(glm::vec3 vector, double left, double right, string message)
+void SceneLoader::applyChanges(const SceneDiff& diff,
+    DirectionalLights& dirLights, PointLights& pointLights, SpotLights& spotLights,
+    Models& models, Objects& objects)
 {
-    if (left <= vector.x && vector.x <= right &&
-        left <= vector.y && vector.y <= right &&
-        left <= vector.z && vector.z <= right)
-        return true;
+    applyLightChanges(diff.dirLights, dirLights);
+    applyLightChanges(diff.pointLights, pointLights);
+    applyLightChanges(diff.spotLights, spotLights);
 
-    cout << message << endl;
-    return false;
-}
+    for (const SceneDiff::ObjectChange& change : diff.changedObjects)
+        objects.setTransform(change.index, change.position, change.rotation, change.scale);
+    objects.updateTransforms();
 
-void SceneLoader::exitOnError()
-{
-    glfwTerminate();
-    //cin.ignore();
-    cin.get();    
-    exit(-1);
-}
+    // removal keeps order of remaining objects, SceneReloader relies on it
+    objects.remove(diff.removedObjects);
 
-bool SceneLoader::checkAttenuation(double constant, double linear, double quadratic)
-{
-    if (constant >= 0 && linear >= 0 && quadratic >= 0 &&
-        constant * constant + linear * linear + quadratic * quadratic > 0)
-        return true;
+    // only models which are not loaded yet are imported, all of them at once
+    vector<pair<string, ModelImportOptions>> requests;
+    vector<bool> requested(diff.modelPaths.size(), false);
+    for (const ObjectDescription& object : diff.addedObjects)
+    {
+        if (!requested[object.modelIndex])
+        {
+            requested[object.modelIndex] = true;
+            requests.emplace_back(diff.modelPaths[object.modelIndex], ModelImportOptions());
+        }
+    }
+    assets.preload(requests);
 
-    cout << "ERROR::SCENE_LOADER::WRONG_ATTENUATION_COEFFICIENTS" << endl;
-    return false;
-}
+    vector<ModelHandle> handles(diff.modelPaths.size(), ObjectStore::NO_MODEL);
+    for (const ObjectDescription& object : diff.addedObjects)
+    {
+        ModelHandle& handle = handles[object.modelIndex];
+        if (handle == ObjectStore::NO_MODEL)
+        {
+            shared_ptr<Model> model = assets.getModel(diff.modelPaths[object.modelIndex]);
+            if (find(models.begin(), models.end(), model) == models.end())
+                models.push_back(model);
+            handle = objects.addModel(model);
+        }
+        objects.add(object.position, object.rotation, object.scale, handle);
+    }
 
-bool SceneLoader::checkAngles(double cutOff, double outerCutOff)
-{
-    if (cutOff > MIN_ALLOWED_DEGREES_ANGLE && cutOff < MAX_ALLOWED_DEGREES_ANGLE &&
-        outerCutOff > MIN_ALLOWED_DEGREES_ANGLE && outerCutOff < MAX_ALLOWED_DEGREES_ANGLE &&
-        outerCutOff > cutOff)
-        return true;
+    // models of removed objects are dropped, so they can be unloaded
+    objects.releaseUnusedModels();
+    models.erase(remove_if(models.begin(), models.end(),
+                           [&objects](const shared_ptr<Model>& model) { return objects.findModel(model.get()) == ObjectStore::NO_MODEL; }),
+                 models.end());
 
-    cout << "ERROR::SCENE_LOADER::WRONG_ANGLES" << endl;
-    return false;
+    cout << "SCENE_LOADER::RELOAD objects changed: " << diff.changedObjects.size()
+         << ", removed: " << diff.removedObjects.size()
+         << ", added: " << diff.addedObjects.size() << endl;
 }
 
-bool SceneLoader::checkScale(glm::vec3 scale)
+template<typename Light>
+void SceneLoader::applyLightChanges(const SceneDiff::LightChanges<Light>& changes, vector<Light>& lights)
 {
-    if (scale.x > 0 && scale.y > 0 && scale.z > 0)
-        return true;
-    
-    cout << "ERROR::SCENE_LOADER::WRONG_SCALE" << endl;
-    return false;
-}
\ No newline at end of file
+    lights.erase(lights.end() - changes.removed, lights.end());
+    for (const auto& change : changes.changed)
+        lights[change.first] = change.second;
+    lights.insert(lights.end(), changes.added.begin(), changes.added.end());
+}
@@ -0,0 +1,295 @@
+#include <SceneParser.h>
+#include <MappedFile.h>
+
+#include <algorithm>
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+
+using namespace std;
+
+const glm::vec3::value_type  SceneParser::MIN_ALLOWED_POSITION       = -1000;
+const glm::vec3::value_type  SceneParser::MAX_ALLOWED_POSITION       =  1000;
+const glm::vec3::value_type  SceneParser::MIN_ALLOWED_COLOR          =     0;
+const glm::vec3::value_type  SceneParser::MAX_ALLOWED_COLOR          =  1000;
+const float                  SceneParser::MIN_ALLOWED_DEGREES_ANGLE  =     0;
+const float                  SceneParser::MAX_ALLOWED_DEGREES_ANGLE  =    90;
+
+void SceneParser::parseLightsFile(const string& path, SceneDescription& scene)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+        throw SceneParseError("FAILED_TO_READ_LIGHTS_DATA", path, 0, 0);
+
+    SceneParser parser(file.data(), file.size(), path);
+    parser.parseLights(scene);
+}
+
+void SceneParser::parseObjectsFile(const string& path, SceneDescription& scene)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+        throw SceneParseError("FAILED_TO_READ_MODELS_DATA", path, 0, 0);
+
+    SceneParser parser(file.data(), file.size(), path);
+    parser.parseObjects(scene);
+}
+
+SceneParser::SceneParser(const char* data, size_t size, const string& fileName)
+    : _cursor(data)
+    , _end(data + size)
+    , _lineStart(data)
+    , _fileName(fileName)
+{
+}
+
+void SceneParser::parseLights(SceneDescription& scene)
+{
+    skipEmptyLines();
+    while (!atEnd())
+    {
+        int typeLine = _line;
+        int typeColumn = static_cast<int>(_cursor - _lineStart) + 1;
+        string type = readLine();
+
+        if (type == "point")
+            scene.pointLights.push_back(parsePointLight());
+        else if (type == "spot")
+            scene.spotLights.push_back(parseSpotLight());
+        else if (type == "directional")
+            scene.dirLights.push_back(parseDirectionalLight());
+        else
+            error("UNKNOWN_TYPE type: " + type, typeLine, typeColumn);
+
+        skipEmptyLines();
+    }
+}
+
+void SceneParser::parseObjects(SceneDescription& scene)
+{
+    // paths are interned while file is mapped, so repeated paths cost one hash lookup each.
+    // Keys point into mapped data or into a copy of already known paths, which never reallocates.
+    const vector<string> knownPaths = scene.modelPaths;
+    unordered_map<string_view, uint32_t> pathIndices;
+    for (uint32_t i = 0; i < knownPaths.size(); ++i)
+        pathIndices.emplace(knownPaths[i], i);
+
+    // every object takes four lines, counting them is much cheaper than regrowing the vector
+    scene.objects.reserve(scene.objects.size() + count(_cursor, _end, '\n') / 4 + 1);
+
+    skipEmptyLines();
+    while (!atEnd())
+    {
+        int line = _line;
+
+        ObjectDescription object;
+        object.position = readVec3Line();
+        object.rotation = readVec3Line();
+        object.scale = readVec3Line();
+
+        checkRangeVec3(object.position, MIN_ALLOWED_POSITION, MAX_ALLOWED_POSITION, "WRONG_MODEL_POSITION", line);
+        checkScale(object.scale, line + 2);
+
+        skipSpaces();
+        const char* pathStart = _cursor;
+        const char* pathEnd = _cursor;
+        while (_cursor != _end && *_cursor != '\n')
+        {
+            if (*_cursor != ' ' && *_cursor != '\t' && *_cursor != '\r')
+                pathEnd = _cursor + 1;
+            ++_cursor;
+        }
+        if (pathStart == pathEnd)
+            error("EXPECTED_MODEL_PATH");
+
+        string_view path(pathStart, pathEnd - pathStart);
+        auto it = pathIndices.find(path);
+        if (it == pathIndices.end())
+        {
+            scene.modelPaths.emplace_back(path);
+            it = pathIndices.emplace(path, static_cast<uint32_t>(scene.modelPaths.size() - 1)).first;
+        }
+        object.modelIndex = it->second;
+        scene.objects.push_back(object);
+
+        nextLine();
+        skipEmptyLines();
+    }
+}
+
+DirectionalLight SceneParser::parseDirectionalLight()
+{
+    int line = _line;
+    glm::vec3 color = readVec3Line();
+    glm::vec3 direction = readVec3Line();
+
+    checkRangeVec3(color, MIN_ALLOWED_COLOR, MAX_ALLOWED_COLOR, "WRONG_COLOR", line);
+
+    return DirectionalLight(direction, color);
+}
+
+PointLight SceneParser::parsePointLight()
+{
+    int line = _line;
+    glm::vec3 position = readVec3Line();
+    glm::vec3 color = readVec3Line();
+
+    float constant = readFloat();
+    float linear = readFloat();
+    float quadratic = readFloat();
+    nextLine();
+
+    checkRangeVec3(position, MIN_ALLOWED_POSITION, MAX_ALLOWED_POSITION, "WRONG_POSITION", line);
+    checkRangeVec3(color, MIN_ALLOWED_COLOR, MAX_ALLOWED_COLOR, "WRONG_COLOR", line + 1);
+    checkAttenuation(constant, linear, quadratic, line + 2);
+
+    return PointLight(position, color,
+                      constant, linear, quadratic);
+}
+
+SpotLight SceneParser::parseSpotLight()
+{
+    int line = _line;
+    glm::vec3 position = readVec3Line();
+    glm::vec3 color = readVec3Line();
+    glm::vec3 direction = readVec3Line();
+
+    float constant = readFloat();
+    float linear = readFloat();
+    float quadratic = readFloat();
+    nextLine();
+    float cutOff = readFloat();
+    float outerCutOff = readFloat();
+    nextLine();
+
+    checkRangeVec3(position, MIN_ALLOWED_POSITION, MAX_ALLOWED_POSITION, "WRONG_POSITION", line);
+    checkRangeVec3(color, MIN_ALLOWED_COLOR, MAX_ALLOWED_COLOR, "WRONG_COLOR", line + 1);
+    checkAttenuation(constant, linear, quadratic, line + 3);
+    checkAngles(cutOff, outerCutOff, line + 4);
+
+    return SpotLight(position, color, direction,
+                     constant, linear, quadratic,
+                     cutOff, outerCutOff);
+}
+
+void SceneParser::skipSpaces()
+{
+    while (_cursor != _end && (*_cursor == ' ' || *_cursor == '\t' || *_cursor == '\r'))
+        ++_cursor;
+}
+
+void SceneParser::skipEmptyLines()
+{
+    skipSpaces();
+    while (_cursor != _end && *_cursor == '\n')
+    {
+        nextLine();
+        skipSpaces();
+    }
+}
+
+void SceneParser::nextLine()
+{
+    // the rest of the line is ignored, like getline() did after reading values
+    while (_cursor != _end && *_cursor != '\n')
+        ++_cursor;
+    if (_cursor != _end)
+    {
+        ++_cursor;
+        ++_line;
+        _lineStart = _cursor;
+    }
+}
+
+float SceneParser::readFloat()
+{
+    skipSpaces();
+    if (_cursor == _end || *_cursor == '\n')
+        error("EXPECTED_NUMBER");
+
+    // from_chars doesn't accept explicit plus sign, unlike operator>>
+    const char* first = _cursor;
+    if (*first == '+')
+        ++first;
+
+    float value;
+    from_chars_result result = from_chars(first, _end, value);
+    if (result.ec != errc() ||
+        (result.ptr != _end && *result.ptr != ' ' && *result.ptr != '\t' && *result.ptr != '\r' && *result.ptr != '\n'))
+        error("EXPECTED_NUMBER");
+
+    _cursor = result.ptr;
+    return value;
+}
+
+glm::vec3 SceneParser::readVec3Line()
+{
+    glm::vec3 vec3;
+    vec3.x = readFloat();
+    vec3.y = readFloat();
+    vec3.z = readFloat();
+    nextLine();
+    return vec3;
+}
+
+string SceneParser::readLine()
+{
+    skipSpaces();
+    const char* start = _cursor;
+    const char* finish = _cursor;
+    while (_cursor != _end && *_cursor != '\n')
+    {
+        if (*_cursor != ' ' && *_cursor != '\t' && *_cursor != '\r')
+            finish = _cursor + 1;
+        ++_cursor;
+    }
+    nextLine();
+    return string(start, finish);
+}
+
+void SceneParser::checkRangeVec3(glm::vec3 vector, double left, double right, const string& message, int line)
+{
+    if (left <= vector.x && vector.x <= right &&
+        left <= vector.y && vector.y <= right &&
+        left <= vector.z && vector.z <= right)
+        return;
+
+    error(message, line, 1);
+}
+
+void SceneParser::checkAttenuation(double constant, double linear, double quadratic, int line)
+{
+    if (constant >= 0 && linear >= 0 && quadratic >= 0 &&
+        constant * constant + linear * linear + quadratic * quadratic > 0)
+        return;
+
+    error("WRONG_ATTENUATION_COEFFICIENTS", line, 1);
+}
+
+void SceneParser::checkAngles(double cutOff, double outerCutOff, int line)
+{
+    if (cutOff > MIN_ALLOWED_DEGREES_ANGLE && cutOff < MAX_ALLOWED_DEGREES_ANGLE &&
+        outerCutOff > MIN_ALLOWED_DEGREES_ANGLE && outerCutOff < MAX_ALLOWED_DEGREES_ANGLE &&
+        outerCutOff > cutOff)
+        return;
+
+    error("WRONG_ANGLES", line, 1);
+}
+
+void SceneParser::checkScale(glm::vec3 scale, int line)
+{
+    if (scale.x > 0 && scale.y > 0 && scale.z > 0)
+        return;
+
+    error("WRONG_SCALE", line, 1);
+}
+
+void SceneParser::error(const string& message) const
+{
+    error(message, _line, static_cast<int>(_cursor - _lineStart) + 1);
+}
+
+void SceneParser::error(const string& message, int line, int column) const
+{
+    throw SceneParseError(message, _fileName, line, column);
+}
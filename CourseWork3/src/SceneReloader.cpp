@@ -0,0 +1,215 @@
+#include <SceneReloader.h>
+
+#include <iostream>
+#include <unordered_map>
+
+using namespace std;
+
+const chrono::milliseconds SceneReloader::POLL_INTERVAL(500);
+
+namespace
+{
+    bool operator==(const DirectionalLight& left, const DirectionalLight& right)
+    {
+        return left.getDirection() == right.getDirection() && left.getColor() == right.getColor();
+    }
+
+    bool operator==(const PointLight& left, const PointLight& right)
+    {
+        return left.getPosition() == right.getPosition() && left.getColor() == right.getColor() &&
+               left.getConstant() == right.getConstant() && left.getLinear() == right.getLinear() &&
+               left.getQuadratic() == right.getQuadratic();
+    }
+
+    bool operator==(const SpotLight& left, const SpotLight& right)
+    {
+        return left.getPosition() == right.getPosition() && left.getColor() == right.getColor() &&
+               left.getDirection() == right.getDirection() &&
+               left.getConstant() == right.getConstant() && left.getLinear() == right.getLinear() &&
+               left.getQuadratic() == right.getQuadratic() &&
+               left.getCutOff() == right.getCutOff() && left.getOuterCutOff() == right.getOuterCutOff();
+    }
+
+    template<typename Light>
+    SceneDiff::LightChanges<Light> diffLights(const vector<Light>& current, const vector<Light>& next)
+    {
+        SceneDiff::LightChanges<Light> changes;
+        size_t common = min(current.size(), next.size());
+        for (size_t i = 0; i < common; ++i)
+        {
+            if (!(current[i] == next[i]))
+                changes.changed.emplace_back(i, next[i]);
+        }
+        changes.added.assign(next.begin() + common, next.end());
+        changes.removed = current.size() - common;
+        return changes;
+    }
+
+    template<typename Light>
+    bool isEmpty(const SceneDiff::LightChanges<Light>& changes)
+    {
+        return changes.changed.empty() && changes.added.empty() && changes.removed == 0;
+    }
+
+    filesystem::file_time_type writeTime(const string& path)
+    {
+        error_code error;
+        filesystem::file_time_type time = filesystem::last_write_time(path, error);
+        return error ? filesystem::file_time_type::min() : time;
+    }
+}
+
+bool SceneDiff::empty() const
+{
+    return isEmpty(dirLights) && isEmpty(pointLights) && isEmpty(spotLights) &&
+           changedObjects.empty() && removedObjects.empty() && addedObjects.empty();
+}
+
+SceneReloader::SceneReloader(const string& lightsDataPath, const string& modelsDataPath, const SceneDescription& scene)
+    : lightsDataPath(lightsDataPath)
+    , modelsDataPath(modelsDataPath)
+    , lightsWriteTime(writeTime(lightsDataPath))
+    , modelsWriteTime(writeTime(modelsDataPath))
+    , current(scene)
+    , watcher(&SceneReloader::watch, this)
+{
+}
+
+SceneReloader::~SceneReloader()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    stopCondition.notify_one();
+    watcher.join();
+}
+
+vector<SceneDiff> SceneReloader::takePendingChanges()
+{
+    vector<SceneDiff> result;
+    lock_guard<std::mutex> lock(mutex);
+    result.swap(pending);
+    return result;
+}
+
+SceneDescription SceneReloader::describe(const DirectionalLights& dirLights, const PointLights& pointLights,
+                                         const SpotLights& spotLights, const Objects& objects)
+{
+    SceneDescription scene;
+    scene.dirLights = dirLights;
+    scene.pointLights = pointLights;
+    scene.spotLights = spotLights;
+
+    unordered_map<ModelHandle, uint32_t> modelIndices;
+    scene.objects.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        auto it = modelIndices.find(objects.getModelHandle(i));
+        if (it == modelIndices.end())
+        {
+            scene.modelPaths.push_back(objects.getModel(i).getPath());
+            it = modelIndices.emplace(objects.getModelHandle(i), static_cast<uint32_t>(scene.modelPaths.size() - 1)).first;
+        }
+        scene.objects.push_back({ objects.getPosition(i), objects.getRotation(i), objects.getScale(i), it->second });
+    }
+    return scene;
+}
+
+void SceneReloader::watch()
+{
+    unique_lock<std::mutex> lock(mutex);
+    while (!stopCondition.wait_for(lock, POLL_INTERVAL, [this] { return stopRequested; }))
+    {
+        // files are parsed without holding the lock, so render thread never waits for it
+        lock.unlock();
+        if (filesChanged())
+        {
+            SceneDescription next;
+            try
+            {
+                SceneParser::parseLightsFile(lightsDataPath, next);
+                SceneParser::parseObjectsFile(modelsDataPath, next);
+
+                SceneDiff diff = makeDiff(current, next);
+                if (!diff.empty())
+                {
+                    lock_guard<std::mutex> pendingLock(mutex);
+                    pending.push_back(move(diff));
+                }
+            }
+            catch (const SceneParseError& e)
+            {
+                // scene stays as it is until files are fixed
+                cout << "ERROR::SCENE_RELOADER::" << e.what()
+                     << " file: " << e.getFile() << ", line: " << e.getLine() << ", column: " << e.getColumn() << endl;
+            }
+        }
+        lock.lock();
+    }
+}
+
+bool SceneReloader::filesChanged()
+{
+    filesystem::file_time_type lightsTime = writeTime(lightsDataPath);
+    filesystem::file_time_type modelsTime = writeTime(modelsDataPath);
+    bool changed = lightsTime != lightsWriteTime || modelsTime != modelsWriteTime;
+    lightsWriteTime = lightsTime;
+    modelsWriteTime = modelsTime;
+    return changed;
+}
+
+SceneDiff SceneReloader::makeDiff(SceneDescription& current, const SceneDescription& next)
+{
+    SceneDiff diff;
+    diff.dirLights = diffLights(current.dirLights, next.dirLights);
+    diff.pointLights = diffLights(current.pointLights, next.pointLights);
+    diff.spotLights = diffLights(current.spotLights, next.spotLights);
+    diff.modelPaths = next.modelPaths;
+
+    // current objects with the same model path, in order of appearance
+    unordered_map<string, vector<size_t>> currentByPath;
+    for (size_t i = 0; i < current.objects.size(); ++i)
+        currentByPath[current.modelPaths[current.objects[i].modelIndex]].push_back(i);
+
+    // k-th object with some path in next scene corresponds to k-th object with that path in current scene
+    vector<size_t> occurrences(next.modelPaths.size(), 0);
+    vector<bool> matched(current.objects.size(), false);
+    vector<ObjectDescription> survivors(current.objects.size());
+    for (const ObjectDescription& object : next.objects)
+    {
+        const vector<size_t>& candidates = currentByPath[next.modelPaths[object.modelIndex]];
+        size_t occurrence = occurrences[object.modelIndex]++;
+        if (occurrence >= candidates.size())
+        {
+            diff.addedObjects.push_back(object);
+            continue;
+        }
+
+        size_t index = candidates[occurrence];
+        const ObjectDescription& old = current.objects[index];
+        if (old.position != object.position || old.rotation != object.rotation || old.scale != object.scale)
+            diff.changedObjects.push_back({ index, object.position, object.rotation, object.scale });
+        matched[index] = true;
+        survivors[index] = object;
+    }
+
+    // live objects after the diff: survivors in their old order followed by added objects
+    vector<ObjectDescription> objects;
+    objects.reserve(next.objects.size());
+    for (size_t i = 0; i < current.objects.size(); ++i)
+    {
+        if (matched[i])
+            objects.push_back(survivors[i]);
+        else
+            diff.removedObjects.push_back(i);
+    }
+    objects.insert(objects.end(), diff.addedObjects.begin(), diff.addedObjects.end());
+
+    current.dirLights = next.dirLights;
+    current.pointLights = next.pointLights;
+    current.spotLights = next.spotLights;
+    current.objects = move(objects);
+    current.modelPaths = next.modelPaths;
+    return diff;
+}
@@ -0,0 +1,126 @@
+#include <SceneSnapshot.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+using namespace std;
+using namespace snapshot;
+
+namespace
+{
+    const char* const TEMPORARY_SUFFIX = ".tmp";
+}
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "snapshot records expect tightly packed vectors");
+static_assert(sizeof(Header) % 8 == 0 && sizeof(DirectionalLightRecord) % 4 == 0 && sizeof(PointLightRecord) % 4 == 0 &&
+              sizeof(SpotLightRecord) % 4 == 0 && sizeof(ObjectRecord) % 4 == 0 && sizeof(ModelRecord) % 4 == 0,
+              "snapshot records must keep following arrays aligned");
+
+bool SceneSnapshot::save(const string& path,
+    const DirectionalLights& dirLights, const PointLights& pointLights, const SpotLights& spotLights,
+    const Objects& objects)
+{
+    vector<DirectionalLightRecord> dirLightRecords;
+    dirLightRecords.reserve(dirLights.size());
+    for (const DirectionalLight& light : dirLights)
+        dirLightRecords.push_back({ light.getDirection(), light.getColor() });
+
+    vector<PointLightRecord> pointLightRecords;
+    pointLightRecords.reserve(pointLights.size());
+    for (const PointLight& light : pointLights)
+        pointLightRecords.push_back({ light.getPosition(), light.getColor(),
+                                      light.getConstant(), light.getLinear(), light.getQuadratic() });
+
+    vector<SpotLightRecord> spotLightRecords;
+    spotLightRecords.reserve(spotLights.size());
+    for (const SpotLight& light : spotLights)
+        spotLightRecords.push_back({ light.getPosition(), light.getColor(), light.getDirection(),
+                                     light.getConstant(), light.getLinear(), light.getQuadratic(),
+                                     light.getCutOff(), light.getOuterCutOff() });
+
+    // every distinct model is written once, objects refer to it by index
+    unordered_map<ModelHandle, uint32_t> modelIndices;
+    vector<ModelRecord> modelRecords;
+    string strings;
+    vector<ObjectRecord> objectRecords;
+    objectRecords.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        auto it = modelIndices.find(objects.getModelHandle(i));
+        if (it == modelIndices.end())
+        {
+            const Model& model = objects.getModel(i);
+            const string& modelPath = model.getPath();
+            modelRecords.push_back({ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(modelPath.size()),
+                                     model.getImportOptions().postProcessFlags, model.getImportOptions().importSteps });
+            strings += modelPath;
+            it = modelIndices.emplace(objects.getModelHandle(i), static_cast<uint32_t>(modelRecords.size() - 1)).first;
+        }
+        objectRecords.push_back({ objects.getPosition(i), objects.getRotation(i), objects.getScale(i), it->second });
+    }
+
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.dirLightsNumber = static_cast<uint32_t>(dirLightRecords.size());
+    header.pointLightsNumber = static_cast<uint32_t>(pointLightRecords.size());
+    header.spotLightsNumber = static_cast<uint32_t>(spotLightRecords.size());
+    header.objectsNumber = static_cast<uint32_t>(objectRecords.size());
+    header.modelsNumber = static_cast<uint32_t>(modelRecords.size());
+    header.stringsSize = static_cast<uint32_t>(strings.size());
+    header.dirLightsOffset = sizeof(Header);
+    header.pointLightsOffset = header.dirLightsOffset + dirLightRecords.size() * sizeof(DirectionalLightRecord);
+    header.spotLightsOffset = header.pointLightsOffset + pointLightRecords.size() * sizeof(PointLightRecord);
+    header.objectsOffset = header.spotLightsOffset + spotLightRecords.size() * sizeof(SpotLightRecord);
+    header.modelsOffset = header.objectsOffset + objectRecords.size() * sizeof(ObjectRecord);
+    header.stringsOffset = header.modelsOffset + modelRecords.size() * sizeof(ModelRecord);
+
+    // written to temporary file first, so a failed save doesn't destroy the previous snapshot
+    string temporaryPath = path + TEMPORARY_SUFFIX;
+    ofstream file(temporaryPath, ios::binary | ios::trunc);
+    if (!file)
+        return false;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(dirLightRecords.data()), dirLightRecords.size() * sizeof(DirectionalLightRecord));
+    file.write(reinterpret_cast<const char*>(pointLightRecords.data()), pointLightRecords.size() * sizeof(PointLightRecord));
+    file.write(reinterpret_cast<const char*>(spotLightRecords.data()), spotLightRecords.size() * sizeof(SpotLightRecord));
+    file.write(reinterpret_cast<const char*>(objectRecords.data()), objectRecords.size() * sizeof(ObjectRecord));
+    file.write(reinterpret_cast<const char*>(modelRecords.data()), modelRecords.size() * sizeof(ModelRecord));
+    file.write(strings.data(), strings.size());
+    file.close();
+
+    error_code error;
+    if (!file)
+    {
+        filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    filesystem::rename(temporaryPath, path, error);
+    return !error;
+}
+
+bool SceneSnapshot::open(const string& path)
+{
+    _header = nullptr;
+    if (!_file.open(path) || _file.size() < sizeof(Header))
+        return false;
+
+    const Header* header = reinterpret_cast<const Header*>(_file.data());
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+        header->stringsOffset + header->stringsSize != _file.size())
+    {
+        _file.close();
+        return false;
+    }
+
+    _header = header;
+    return true;
+}
+
+string SceneSnapshot::getModelPath(const ModelRecord& model) const
+{
+    return string(_file.data() + _header->stringsOffset + model.pathOffset, model.pathLength);
+}
@@ -2,6 +2,27 @@
 
 using namespace std;
 
+namespace
+{
+    string readCode(const char* path)
+    {
+        ifstream file;
+        file.exceptions(ifstream::failbit | ifstream::badbit);
+        try
+        {
+            file.open(path);
+            stringstream stream;
+            stream << file.rdbuf();
+            return stream.str();
+        }
+        catch (std::ifstream::failure e)
+        {
+            cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ path: " << path << endl;
+        }
+        return string();
+    }
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
 {
     // 1. retrieve the vertex/fragment source code from filePath
@@ -59,6 +80,33 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     glDeleteShader(fragment);
 }
 
+Shader::Shader(const char* vertexPath, const char* geometryPath, const vector<const char*>& feedbackVaryings)
+{
+    string vertexCode = readCode(vertexPath);
+    string geometryCode = readCode(geometryPath);
+    const char* vShaderCode = vertexCode.c_str();
+    const char* gShaderCode = geometryCode.c_str();
+    // vertex shader
+    unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex, 1, &vShaderCode, NULL);
+    glCompileShader(vertex);
+    checkCompileErrors(vertex, "VERTEX");
+    // geometry shader
+    unsigned int geometry = glCreateShader(GL_GEOMETRY_SHADER);
+    glShaderSource(geometry, 1, &gShaderCode, NULL);
+    glCompileShader(geometry);
+    checkCompileErrors(geometry, "GEOMETRY");
+    // shader Program, outputs must be chosen before linking
+    ID = glCreateProgram();
+    glAttachShader(ID, vertex);
+    glAttachShader(ID, geometry);
+    glTransformFeedbackVaryings(ID, static_cast<GLsizei>(feedbackVaryings.size()), feedbackVaryings.data(), GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+    glDeleteShader(vertex);
+    glDeleteShader(geometry);
+}
+
 void Shader::checkCompileErrors(GLuint shader, std::string type)
 {
     GLint success;
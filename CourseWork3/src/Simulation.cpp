@@ -0,0 +1,171 @@
+#include <Simulation.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/constants.hpp>
+
+using namespace std;
+
+const float Simulation::DEFAULT_STEP = 1.0f / 60.0f;
+
+Simulation::Simulation(Camera& camera, PointLights& pointLights, SpotLights& spotLights, ObjectStore& objects,
+                       float step, int maxSteps)
+    : camera(camera)
+    , pointLights(pointLights)
+    , spotLights(spotLights)
+    , objects(objects)
+    , step(step)
+    , maxSteps(max(maxSteps, 1))
+{
+    reset();
+}
+
+void Simulation::addLightOrbit(bool spot, size_t light, const glm::vec3& center, float radius, float speed)
+{
+    orbits.push_back({ spot, light, center, radius, speed, 0.0f });
+}
+
+void Simulation::addObjectSpin(ObjectId object, const glm::vec3& speed)
+{
+    removeObjectSpin(object);
+    size_t index = objects.getIndex(object);
+    if (index == ObjectStore::NO_INDEX)
+        return;
+    const glm::vec3& rotation = objects.getRotation(index);
+    spins.push_back({ object, speed, rotation, rotation });
+}
+
+bool Simulation::removeObjectSpin(ObjectId object)
+{
+    auto spin = find_if(spins.begin(), spins.end(), [object](const ObjectSpin& spin) { return spin.object == object; });
+    if (spin == spins.end())
+        return false;
+    spins.erase(spin);
+    return true;
+}
+
+int Simulation::update(double time)
+{
+    if (!started)
+    {
+        lastTime = time;
+        started = true;
+    }
+    lag += time - lastTime;
+    lastTime = time;
+
+    int steps = static_cast<int>(lag / step);
+    if (steps > maxSteps)
+    {
+        // simulation falls behind real time instead of spending more and more steps on every next frame
+        statistics.droppedSteps += steps - maxSteps;
+        lag -= static_cast<double>(steps - maxSteps) * step;
+        steps = maxSteps;
+    }
+
+    if (steps > 0)
+    {
+        restore(current);
+        for (int i = 0; i < steps; ++i)
+        {
+            capture(previous);
+            runStep();
+            lag -= step;
+        }
+        capture(current);
+    }
+    statistics.steps += steps;
+    statistics.frameSteps = steps;
+
+    alpha = static_cast<float>(min(max(lag / step, 0.0), 1.0));
+    interpolate();
+    return steps;
+}
+
+void Simulation::reset()
+{
+    capture(current);
+    previous = current;
+    for (ObjectSpin& spin : spins)
+        spin.previousRotation = spin.rotation;
+}
+
+void Simulation::printStatistics(ostream& out) const
+{
+    out << "SIMULATION:: step: " << step * 1000.0f << " ms, time: " << time << " s"
+        << ", steps: " << statistics.steps << ", dropped: " << statistics.droppedSteps
+        << ", last frame: " << statistics.frameSteps << ", alpha: " << alpha << endl;
+}
+
+void Simulation::capture(State& state) const
+{
+    state.cameraPosition = camera.Position;
+    state.pointLights.resize(pointLights.size());
+    for (size_t i = 0; i < pointLights.size(); ++i)
+        state.pointLights[i] = pointLights[i].getPosition();
+    state.spotLights.resize(spotLights.size());
+    for (size_t i = 0; i < spotLights.size(); ++i)
+        state.spotLights[i] = spotLights[i].getPosition();
+}
+
+void Simulation::restore(const State& state)
+{
+    camera.Position = state.cameraPosition;
+    // lights added or removed since the state was captured keep their positions
+    for (size_t i = 0; i < min(pointLights.size(), state.pointLights.size()); ++i)
+        pointLights[i].setPosition(state.pointLights[i]);
+    for (size_t i = 0; i < min(spotLights.size(), state.spotLights.size()); ++i)
+        spotLights[i].setPosition(state.spotLights[i]);
+}
+
+void Simulation::runStep()
+{
+    if (stepFunction)
+        stepFunction(step);
+    time += step;
+
+    for (LightOrbit& orbit : orbits)
+    {
+        orbit.angle = fmod(orbit.angle + orbit.speed * step, 2.0f * glm::pi<float>());
+        glm::vec3 position = orbit.center + orbit.radius * glm::vec3(cos(orbit.angle), 0.0f, sin(orbit.angle));
+        if (orbit.spot && orbit.light < spotLights.size())
+            spotLights[orbit.light].setPosition(position);
+        else if (!orbit.spot && orbit.light < pointLights.size())
+            pointLights[orbit.light].setPosition(position);
+    }
+
+    for (ObjectSpin& spin : spins)
+    {
+        spin.previousRotation = spin.rotation;
+        spin.rotation += spin.speed * step;
+        // both angles are wrapped together, so interpolation never goes the long way round
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float turns = floor(spin.rotation[axis] / 360.0f);
+            spin.rotation[axis] -= turns * 360.0f;
+            spin.previousRotation[axis] -= turns * 360.0f;
+        }
+    }
+}
+
+void Simulation::interpolate()
+{
+    camera.Position = glm::mix(previous.cameraPosition, current.cameraPosition, alpha);
+    for (size_t i = 0; i < min({ pointLights.size(), previous.pointLights.size(), current.pointLights.size() }); ++i)
+        pointLights[i].setPosition(glm::mix(previous.pointLights[i], current.pointLights[i], alpha));
+    for (size_t i = 0; i < min({ spotLights.size(), previous.spotLights.size(), current.spotLights.size() }); ++i)
+        spotLights[i].setPosition(glm::mix(previous.spotLights[i], current.spotLights[i], alpha));
+
+    movedObjects.clear();
+    for (const ObjectSpin& spin : spins)
+    {
+        size_t index = objects.getIndex(spin.object);
+        if (index == ObjectStore::NO_INDEX)
+            continue;
+        objects.setTransform(index, objects.getPosition(index), glm::mix(spin.previousRotation, spin.rotation, alpha),
+                             objects.getScale(index));
+        movedObjects.push_back(index);
+    }
+    objects.updateTransforms();
+}
@@ -0,0 +1,112 @@
+#include <TransparencyBuffer.h>
+
+using namespace std;
+
+TransparencyBuffer::TransparencyBuffer(int width, int height)
+    : width(width)
+    , height(height)
+{
+    create();
+}
+
+TransparencyBuffer::~TransparencyBuffer()
+{
+    destroy();
+}
+
+void TransparencyBuffer::resize(int width, int height)
+{
+    if (width == this->width && height == this->height)
+        return;
+
+    this->width = width;
+    this->height = height;
+    destroy();
+    create();
+}
+
+void TransparencyBuffer::begin()
+{
+    // depth format must match default framebuffer's one for the copy
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    // revealage starts at 1, nothing covers the scene yet
+    const GLfloat accumulationClear[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const GLfloat weightClear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, accumulationClear);
+    glClearBufferfv(GL_COLOR, 1, weightClear);
+
+    // transparent surfaces are tested against opaque ones, but don't hide each other
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    // colors and weights are summed, alpha of the first target becomes product of (1 - alpha)
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void TransparencyBuffer::beginComposite(const Shader& shader)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    shader.use();
+    shader.setInt("accumulation", 0);
+    shader.setInt("weights", 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, accumulationTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, weightTexture);
+}
+
+void TransparencyBuffer::end()
+{
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+}
+
+void TransparencyBuffer::create()
+{
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    // sums of many weighted colors need floating point range
+    for (unsigned int* texture : { &accumulationTexture, &weightTexture })
+    {
+        glGenTextures(1, texture);
+        glBindTexture(GL_TEXTURE_2D, *texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulationTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weightTexture, 0);
+    GLenum attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "ERROR::TRANSPARENCY_BUFFER::FRAMEBUFFER_INCOMPLETE" << endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void TransparencyBuffer::destroy()
+{
+    glDeleteTextures(1, &accumulationTexture);
+    glDeleteTextures(1, &weightTexture);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+}
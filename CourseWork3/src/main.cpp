@@ -13,10 +13,32 @@
 
 #include <Shader.h>
 #include <Camera.h>
+#include <CameraBuffer.h>
+#include <MouseLook.h>
 #include <SceneLoader.h>
+#include <AssetRegistry.h>
+#include <SceneSnapshot.h>
+#include <SceneReloader.h>
 #include <LightManager.h>
+#include <Simulation.h>
 #include <Objects/Model.h>
-#include <Objects/Object.h>
+#include <Objects/ObjectStore.h>
+#include <Objects/GeometryArena.h>
+#include <Objects/GeometryCache.h>
+#include <Objects/Material.h>
+#include <Objects/ImpostorRenderer.h>
+#include <Objects/InstanceCuller.h>
+#include <Objects/StaticBatcher.h>
+#include <Frustum.h>
+#include <FramePipeline.h>
+#include <JobSystem.h>
+#include <BoundingVolumeHierarchy.h>
+#include <OcclusionCuller.h>
+#include <OcclusionQueries.h>
+#include <RenderQueue.h>
+#include <TransparencyBuffer.h>
+#include <Primitives.h>
+#include <LightGizmos.h>
 #include <Aliases.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -25,17 +47,20 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <filesystem>
+#include <functional>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow *window, LightManager& lightManager);
-void renderCube();
-void renderPyramid();
-void renderQuad();
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
+void pickObject(bool spin);
+void processInput(GLFWwindow *window);
 void renderSkybox(unsigned int cubemapTexture);
 unsigned int loadCubemap(std::vector<std::string> faces);
+bool isSnapshotUpToDate();
+void setupLights(const Shader& shader);
 
 // Screen settings
 unsigned int screenWidth = 1200;
@@ -43,13 +68,22 @@ unsigned int screenHeight = 720;
 
 // Camera settings
 Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
 float lastX = screenWidth / 2.0f;
 float lastY = screenHeight / 2.0f;
 bool firstMouse = true;
 
-// Timing
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+// Mouse movement is applied where the frame needs it, M toggles smoothing.
+// In low latency mode, toggled by F12, input is polled right before submission and turns the view of the frame,
+// which was culled with field of view this much wider to cover the turn. F7 prints latency from input to swap.
+MouseLook mouseLook;
+bool lateLatching = false;
+const float LATE_LATCH_CULLING_FOV_SCALE = 1.25f;
+
+// Events may be polled while the next frame is prepared or right before submission, so callbacks changing
+// camera, objects or animations queue actions applied at the start of the next frame. Only mouse look applies at once.
+std::vector<std::function<void()>> inputActions;
 
 // Max number of lights (their values must match with values in shader)
 const PointLights::size_type        MAX_NUMBER_OF_POINT_LIGHTS          = 32;
@@ -57,12 +91,55 @@ const SpotLights::size_type         MAX_NUMBER_OF_SPOT_LIGHTS           = 32;
 const DirectionalLights::size_type  MAX_NUMBER_OF_DIRECTIONAL_LIGHTS    = 4;
 const unsigned int                  SKYBOX_TEXTURE_INDEX                = 15;
 
+// Scene files
+const char* const LIGHTS_DATA_PATH  = "LightData.txt";
+const char* const MODELS_DATA_PATH  = "ModelData.txt";
+const char* const SNAPSHOT_PATH     = "Scene.snapshot";
+
+// Objects farther than that are drawn as impostors
+const float IMPOSTOR_DISTANCE = 40.0f;
+
+// Static objects which aren't instanced are merged by cells of this size, F6 toggles batching
+const float STATIC_BATCH_CELL_SIZE = 16.0f;
+bool staticBatching = true;
+bool staticBatchesOutdated = true;
+
+// Static objects of models used at least InstanceCuller::MIN_INSTANCES times are culled on GPU and drawn instanced.
+// Results arrive a frame or two later, so instances are culled with field of view this much wider.
+InstanceCuller instanceCuller;
+const float INSTANCE_CULLING_FOV_SCALE = 1.25f;
+
 // Scene contents
 DirectionalLights dirLights;
 PointLights pointLights;
 SpotLights spotLights;
 Objects objects;
 Models models; 
+AssetRegistry assets;
+
+// Camera, lights and animations move in fixed steps, rendered state is interpolated between them.
+// F11 starts and stops orbits of point lights, right click starts and stops spinning of object under cursor.
+Simulation simulation(camera, pointLights, spotLights, objects);
+const float LIGHT_ORBIT_RADIUS = 2.0f;
+const float LIGHT_ORBIT_SPEED = 1.0f;   // radians per second
+const glm::vec3 OBJECT_SPIN_SPEED = glm::vec3(0.0f, 90.0f, 0.0f); // degrees per second
+
+// Draws of a frame, F7 prints statistics of the last one
+RenderQueue renderQueue;
+
+// Spatial index of objects used for culling, rebuilt when scene files change. Left click picks object under cursor.
+BoundingVolumeHierarchy objectHierarchy;
+
+// Visible objects of the next frame are culled by jobs while the current one is submitted, F10 toggles it.
+// Only deciding how objects are drawn is split between threads, their draws are queued on the main thread.
+FramePipeline framePipeline;
+const std::size_t VISIBLE_OBJECTS_PER_JOB = 128;
+
+// Objects hidden by depth of previous frames are skipped, F8 toggles it
+OcclusionCuller occlusionCuller;
+
+// Expensive objects hidden in the previous frame are skipped by GPU, F9 toggles it
+OcclusionQueries occlusionQueries;
 
 vector<std::string> faces
 {
@@ -97,6 +174,7 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
 
     // Capture mouse by GLFW 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -108,14 +186,50 @@ int main()
         return -1;
     }   
 
+    // Loading, culling and transform updates run as jobs on all cores, GL calls stay on this thread
+    JobSystem::start();
+
+    // Shapes of skybox, light gizmos and full screen passes share one static buffer
+    Primitives::initialize();
+
     // Compile shaders       
     Shader shader("shaders/pbr.vert", "shaders/pbr.frag");   
     Shader shaderLightBox("shaders/deferred_light_box.vert", "shaders/deferred_light_box.frag");
     Shader skyboxShader("shaders/skybox.vert", "shaders/skybox.frag");
+    Shader impostorShader("shaders/impostor.vert", "shaders/impostor.frag");
+    // the same program accumulating transparent surfaces, see TransparencyBuffer
+    Shader transparentShader("shaders/pbr.vert", "shaders/pbr.frag");
+    Shader compositeShader("shaders/oit_composite.vert", "shaders/oit_composite.frag");
+    Shader hizShader("shaders/hiz_reduce.vert", "shaders/hiz_reduce.frag");
+    Shader queryShader("shaders/occlusion_query.vert", "shaders/occlusion_query.frag");
+    Shader instanceCullShader("shaders/instance_cull.vert", "shaders/instance_cull.geom", { "Instance" });
+    const unsigned int pbrProgram = renderQueue.addProgram(shader);
+    const unsigned int transparentProgram = renderQueue.addProgram(transparentShader);
+    const unsigned int impostorProgram = renderQueue.addProgram(impostorShader);
+    const unsigned int lightBoxProgram = renderQueue.addProgram(shaderLightBox);
+    const unsigned int skyboxProgram = renderQueue.addProgram(skyboxShader);
+    const unsigned int queryProgram = renderQueue.addProgram(queryShader);
     
-    // Load scene   
-    SceneLoader sceneLoader;
-    sceneLoader.loadScene("LightData.txt", "ModelData.txt", dirLights, pointLights, spotLights, models, objects);             
+    // Load scene, binary snapshot is used unless text files were edited after it had been saved
+    SceneLoader sceneLoader(assets);
+    bool sceneLoaded = true;
+    {
+        // snapshot is unmapped right after loading, so F5 can overwrite the file
+        SceneSnapshot snapshot;
+        if (isSnapshotUpToDate() && snapshot.open(SNAPSHOT_PATH))
+            sceneLoader.loadScene(snapshot, dirLights, pointLights, spotLights, models, objects);
+        else
+            sceneLoaded = sceneLoader.loadScene(LIGHTS_DATA_PATH, MODELS_DATA_PATH, dirLights, pointLights, spotLights, models, objects);
+    }
+    if (!sceneLoaded)
+    {
+        glfwTerminate();
+        return -1;
+    }
+    assets.printStatistics();
+    GeometryCache::printStatistics();
+    GeometryArena::printStatistics();
+    TexturePool::printStatistics();
 
     // Load skybox
     unsigned int cubemapTexture = loadCubemap(faces); 
@@ -129,394 +243,353 @@ int main()
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);           
 
+    // Bake impostors of all models
+    ImpostorRenderer impostors(IMPOSTOR_DISTANCE);
+    for (const shared_ptr<Model>& model : models)
+        impostors.bake(model);
+
+    StaticBatcher staticBatcher(STATIC_BATCH_CELL_SIZE);
+    LightGizmos lightGizmos;
+
+    objectHierarchy.build(objects);
+    objectHierarchy.printStatistics();
+
+    // Transparent surfaces are accumulated in any order and blended over the scene with one full screen pass
+    TransparencyBuffer transparency(screenWidth, screenHeight);
+    renderQueue.setPassHooks(RenderQueue::PASS_TRANSPARENT,
+        [&transparency]() { transparency.begin(); },
+        [&transparency, &compositeShader]()
+        {
+            transparency.beginComposite(compositeShader);
+            Primitives::draw(Primitives::QUAD);
+            transparency.end();
+        });
+
+    // Projection and view of all programs drawing the scene are taken from one buffer
+    for (const Shader* program : { &impostorShader, &shaderLightBox, &skyboxShader, &queryShader })
+        CameraBuffer::setupShader(*program);
+
+    // Setup lights
+    impostorShader.use();
+    setupLights(impostorShader);
+
     // Set shader in use
     shader.use();        
-
-    // Setup point lights
-    PointLights::size_type pointLightsNumber = min(MAX_NUMBER_OF_POINT_LIGHTS, pointLights.size());   
-    shader.setInt("pointLightsNumber", pointLightsNumber);   
-    for (PointLights::size_type i = 0; i < pointLights.size(); ++i)
+    MaterialLibrary::setupShader(shader);
+    CameraBuffer::setupShader(shader);
+    InstanceCuller::setupShader(shader);
+    shader.setInt("skybox", SKYBOX_TEXTURE_INDEX);
+
+    // Setup lights
+    setupLights(shader);
+
+    transparentShader.use();
+    MaterialLibrary::setupShader(transparentShader);
+    CameraBuffer::setupShader(transparentShader);
+    InstanceCuller::setupShader(transparentShader);
+    transparentShader.setInt("skybox", SKYBOX_TEXTURE_INDEX);
+    transparentShader.setBool("weightedBlended", true);
+    setupLights(transparentShader);
+
+    // Watch scene files, changes are applied at the beginning of a frame
+    SceneReloader sceneReloader(LIGHTS_DATA_PATH, MODELS_DATA_PATH, SceneReloader::describe(dirLights, pointLights, spotLights, objects));
+
+    // Held keys move camera and selected light at every step, so their speed doesn't depend on frame rate
+    simulation.setStepFunction([&](float step)
     {
-        shader.setVec3( "pointLights[" + to_string(i) + "].position", pointLights[i].getPosition());
-        shader.setVec3( "pointLights[" + to_string(i) + "].color", pointLights[i].getColor());        
-        shader.setFloat("pointLights[" + to_string(i) + "].constant", pointLights[i].getConstant());
-        shader.setFloat("pointLights[" + to_string(i) + "].linear", pointLights[i].getLinear());
-        shader.setFloat("pointLights[" + to_string(i) + "].quadratic", pointLights[i].getQuadratic());
-    }    
-    
-    // Setup directional lights
-    DirectionalLights::size_type dirLightsNumber = min(MAX_NUMBER_OF_DIRECTIONAL_LIGHTS, dirLights.size());
-    shader.setInt("dirLightsNumber", dirLightsNumber);
-    for (DirectionalLights::size_type i = 0; i < dirLights.size(); ++i)
+        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+            camera.ProcessKeyboard(CameraMovement::FORWARD, step);
+        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+            camera.ProcessKeyboard(CameraMovement::BACKWARD, step);
+        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+            camera.ProcessKeyboard(CameraMovement::LEFT, step);
+        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+            camera.ProcessKeyboard(CameraMovement::RIGHT, step);
+        lightManager.update(window, step);
+    });
+    simulation.reset();
+
+    // Simulation is advanced to the current time and camera and lights of the next frame are copied on this thread
+    auto beginFrame = [&]() -> FramePacket&
     {
-        shader.setVec3("dirLights[" + to_string(i) + "].color", dirLights[i].getColor());
-        shader.setVec3("dirLights[" + to_string(i) + "].direction", dirLights[i].getDirection());
-    }
-
-    // Setup spot lights
-    SpotLights::size_type spotLightsNumber = min(MAX_NUMBER_OF_SPOT_LIGHTS, spotLights.size());
-    shader.setInt("spotLightsNumber", spotLightsNumber);
-    for(SpotLights::size_type i = 0; i < spotLights.size(); ++i)
-    {        
-        shader.setVec3( "spotLights[" + to_string(i) + "].position", spotLights[i].getPosition());
-        shader.setVec3( "spotLights[" + to_string(i) + "].color", spotLights[i].getColor()); 
-        shader.setVec3( "spotLights[" + to_string(i) + "].direction", spotLights[i].getDirection());       
-        shader.setFloat("spotLights[" + to_string(i) + "].constant", spotLights[i].getConstant());
-        shader.setFloat("spotLights[" + to_string(i) + "].linear", spotLights[i].getLinear());
-        shader.setFloat("spotLights[" + to_string(i) + "].quadratic", spotLights[i].getQuadratic());
-        shader.setFloat("spotLights[" + to_string(i) + "].cutOff", glm::cos(spotLights[i].getCutOffInRadians()));
-        shader.setFloat("spotLights[" + to_string(i) + "].outerCutOff", glm::cos(spotLights[i].getOuterCutOffInRadians()));
-    }    
+        double time = glfwGetTime();
+        double inputTime = mouseLook.apply(camera, time);
+        simulation.update(time);
+        for (std::size_t i : simulation.getMovedObjects())
+            objectHierarchy.update(i, objects.getBoundingSphere(i));
+
+        FramePacket& packet = framePipeline.beginPacket();
+        packet.inputTime = inputTime;
+        packet.cameraPosition = camera.Position;
+        packet.fieldOfView = glm::radians(camera.Zoom);
+        packet.aspectRatio = (float)screenWidth / (float)screenHeight;
+        packet.projection = glm::perspective(packet.fieldOfView, packet.aspectRatio, NEAR_PLANE, FAR_PLANE);
+        packet.cullingProjection = lateLatching ?
+            glm::perspective(packet.fieldOfView * LATE_LATCH_CULLING_FOV_SCALE, packet.aspectRatio, NEAR_PLANE, FAR_PLANE) :
+            packet.projection;
+        packet.view = camera.GetViewMatrix();
+        packet.pointLightPositions.clear();
+        for (const PointLight& light : pointLights)
+            packet.pointLightPositions.push_back(light.getPosition());
+        packet.spotLightPositions.clear();
+        for (const SpotLight& light : spotLights)
+            packet.spotLightPositions.push_back(light.getPosition());
+
+        // depth of previous frames is reprojected to the new camera before jobs test objects against it
+        occlusionCuller.prepare(packet.projection * packet.view);
+        return packet;
+    };
+
+    // Culls objects and decides how visible ones are drawn, may run as a job
+    auto prepareFrame = [&](FramePacket& packet)
+    {
+        Frustum frustum(packet.cullingProjection * packet.view);
+        packet.visibleObjects.clear();
+        objectHierarchy.queryFrustum(frustum, packet.visibleObjects);
+        packet.draws.resize(packet.visibleObjects.size());
+        packet.depths.resize(packet.visibleObjects.size());
+        JobSystem::parallelFor(packet.visibleObjects.size(), VISIBLE_OBJECTS_PER_JOB, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t k = begin; k < end; ++k)
+            {
+                std::size_t i = packet.visibleObjects[k];
+                if (staticBatcher.isBatched(i) || instanceCuller.isInstanced(i) || occlusionCuller.isOccluded(objects.getBoundingSphere(i)))
+                    packet.draws[k] = FramePacket::DRAW_NOTHING;
+                // distant objects are batched and drawn as impostors
+                else if (impostors.isFar(objects, i, packet.cameraPosition))
+                    packet.draws[k] = FramePacket::DRAW_IMPOSTOR;
+                else
+                {
+                    objects.selectLod(i, packet.cameraPosition, packet.fieldOfView);
+                    packet.depths[k] = RenderQueue::getDepth(glm::vec3(objects.getBoundingSphere(i)), packet.cameraPosition, FAR_PLANE);
+                    packet.draws[k] = FramePacket::DRAW_MESHES;
+                }
+            }
+        });
+    };
 
     // Render loop    
     while (!glfwWindowShouldClose(window))
     {
-        // Per-frame time logic        
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        lightManager.updateDeltaTime(deltaTime);
+        for (const std::function<void()>& inputAction : inputActions)
+            inputAction();
+        inputActions.clear();
+
+        // Apply changes of scene files made since previous frame, the frame prepared ahead is culled again
+        std::vector<SceneDiff> sceneChanges = sceneReloader.takePendingChanges();
+        if (!sceneChanges.empty() || staticBatchesOutdated)
+            framePipeline.invalidate();
+        for (const SceneDiff& diff : sceneChanges)
+            sceneLoader.applyChanges(diff, dirLights, pointLights, spotLights, models, objects);
+        if (!sceneChanges.empty())
+        {
+            // models no longer used are released and their geometry ranges are freed
+            if (assets.unloadUnused() != 0)
+            {
+                impostors.releaseUnused();
+                GeometryArena::compactAll();
+            }
+            for (const shared_ptr<Model>& model : models)
+                impostors.bake(model);
+            objectHierarchy.build(objects);
+            occlusionCuller.invalidate();
+            staticBatchesOutdated = true;
+            lightManager.lightsChanged();
+            simulation.reset();
+            impostorShader.use();
+            setupLights(impostorShader);
+            shader.use();
+            setupLights(shader);
+            transparentShader.use();
+            setupLights(transparentShader);
+        }
+
+        // Batches hold copies of objects' geometry, so they are rebuilt after objects are changed
+        if (staticBatchesOutdated)
+        {
+            // models repeated often are instanced, batches merge the rest of static objects
+            instanceCuller.build(objects);
+            if (staticBatching)
+                staticBatcher.build(objects, instanceCuller);
+            else
+                staticBatcher.clear();
+            occlusionQueries.build(objects, staticBatcher, instanceCuller);
+            staticBatchesOutdated = false;
+        }
+
+        // Frames already queued by GPU bound how far ahead the next one is prepared
+        framePipeline.waitForGpu();
 
-        // Render        
+        // Render, viewport is changed only between frames        
+        glViewport(0, 0, screenWidth, screenHeight);
         glClearColor(0.1f, 0.1f, 0.2f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Culling of the frame was done during the previous one, unless the scene changed or pipelining is off
+        transparency.resize(screenWidth, screenHeight);
+        FramePacket* packet = framePipeline.takePacket();
+        if (!packet)
+        {
+            occlusionCuller.resize(screenWidth, screenHeight);
+            FramePacket& current = beginFrame();
+            framePipeline.prepareInPlace(prepareFrame);
+            packet = &current;
+        }
     
-        // Calculate view and projection matrix for current state and position of camera
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)screenWidth / (float)screenHeight, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();                  
-
-        // Set shader in use and bind view and projection matrices
-        shader.use();
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        shader.setVec3("cameraPos", camera.Position);
-
-        // Render objects
-        for (unsigned int i = 0; i < objects.size(); i++)
+        // View and projection matrices of the camera at the moment the packet was begun, the view may be turned before submission
+        const glm::mat4& projection = packet->projection;
+        const glm::mat4& view = packet->view;
+        const glm::vec3& cameraPosition = packet->cameraPosition;
+
+        // Per-frame uniforms are set for every program up front, so the queue switches programs only between draws
+        for (const Shader* program : { &shader, &transparentShader })
         {
-            glm::mat4 model = objects[i].getModelMatrix();                     
-            shader.setMat4("model", model);
+            program->use();
+            program->setVec3("cameraPos", cameraPosition);
 
-            // Fixes normals in case of non-uniform model scaling            
-            glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-            shader.setMat3("normalMatrix", normalMatrix);
+            // Update point lights positions
+            for (std::size_t i = 0; i < packet->pointLightPositions.size(); ++i)
+                program->setVec3("pointLights[" + to_string(i) + "].position", packet->pointLightPositions[i]);
 
-            objects[i].getModel()->Draw(shader);
-        }                
+            // Update spot lights positions
+            for (std::size_t i = 0; i < packet->spotLightPositions.size(); ++i)
+                program->setVec3("spotLights[" + to_string(i) + "].position", packet->spotLightPositions[i]);
+        }
 
-        // Update point lights positions
-        for (PointLights::size_type i = 0; i < pointLights.size(); ++i)                              
-            shader.setVec3("pointLights[" + to_string(i) + "].position", pointLights[i].getPosition());                            
+        MaterialLibrary::bind();
+
+        skyboxShader.use();
+        skyboxShader.setInt("skybox", SKYBOX_TEXTURE_INDEX);
 
-        // Update spot lights positions
-        for (SpotLights::size_type i = 0; i < spotLights.size(); ++i)        
-            shader.setVec3("spotLights[" + to_string(i) + "].position", spotLights[i].getPosition());            
-        
-        // Render lights on top of scene        
-        shaderLightBox.use();            
-        shaderLightBox.setMat4("projection", projection);
-        shaderLightBox.setMat4("view", view);
+        occlusionQueries.update();
+
+        // Queue static batches, then objects which aren't batched
+        renderQueue.setCamera(cameraPosition, FAR_PLANE);
+        Frustum frustum(packet->cullingProjection * view);
+        staticBatcher.submit(renderQueue, pbrProgram, transparentProgram, frustum, impostors, objects, cameraPosition);
+        glm::mat4 instanceProjection = glm::perspective(packet->fieldOfView * INSTANCE_CULLING_FOV_SCALE,
+                                                        packet->aspectRatio, NEAR_PLANE, FAR_PLANE);
+        instanceCuller.cull(instanceCullShader, Frustum(instanceProjection * view), cameraPosition, packet->fieldOfView);
+        instanceCuller.submit(renderQueue, pbrProgram, transparentProgram);
+        for (std::size_t k = 0; k < packet->visibleObjects.size(); ++k)
+        {
+            std::size_t i = packet->visibleObjects[k];
+            if (packet->draws[k] == FramePacket::DRAW_IMPOSTOR)
+                impostors.add(objects, i);
+            if (packet->draws[k] != FramePacket::DRAW_MESHES)
+                continue;
+
+            unsigned int transform = renderQueue.addTransform(objects.getModelMatrix(i));
+            float depth = packet->depths[k];
+            GLuint condition = occlusionQueries.getCondition(i);
+            for (const Mesh& mesh : objects.getModel(i).meshes)
+            {
+                if (MaterialLibrary::get(mesh.getMaterial()).isTransparent())
+                    renderQueue.submit(RenderQueue::PASS_TRANSPARENT, transparentProgram, depth, mesh, objects.getLod(i), transform, condition);
+                else
+                    renderQueue.submit(RenderQueue::PASS_OPAQUE, pbrProgram, depth, mesh, objects.getLod(i), transform, condition);
+            }
+        }                
 
-        for (unsigned int i = 0; i < pointLights.size(); ++i)
+        // Impostors of distant objects are drawn with one call behind nearer geometry
+        if (impostors.getBatchSize() != 0)
         {
-            glm::mat4 model = glm::mat4();
-            model = glm::translate(model, pointLights[i].getPosition());
-            model = glm::scale(model, glm::vec3(0.125f));
-            shaderLightBox.setMat4("model", model);
-            shaderLightBox.setVec3("lightColor", pointLights[i].getColor());
-            renderCube();
+            renderQueue.submit(RenderQueue::PASS_OPAQUE, impostorProgram, 1.0f,
+                [&](const Shader& program) { impostors.render(program, cameraPosition); });
         }
 
-        for (unsigned int i = 0; i < spotLights.size(); ++i)
+        // Lights are drawn as small boxes and pyramids, two instanced calls for all of them
+        lightGizmos.update(pointLights, spotLights);
+        if (lightGizmos.getInstanceCount() != 0)
         {
-            glm::mat4 model = glm::mat4();
-            model = glm::translate(model, spotLights[i].getPosition());
-            glm::quat rotation;
-            rotation = glm::rotation(glm::vec3(0.0f, -1.0f, 0.0f), glm::normalize(spotLights[i].getDirection()));
-            model *= glm::toMat4(rotation);
-            model = glm::scale(model, glm::vec3(0.25f));
-            shaderLightBox.setMat4("model", model);
-            shaderLightBox.setVec3("lightColor", spotLights[i].getColor());
-            renderPyramid();           
+            renderQueue.submit(RenderQueue::PASS_OPAQUE, lightBoxProgram, 0.0f,
+                [&lightGizmos](const Shader&) { lightGizmos.render(); });
         }
 
-        // Setup skybox shader and OpenGL for skybox rendering 
-        skyboxShader.use();
-        skyboxShader.setMat4("projection", projection);
-        skyboxShader.setMat4("view", glm::mat4(glm::mat3(camera.GetViewMatrix())));
-        skyboxShader.setInt("skybox", SKYBOX_TEXTURE_INDEX);
+        // Skybox is drawn after opaque geometry, so hidden pixels are rejected by depth test
+        renderQueue.submit(RenderQueue::PASS_SKY, skyboxProgram, 1.0f,
+            [cubemapTexture](const Shader&) { renderSkybox(cubemapTexture); });
 
-        // Render skybox
-        renderSkybox(cubemapTexture);
+        // Bounds of expensive objects are tested against the whole opaque depth, results are used by the next frame
+        renderQueue.submit(RenderQueue::PASS_SKY, queryProgram, 1.0f,
+            [&](const Shader& program) { occlusionQueries.issue(program, objects, frustum, cameraPosition); });
 
         // Input
-        processInput(window, lightManager);
+        processInput(window);
+
+        // Mouse moved while draws were queued turns the view, position stays the one objects were culled for
+        if (lateLatching)
+        {
+            glfwPollEvents();
+            double inputTime = mouseLook.apply(camera, glfwGetTime());
+            if (packet->inputTime < 0)
+                packet->inputTime = inputTime;
+            packet->view = glm::lookAt(cameraPosition, cameraPosition + camera.Front, camera.Up);
+        }
+        CameraBuffer::update(projection, view);
+
+        renderQueue.execute();
+
+        // Depth of this frame hides objects in the next ones
+        occlusionCuller.capture(hizShader, projection * view);
+
+        // Jobs cull the next frame while this one is presented. It is begun only after deferred draws have read
+        // objects and depth of this frame was captured, since simulation moves objects and culler counts frames.
+        if (framePipeline.isEnabled())
+        {
+            occlusionCuller.resize(screenWidth, screenHeight);
+            beginFrame();
+            framePipeline.prepareAhead(prepareFrame);
+        }
 
-        // GLFW: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // GLFW: swap buffers and poll IO events (keys pressed/released, mouse moved etc.), unless they were polled before submission
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (packet->inputTime >= 0)
+            mouseLook.measure(packet->inputTime, glfwGetTime());
+        if (!lateLatching)
+            glfwPollEvents();
+        framePipeline.endFrame();
     }
 
+    framePipeline.release();
+
+    CameraBuffer::release();
+
+    occlusionCuller.release();
+    occlusionQueries.release();
+    instanceCuller.release();
+    Primitives::release();
+    JobSystem::stop();
     glfwTerminate();
     return 0;
 }
 
-unsigned int skyboxVAO = 0;
-unsigned int skyboxVBO = 0;
 void renderSkybox(unsigned int cubemapTexture){
-    if (skyboxVAO == 0)
-    {
-        float vertices[] = {
-            // positions          
-            -1.0f,  1.0f, -1.0f,
-            -1.0f, -1.0f, -1.0f,
-             1.0f, -1.0f, -1.0f,
-             1.0f, -1.0f, -1.0f,
-             1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f, -1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-             1.0f, -1.0f, -1.0f,
-             1.0f, -1.0f,  1.0f,
-             1.0f,  1.0f,  1.0f,
-             1.0f,  1.0f,  1.0f,
-             1.0f,  1.0f, -1.0f,
-             1.0f, -1.0f, -1.0f,
-
-            -1.0f, -1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-             1.0f,  1.0f,  1.0f,
-             1.0f,  1.0f,  1.0f,
-             1.0f, -1.0f,  1.0f,
-            -1.0f, -1.0f,  1.0f,
-
-            -1.0f,  1.0f, -1.0f,
-             1.0f,  1.0f, -1.0f,
-             1.0f,  1.0f,  1.0f,
-             1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f,  1.0f,
-            -1.0f,  1.0f, -1.0f,
-
-            -1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-             1.0f, -1.0f, -1.0f,
-             1.0f, -1.0f, -1.0f,
-            -1.0f, -1.0f,  1.0f,
-             1.0f, -1.0f,  1.0f
-        };
-
-        glGenVertexArrays(1, &skyboxVAO);
-        glGenBuffers(1, &skyboxVBO);
-        glBindVertexArray(skyboxVAO);
-        // fill buffer
-        glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
-        // link vertex attributes
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);   
-        // set to defaults     
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-    }
     glDepthFunc(GL_LEQUAL); // For rendering skybox behind all other objects in scene
-    glBindVertexArray(skyboxVAO);
     glActiveTexture(GL_TEXTURE0 + SKYBOX_TEXTURE_INDEX);
     glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    Primitives::draw(Primitives::SKYBOX);
     glDepthFunc(GL_LESS);// glDepthMask(GL_TRUE);
-    glBindVertexArray(0);
-}
-
-// renderCube() renders a 1x1 3D cube in NDC.
-// -------------------------------------------------
-unsigned int cubeVAO = 0;
-unsigned int cubeVBO = 0;
-void renderCube()
-{
-    // initialize (if necessary)
-    if (cubeVAO == 0)
-    {        
-        float vertices[] = {
-            // back face
-            -1.0f, -1.0f, -1.0f,   // bottom-left
-            1.0f,  1.0f, -1.0f,   // top-right
-            1.0f, -1.0f, -1.0f,   // bottom-right         
-            1.0f,  1.0f, -1.0f,   // top-right
-            -1.0f, -1.0f, -1.0f,  // bottom-left
-            -1.0f,  1.0f, -1.0f,   // top-left
-           // front face
-           -1.0f, -1.0f,  1.0f,  // bottom-left
-           1.0f, -1.0f,  1.0f,   // bottom-right
-           1.0f,  1.0f,  1.0f,   // top-right
-           1.0f,  1.0f,  1.0f,  // top-right
-           -1.0f,  1.0f,  1.0f,   // top-left
-           -1.0f, -1.0f,  1.0f,   // bottom-left
-            // left face
-            -1.0f,  1.0f,  1.0f,  // top-right
-            -1.0f,  1.0f, -1.0f,  // top-left
-            -1.0f, -1.0f, -1.0f,  // bottom-left
-            -1.0f, -1.0f, -1.0f,  // bottom-left
-            -1.0f, -1.0f,  1.0f,  // bottom-right
-            -1.0f,  1.0f,  1.0f,  // top-right
-            // right face
-            1.0f,  1.0f,  1.0f,   // top-left
-            1.0f, -1.0f, -1.0f,   // bottom-right
-            1.0f,  1.0f, -1.0f,   // top-right         
-            1.0f, -1.0f, -1.0f,   // bottom-right
-            1.0f,  1.0f,  1.0f,   // top-left
-            1.0f, -1.0f,  1.0f,   // bottom-left     
-             // bottom face
-            -1.0f, -1.0f, -1.0f,  // top-right
-            1.0f, -1.0f, -1.0f,  // top-left
-            1.0f, -1.0f,  1.0f,   // bottom-left
-            1.0f, -1.0f,  1.0f,   // bottom-left
-            -1.0f, -1.0f,  1.0f,   // bottom-right
-            -1.0f, -1.0f, -1.0f,   // top-right
-             // top face
-             -1.0f,  1.0f, -1.0f, // top-left
-             1.0f,  1.0f , 1.0f,   // bottom-right
-             1.0f,  1.0f, -1.0f,  // top-right     
-             1.0f,  1.0f,  1.0f,  // bottom-right
-             -1.0f,  1.0f, -1.0f, // top-left
-             -1.0f,  1.0f,  1.0f,  // bottom-left                                                                         
-        };
-        glGenVertexArrays(1, &cubeVAO);
-        glGenBuffers(1, &cubeVBO);
-        glBindVertexArray(cubeVAO);
-        // fill buffer
-        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
-        // link vertex attributes        
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);  
-
-        // set to defaults      
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
-    }
-    // render Cube
-    glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-    glBindVertexArray(0);
-}
-
-unsigned int pyramidVAO = 0;
-unsigned int pyramidVBO = 0;
-
-void renderPyramid()
-{
-    if (pyramidVAO == 0)
-    {
-        float vertices[] =
-        {
-            //front face
-             0.5f, -0.5f,  0.5f,//2
-             0.0f,  0.5f,  0.0f,//5
-            -0.5f, -0.5f,  0.5f,//1              
-            //rigth face
-             0.5f, -0.5f, -0.5f,//3
-             0.0f,  0.5f,  0.0f,//5
-             0.5f, -0.5f,  0.5f,
-            //left face
-            -0.5f, -0.5f,  0.5f,
-             0.0f,  0.5f,  0.0f,
-            -0.5f, -0.5f, -0.5f,//4
-            //back face
-            -0.5f, -0.5f, -0.5f,
-             0.0f,  0.5f,  0.0f,
-             0.5f, -0.5f, -0.5f,
-            //bottom face
-             0.5f, -0.5f, -0.5f,
-             0.5f, -0.5f,  0.5f,
-            -0.5f, -0.5f,  0.5f,
-            
-             0.5f, -0.5f, -0.5f,
-            -0.5f, -0.5f,  0.5f,
-            -0.5f, -0.5f, -0.5f,
-        };
-
-        glGenVertexArrays(1, &pyramidVAO);
-        glGenBuffers(1, &pyramidVBO);
-        glBindVertexArray(pyramidVAO);
-        // fill buffer
-        glBindBuffer(GL_ARRAY_BUFFER, pyramidVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);        
-    }
-    glBindVertexArray(pyramidVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 18);
-    glBindVertexArray(0);
-}
-
-
-// renderQuad() renders a 1x1 XY quad in NDC
-// -----------------------------------------
-unsigned int quadVAO = 0;
-unsigned int quadVBO;
-void renderQuad()
-{
-    if (quadVAO == 0)
-    {
-        float quadVertices[] = {
-            // positions        // texture Coords
-            -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-            1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-            1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-        };
-        // setup plane VAO
-        glGenVertexArrays(1, &quadVAO);
-        glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    }
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow *window, LightManager& lightManager)
+void processInput(GLFWwindow *window)
 {
     //glfwSetInputMode(window, GLFW_STICKY_KEYS, 1);
 
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
-    // camera control
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(CameraMovement::RIGHT, deltaTime);      
+    // camera and lights are moved by simulation steps
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    // make sure the viewport matches the new window dimensions; note that width and 
+    // viewport is set to the new window dimensions at the start of the next frame; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
     screenWidth = width;
     screenHeight = height;
 }
@@ -538,18 +611,129 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     lastX = xpos;
     lastY = ypos;
 
-    camera.ProcessMouseMovement(xoffset, yoffset);
+    mouseLook.move(xoffset, yoffset, glfwGetTime());
+}
+
+// glfw: left click casts a ray from camera through the cursor, which is captured in the center of the screen
+// ------------------------------------------------------------------------------------------------------------
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if ((button != GLFW_MOUSE_BUTTON_LEFT && button != GLFW_MOUSE_BUTTON_RIGHT) || action != GLFW_PRESS)
+        return;
+    bool spin = button == GLFW_MOUSE_BUTTON_RIGHT;
+    inputActions.push_back([spin]() { pickObject(spin); });
+}
+
+// Prints object under cursor, right click starts or stops its spinning
+void pickObject(bool spin)
+{
+    BoundingVolumeHierarchy::RayHit hit;
+    if (!objectHierarchy.raycast(camera.Position, glm::normalize(camera.Front), FAR_PLANE, hit))
+    {
+        std::cout << "PICKING:: nothing" << std::endl;
+        return;
+    }
+    std::cout << "PICKING:: object " << hit.object << " (" << objects.getModel(hit.object).getPath() << "), distance: " << hit.distance << std::endl;
+
+    // spinning object is drawn separately from batches and instances until batches are rebuilt with it again
+    if (spin)
+    {
+        ObjectId id = objects.getId(hit.object);
+        if (!simulation.removeObjectSpin(id))
+            simulation.addObjectSpin(id, OBJECT_SPIN_SPEED);
+        objects.setStatic(hit.object, false);
+        staticBatchesOutdated = true;
+    }
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    camera.ProcessMouseScroll(yoffset);
+    inputActions.push_back([yoffset]() { camera.ProcessMouseScroll(yoffset); });
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+    // save current state of the scene, including lights moved by user
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+    {
+        if (!SceneSnapshot::save(SNAPSHOT_PATH, dirLights, pointLights, spotLights, objects))
+            std::cout << "ERROR::SCENE_SNAPSHOT::FAILED_TO_SAVE path: " << SNAPSHOT_PATH << std::endl;
+    }
+
+    if (key == GLFW_KEY_F7 && action == GLFW_PRESS)
+    {
+        renderQueue.printStatistics();
+        occlusionCuller.printStatistics();
+        occlusionQueries.printStatistics();
+        instanceCuller.printStatistics();
+        JobSystem::printStatistics();
+        framePipeline.printStatistics();
+        simulation.printStatistics();
+        mouseLook.printStatistics();
+    }
+
+    // switch low latency mode, frame prepared ahead is culled again with field of view of the new mode
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+    {
+        framePipeline.invalidate();
+        lateLatching = !lateLatching;
+        std::cout << "MOUSE_LOOK:: late latching: " << (lateLatching ? "on" : "off") << std::endl;
+    }
+
+    if (key == GLFW_KEY_M && action == GLFW_PRESS)
+        mouseLook.setSmoothing(!mouseLook.isSmoothing());
+
+    // switch occlusion culling, depth captured before it was disabled is outdated
+    if (key == GLFW_KEY_F8 && action == GLFW_PRESS)
+    {
+        // the frame being prepared tests objects against the old depth
+        framePipeline.invalidate();
+        occlusionCuller.setEnabled(!occlusionCuller.isEnabled());
+        occlusionCuller.invalidate();
+        occlusionCuller.printStatistics();
+    }
+
+    // switch occlusion queries, objects are drawn unconditionally until new results arrive
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS)
+    {
+        occlusionQueries.setEnabled(!occlusionQueries.isEnabled());
+        occlusionQueries.printStatistics();
+    }
+
+    // switch preparation of the next frame during submission of the current one
+    if (key == GLFW_KEY_F10 && action == GLFW_PRESS)
+    {
+        framePipeline.setEnabled(!framePipeline.isEnabled());
+        framePipeline.printStatistics();
+    }
+
+    // start or stop orbits of point lights around their current positions
+    if (key == GLFW_KEY_F11 && action == GLFW_PRESS)
+    {
+        inputActions.push_back([]()
+        {
+            if (simulation.hasLightOrbits())
+                simulation.clearLightOrbits();
+            else
+            {
+                for (std::size_t i = 0; i < pointLights.size(); ++i)
+                {
+                    glm::vec3 center = pointLights[i].getPosition() - glm::vec3(LIGHT_ORBIT_RADIUS, 0.0f, 0.0f);
+                    simulation.addLightOrbit(false, i, center, LIGHT_ORBIT_RADIUS, LIGHT_ORBIT_SPEED);
+                }
+            }
+        });
+    }
+
+    // switch between static batches and separate draws of every object
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+    {
+        staticBatching = !staticBatching;
+        staticBatchesOutdated = true;
+    }
+
     void* obj = glfwGetWindowUserPointer(window);
     LightManager* lightManager = static_cast<LightManager*>(obj);
     if (lightManager)            
@@ -586,4 +770,56 @@ unsigned int loadCubemap(vector<std::string> faces)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
     return textureID;
-}  
\ No newline at end of file
+}
+
+bool isSnapshotUpToDate()
+{
+    std::error_code error;
+    auto snapshotTime = std::filesystem::last_write_time(SNAPSHOT_PATH, error);
+    if (error)
+        return false;
+
+    return snapshotTime >= std::filesystem::last_write_time(LIGHTS_DATA_PATH, error) && !error &&
+           snapshotTime >= std::filesystem::last_write_time(MODELS_DATA_PATH, error) && !error;
+}
+
+// Uploads parameters of all lights to the shader, shader must be in use
+// ---------------------------------------------------------------------
+void setupLights(const Shader& shader)
+{
+    // Setup point lights
+    PointLights::size_type pointLightsNumber = min(MAX_NUMBER_OF_POINT_LIGHTS, pointLights.size());   
+    shader.setInt("pointLightsNumber", pointLightsNumber);   
+    for (PointLights::size_type i = 0; i < pointLights.size(); ++i)
+    {
+        shader.setVec3( "pointLights[" + to_string(i) + "].position", pointLights[i].getPosition());
+        shader.setVec3( "pointLights[" + to_string(i) + "].color", pointLights[i].getColor());        
+        shader.setFloat("pointLights[" + to_string(i) + "].constant", pointLights[i].getConstant());
+        shader.setFloat("pointLights[" + to_string(i) + "].linear", pointLights[i].getLinear());
+        shader.setFloat("pointLights[" + to_string(i) + "].quadratic", pointLights[i].getQuadratic());
+    }    
+    
+    // Setup directional lights
+    DirectionalLights::size_type dirLightsNumber = min(MAX_NUMBER_OF_DIRECTIONAL_LIGHTS, dirLights.size());
+    shader.setInt("dirLightsNumber", dirLightsNumber);
+    for (DirectionalLights::size_type i = 0; i < dirLights.size(); ++i)
+    {
+        shader.setVec3("dirLights[" + to_string(i) + "].color", dirLights[i].getColor());
+        shader.setVec3("dirLights[" + to_string(i) + "].direction", dirLights[i].getDirection());
+    }
+
+    // Setup spot lights
+    SpotLights::size_type spotLightsNumber = min(MAX_NUMBER_OF_SPOT_LIGHTS, spotLights.size());
+    shader.setInt("spotLightsNumber", spotLightsNumber);
+    for(SpotLights::size_type i = 0; i < spotLights.size(); ++i)
+    {        
+        shader.setVec3( "spotLights[" + to_string(i) + "].position", spotLights[i].getPosition());
+        shader.setVec3( "spotLights[" + to_string(i) + "].color", spotLights[i].getColor()); 
+        shader.setVec3( "spotLights[" + to_string(i) + "].direction", spotLights[i].getDirection());       
+        shader.setFloat("spotLights[" + to_string(i) + "].constant", spotLights[i].getConstant());
+        shader.setFloat("spotLights[" + to_string(i) + "].linear", spotLights[i].getLinear());
+        shader.setFloat("spotLights[" + to_string(i) + "].quadratic", spotLights[i].getQuadratic());
+        shader.setFloat("spotLights[" + to_string(i) + "].cutOff", glm::cos(spotLights[i].getCutOffInRadians()));
+        shader.setFloat("spotLights[" + to_string(i) + "].outerCutOff", glm::cos(spotLights[i].getOuterCutOffInRadians()));
+    }
+}